@@ -1,4 +1,18 @@
 ﻿#include "MathSIMD.h"
+#include "MathSIMDInstrument.h"
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <bitset>
+#include <sstream>
+#include <thread>
+#include <limits>
+#if defined(__linux__)
+#include <filesystem>
+#endif
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
 
 using namespace King;
 using namespace std;
@@ -60,6 +74,289 @@ void King::from_json(const json& j, FloatPoint3& to) { j.at("x").get_to(to.f[0])
 void King::from_json(const json& j, FloatPoint4& to) { j.at("x").get_to(to.f[0]); j.at("y").get_to(to.f[1]); j.at("z").get_to(to.f[2]); j.at("w").get_to(to.f[3]); }
 void King::from_json(const json& j, Quaternion& to) { j.at("x").get_to(to.f[0]); j.at("y").get_to(to.f[1]); j.at("z").get_to(to.f[2]); j.at("w").get_to(to.f[3]); }
 
+/******************************************************************************
+*   Determinism
+******************************************************************************/
+uint64_t King::HashBits(const void* bytesIn, size_t size, uint64_t hash)
+{
+    assert(bytesIn || !size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(bytesIn);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+uint64_t King::Hash(const FloatPoint2* in, size_t count, uint64_t hash) { for (size_t i = 0; i < count; ++i) hash = HashBits(in[i].f, 2 * sizeof(float), hash); return hash; }
+uint64_t King::Hash(const FloatPoint3* in, size_t count, uint64_t hash) { for (size_t i = 0; i < count; ++i) hash = HashBits(in[i].f, 3 * sizeof(float), hash); return hash; }
+uint64_t King::Hash(const FloatPoint4* in, size_t count, uint64_t hash) { for (size_t i = 0; i < count; ++i) hash = HashBits(in[i].f, 4 * sizeof(float), hash); return hash; }
+uint64_t King::Hash(const Quaternion* in, size_t count, uint64_t hash) { for (size_t i = 0; i < count; ++i) hash = HashBits(in[i].f, 4 * sizeof(float), hash); return hash; }
+
+namespace
+{
+    // fixed inputs of the golden hashes, 24 bit integers scaled by a power of two so every platform converts them exactly
+    inline float GoldenInput(uint64_t& state, const float scale)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<float>(static_cast<int32_t>(state >> 40) - (1 << 23)) * scale;
+    }
+    const size_t GoldenCount = 64;
+    // SSE2 results of KING_MATH_DETERMINISTIC builds; recompute only when one of the kernels changes on purpose
+    const uint64_t GoldenNormalize = 0x71fe408f7d6f2abfull;
+    const uint64_t GoldenMagnitude = 0x733404222eb051f6ull;
+    const uint64_t GoldenRecipSqrt = 0x807c0f8ae158fa8aull;
+    const uint64_t GoldenAverage = 0xc8b7d1d382547ac1ull;
+    const uint64_t GoldenSumComponents = 0x2f58796001e2c00aull;
+}
+
+bool King::DeterminismSelfTest(std::vector<std::string>* failuresOut)
+{
+    uint64_t state = 1;
+    std::vector<float3> points(GoldenCount);
+    std::vector<float4> positives(GoldenCount);
+    std::vector<float4> mixed(GoldenCount); // magnitudes 2^-12 to 2^12 so the order of the adds shows in the sum
+    for (size_t i = 0; i < GoldenCount; ++i)
+    {
+        const float x = GoldenInput(state, 1.0f / 4096.0f);
+        const float y = GoldenInput(state, 1.0f / 4096.0f);
+        const float z = GoldenInput(state, 1.0f / 4096.0f);
+        points[i] = float3(x, y, z);
+        positives[i] = float4(std::fabs(x) + 1.0f, std::fabs(y) + 1.0f, std::fabs(z) + 1.0f, std::fabs(x - y) + 1.0f);
+        mixed[i] = float4(GoldenInput(state, 1.0f), GoldenInput(state, 1.0f / 16777216.0f), GoldenInput(state, 1.0f / 4096.0f), GoldenInput(state, 1.0f));
+    }
+
+    std::vector<float3> normalized(points);
+    for (auto& each : normalized)
+        each.Normalize();
+    std::vector<float> magnitudes, sums;
+    for (const auto& each : points)
+        magnitudes.push_back(each.GetMagnitudeEst());
+    for (const auto& each : mixed)
+        sums.push_back(float4::SumComponents(each));
+    std::vector<float4> recipSqrt;
+    for (const auto& each : positives)
+        recipSqrt.push_back(RecipSqrt(each));
+    const float3 average = float3::Average(points);
+
+    struct Case
+    {
+        const char*                             name;
+        uint64_t                                expected;
+        uint64_t                                actual;
+    };
+    const Case cases[] =
+    {
+        { "Normalize", GoldenNormalize, Hash(normalized) },
+        { "GetMagnitudeEst", GoldenMagnitude, HashBits(magnitudes.data(), magnitudes.size() * sizeof(float)) },
+        { "RecipSqrt", GoldenRecipSqrt, Hash(recipSqrt) },
+        { "Average", GoldenAverage, Hash(&average, 1) },
+        { "SumComponents", GoldenSumComponents, HashBits(sums.data(), sums.size() * sizeof(float)) },
+    };
+    bool passed = true;
+    for (const auto& each : cases)
+    {
+        if (each.expected == each.actual)
+            continue;
+        passed = false;
+        if (failuresOut)
+            failuresOut->push_back(each.name);
+    }
+    return passed;
+}
+
+/******************************************************************************
+*   Batch helpers
+*       Arrays are processed four elements at a time by transposing four
+*       vectors into one XMVECTOR per component (x's, y's, z's and w's)
+******************************************************************************/
+namespace
+{
+    // forward counts as parallel to up when |up x forward|² <= |up|² * this (sin² of the angle, forward unit length);
+    // shared by the scalar and batch look rotations so both fall back to the same basis
+    const float LookParallelSinSq = 1.0e-12f;
+
+    // load elements [index, index + 4) as rows and transpose, rows past count are filled with pad
+    template<class T>
+    inline DirectX::XMMATRIX __vectorcall LoadTransposed4(const T* in, size_t index, size_t count, DirectX::FXMVECTOR pad)
+    {
+        DirectX::XMMATRIX m;
+        for (size_t j = 0; j < 4; ++j)
+            m.r[j] = (index + j < count) ? in[index + j].GetVecConst() : pad;
+        return DirectX::XMMatrixTranspose(m);
+    }
+    // transpose back to rows and store the elements of [index, index + 4) within count
+    template<class T>
+    inline void __vectorcall StoreTransposed4(T* out, size_t index, size_t count, DirectX::FXMMATRIX soa)
+    {
+        auto m = DirectX::XMMatrixTranspose(soa);
+        for (size_t j = 0; j < 4 && index + j < count; ++j)
+            out[index + j] = m.r[j];
+    }
+    // same product as XMQuaternionMultiply(q1, q2) (rotation q1 followed by q2) on transposed quaternions
+    inline DirectX::XMMATRIX __vectorcall QuaternionMultiplyTransposed(DirectX::FXMMATRIX q1, DirectX::CXMMATRIX q2)
+    {
+        using namespace DirectX;
+        const XMVECTOR &ax = q2.r[0], &ay = q2.r[1], &az = q2.r[2], &aw = q2.r[3];
+        const XMVECTOR &bx = q1.r[0], &by = q1.r[1], &bz = q1.r[2], &bw = q1.r[3];
+        XMMATRIX r;
+        r.r[0] = XMVectorMultiplyAdd(aw, bx, XMVectorMultiplyAdd(ax, bw, XMVectorNegativeMultiplySubtract(az, by, XMVectorMultiply(ay, bz))));
+        r.r[1] = XMVectorMultiplyAdd(aw, by, XMVectorMultiplyAdd(ay, bw, XMVectorNegativeMultiplySubtract(ax, bz, XMVectorMultiply(az, bx))));
+        r.r[2] = XMVectorMultiplyAdd(aw, bz, XMVectorMultiplyAdd(az, bw, XMVectorNegativeMultiplySubtract(ay, bx, XMVectorMultiply(ax, by))));
+        r.r[3] = XMVectorNegativeMultiplySubtract(az, bz, XMVectorNegativeMultiplySubtract(ay, by, XMVectorNegativeMultiplySubtract(ax, bx, XMVectorMultiply(aw, bw))));
+        return r;
+    }
+    inline DirectX::XMVECTOR __vectorcall LengthSq3Transposed(DirectX::FXMMATRIX m) { using namespace DirectX; return XMVectorMultiplyAdd(m.r[0], m.r[0], XMVectorMultiplyAdd(m.r[1], m.r[1], XMVectorMultiply(m.r[2], m.r[2]))); }
+    inline DirectX::XMVECTOR __vectorcall LengthSq4Transposed(DirectX::FXMMATRIX m) { using namespace DirectX; return XMVectorMultiplyAdd(m.r[3], m.r[3], LengthSq3Transposed(m)); }
+    // θ / sin(θ) for θ = atan2(sin, cos) given sin², series expansion near θ = 0 and zero when sin(θ) vanishes at θ = π
+    inline DirectX::XMVECTOR __vectorcall AngleOverSin(DirectX::FXMVECTOR sinSq, DirectX::FXMVECTOR cos)
+    {
+        using namespace DirectX;
+        const XMVECTOR sin = XMVectorSqrt(sinSq);
+        const XMVECTOR ratio = XMVectorDivide(XMVectorATan2(sin, cos), sin);
+        const XMVECTOR invCos = XMVectorReciprocal(cos);
+        const XMVECTOR series = XMVectorMultiply(invCos, XMVectorNegativeMultiplySubtract(XMVectorMultiply(sinSq, XMVectorMultiply(invCos, invCos)), XMVectorReplicate(1.0f / 3.0f), XMVectorSplatOne()));
+        const XMVECTOR nearZero = XMVectorLess(sinSq, XMVectorReplicate(1.0e-12f));
+        return XMVectorSelect(ratio, XMVectorSelect(XMVectorZero(), series, XMVectorGreater(cos, XMVectorZero())), nearZero);
+    }
+    // sin(θ) / θ and cos(θ) given θ², series expansion near θ = 0
+    inline DirectX::XMVECTOR __vectorcall SinOverAngle(DirectX::FXMVECTOR angleSq, DirectX::XMVECTOR* cosOut)
+    {
+        using namespace DirectX;
+        const XMVECTOR angle = XMVectorSqrt(angleSq);
+        XMVECTOR sin;
+        XMVectorSinCos(&sin, cosOut, angle);
+        const XMVECTOR series = XMVectorNegativeMultiplySubtract(angleSq, XMVectorReplicate(1.0f / 6.0f), XMVectorSplatOne());
+        return XMVectorSelect(XMVectorDivide(sin, angle), series, XMVectorLess(angleSq, XMVectorReplicate(1.0e-12f)));
+    }
+    // exp(q) = e^w * (cos|xyz|, sin|xyz| * xyz / |xyz|) on transposed quaternions
+    inline DirectX::XMMATRIX __vectorcall QuaternionExpTransposed(DirectX::FXMMATRIX q)
+    {
+        using namespace DirectX;
+        XMVECTOR cos;
+        const XMVECTOR ew = XMVectorExpE(q.r[3]);
+        const XMVECTOR s = XMVectorMultiply(SinOverAngle(LengthSq3Transposed(q), &cos), ew);
+        XMMATRIX r;
+        r.r[0] = XMVectorMultiply(q.r[0], s);
+        r.r[1] = XMVectorMultiply(q.r[1], s);
+        r.r[2] = XMVectorMultiply(q.r[2], s);
+        r.r[3] = XMVectorMultiply(cos, ew);
+        return r;
+    }
+    // log(q) = (θ * xyz / |xyz|, ln|q|) with θ = atan2(|xyz|, w) on transposed quaternions, zero for a zero quaternion
+    // as Quaternion::Log()
+    inline DirectX::XMMATRIX __vectorcall QuaternionLogTransposed(DirectX::FXMMATRIX q)
+    {
+        using namespace DirectX;
+        const XMVECTOR lengthSq = LengthSq4Transposed(q);
+        const XMVECTOR isZero = XMVectorLessOrEqual(lengthSq, XMVectorZero());
+        const XMVECTOR invLength = XMVectorReciprocalSqrt(lengthSq);
+        const XMVECTOR sinSq = XMVectorMultiply(LengthSq3Transposed(q), XMVectorMultiply(invLength, invLength));
+        const XMVECTOR s = XMVectorSelect(XMVectorMultiply(AngleOverSin(sinSq, XMVectorMultiply(q.r[3], invLength)), invLength), XMVectorZero(), isZero);
+        XMMATRIX r;
+        r.r[0] = XMVectorMultiply(q.r[0], s);
+        r.r[1] = XMVectorMultiply(q.r[1], s);
+        r.r[2] = XMVectorMultiply(q.r[2], s);
+        r.r[3] = XMVectorSelect(XMVectorMultiply(XMVectorLogE(lengthSq), XMVectorReplicate(0.5f)), XMVectorZero(), isZero);
+        return r;
+    }
+    inline DirectX::XMMATRIX __vectorcall QuaternionNormalizeTransposed(DirectX::FXMMATRIX q)
+    {
+        using namespace DirectX;
+        const XMVECTOR invLength = XMVectorReciprocalSqrt(LengthSq4Transposed(q));
+        return XMMATRIX(XMVectorMultiply(q.r[0], invLength), XMVectorMultiply(q.r[1], invLength), XMVectorMultiply(q.r[2], invLength), XMVectorMultiply(q.r[3], invLength));
+    }
+    inline DirectX::XMVECTOR __vectorcall Dot3Transposed(DirectX::FXMMATRIX a, DirectX::CXMMATRIX b) { using namespace DirectX; return XMVectorMultiplyAdd(a.r[0], b.r[0], XMVectorMultiplyAdd(a.r[1], b.r[1], XMVectorMultiply(a.r[2], b.r[2]))); }
+    // a x b as XMVector3Cross, w row is zero
+    inline DirectX::XMMATRIX __vectorcall Cross3Transposed(DirectX::FXMMATRIX a, DirectX::CXMMATRIX b)
+    {
+        using namespace DirectX;
+        return XMMATRIX(XMVectorNegativeMultiplySubtract(a.r[2], b.r[1], XMVectorMultiply(a.r[1], b.r[2])),
+                        XMVectorNegativeMultiplySubtract(a.r[0], b.r[2], XMVectorMultiply(a.r[2], b.r[0])),
+                        XMVectorNegativeMultiplySubtract(a.r[1], b.r[0], XMVectorMultiply(a.r[0], b.r[1])),
+                        XMVectorZero());
+    }
+    // zero length lanes stay zero as XMVector3Normalize
+    inline DirectX::XMMATRIX __vectorcall Normalize3Transposed(DirectX::FXMMATRIX a)
+    {
+        using namespace DirectX;
+        const XMVECTOR lengthSq = LengthSq3Transposed(a);
+        const XMVECTOR invLength = XMVectorSelect(XMVectorReciprocalSqrt(lengthSq), XMVectorZero(), XMVectorLessOrEqual(lengthSq, XMVectorZero()));
+        return XMMATRIX(XMVectorMultiply(a.r[0], invLength), XMVectorMultiply(a.r[1], invLength), XMVectorMultiply(a.r[2], invLength), XMVectorZero());
+    }
+    // tangent and bitangent of unit normals, Duff et al. 2017 "Building an Orthonormal Basis, Revisited"
+    inline void __vectorcall OrthonormalBasisTransposed(DirectX::FXMMATRIX n, DirectX::XMMATRIX* tangentOut, DirectX::XMMATRIX* bitangentOut)
+    {
+        using namespace DirectX;
+        const XMVECTOR &nx = n.r[0], &ny = n.r[1], &nz = n.r[2];
+        const XMVECTOR sign = XMVectorOrInt(XMVectorAndInt(nz, g_XMNegativeZero), XMVectorSplatOne()); // copysign(1, z)
+        const XMVECTOR a = XMVectorNegate(XMVectorReciprocal(XMVectorAdd(sign, nz)));
+        const XMVECTOR b = XMVectorMultiply(XMVectorMultiply(nx, ny), a);
+        const XMVECTOR signNx = XMVectorMultiply(sign, nx);
+        *tangentOut = XMMATRIX(XMVectorMultiplyAdd(XMVectorMultiply(signNx, nx), a, XMVectorSplatOne()), XMVectorMultiply(sign, b), XMVectorNegate(signNx), XMVectorZero());
+        *bitangentOut = XMMATRIX(b, XMVectorMultiplyAdd(XMVectorMultiply(ny, ny), a, sign), XMVectorNegate(ny), XMVectorZero());
+    }
+    // right, up and forward rows of the rotation that turns +z to forward with up kept in the yz plane,
+    // same basis as XMMatrixLookToLH before it is inverted, forward parallel to up falls back to any basis
+    inline void __vectorcall LookRotationTransposed(DirectX::FXMMATRIX forward, DirectX::CXMMATRIX up, DirectX::XMMATRIX* xOut, DirectX::XMMATRIX* yOut, DirectX::XMMATRIX* zOut)
+    {
+        using namespace DirectX;
+        const XMMATRIX z = Normalize3Transposed(forward);
+        const XMMATRIX right = Cross3Transposed(up, z);
+        const XMVECTOR parallel = XMVectorLessOrEqual(LengthSq3Transposed(right), XMVectorMultiply(LengthSq3Transposed(up), XMVectorReplicate(LookParallelSinSq)));
+        XMMATRIX tangent, bitangent;
+        OrthonormalBasisTransposed(z, &tangent, &bitangent);
+        XMMATRIX x = Normalize3Transposed(right);
+        x.r[0] = XMVectorSelect(x.r[0], tangent.r[0], parallel);
+        x.r[1] = XMVectorSelect(x.r[1], tangent.r[1], parallel);
+        x.r[2] = XMVectorSelect(x.r[2], tangent.r[2], parallel);
+        *xOut = x;
+        *yOut = Cross3Transposed(z, x);
+        *zOut = z;
+    }
+    // quaternion of the rotation matrix with rows x, y, z as XMQuaternionRotationMatrix, every case of the
+    // largest diagonal term is evaluated and the best conditioned one is selected per lane
+    inline DirectX::XMMATRIX __vectorcall QuaternionFromRowsTransposed(DirectX::FXMMATRIX x, DirectX::CXMMATRIX y, DirectX::CXMMATRIX z)
+    {
+        using namespace DirectX;
+        const XMVECTOR one = XMVectorSplatOne();
+        const XMVECTOR half = XMVectorReplicate(0.5f);
+        const XMVECTOR &xx = x.r[0], &xy = x.r[1], &xz = x.r[2];
+        const XMVECTOR &yx = y.r[0], &yy = y.r[1], &yz = y.r[2];
+        const XMVECTOR &zx = z.r[0], &zy = z.r[1], &zz = z.r[2];
+        // 4w², 4x², 4y², 4z², s = 2|c| of the chosen component c and the others are (sum or difference) / 2s
+        const XMVECTOR tw = XMVectorAdd(one, XMVectorAdd(xx, XMVectorAdd(yy, zz)));
+        const XMVECTOR tx = XMVectorAdd(one, XMVectorSubtract(xx, XMVectorAdd(yy, zz)));
+        const XMVECTOR ty = XMVectorAdd(one, XMVectorSubtract(yy, XMVectorAdd(xx, zz)));
+        const XMVECTOR tz = XMVectorAdd(one, XMVectorSubtract(zz, XMVectorAdd(xx, yy)));
+        const XMVECTOR yzMinus = XMVectorSubtract(yz, zy), zxMinus = XMVectorSubtract(zx, xz), xyMinus = XMVectorSubtract(xy, yx);
+        const XMVECTOR yzPlus = XMVectorAdd(yz, zy), zxPlus = XMVectorAdd(zx, xz), xyPlus = XMVectorAdd(xy, yx);
+
+        auto candidate = [&](FXMVECTOR t, XMVECTOR* s, XMVECTOR* invS) { *s = XMVectorSqrt(XMVectorMax(t, XMVectorZero())); *invS = XMVectorDivide(half, XMVectorMax(*s, XMVectorReplicate(1.0e-20f))); };
+        XMVECTOR s, inv;
+        candidate(tw, &s, &inv);
+        XMMATRIX q(XMVectorMultiply(yzMinus, inv), XMVectorMultiply(zxMinus, inv), XMVectorMultiply(xyMinus, inv), XMVectorMultiply(s, half));
+        XMVECTOR best = tw;
+
+        auto choose = [&](FXMVECTOR t, FXMVECTOR qx, FXMVECTOR qy, FXMVECTOR qz, GXMVECTOR qw)
+        {
+            const XMVECTOR better = XMVectorGreater(t, best);
+            q.r[0] = XMVectorSelect(q.r[0], qx, better);
+            q.r[1] = XMVectorSelect(q.r[1], qy, better);
+            q.r[2] = XMVectorSelect(q.r[2], qz, better);
+            q.r[3] = XMVectorSelect(q.r[3], qw, better);
+            best = XMVectorMax(best, t);
+        };
+        candidate(tx, &s, &inv);
+        choose(tx, XMVectorMultiply(s, half), XMVectorMultiply(xyPlus, inv), XMVectorMultiply(zxPlus, inv), XMVectorMultiply(yzMinus, inv));
+        candidate(ty, &s, &inv);
+        choose(ty, XMVectorMultiply(xyPlus, inv), XMVectorMultiply(s, half), XMVectorMultiply(yzPlus, inv), XMVectorMultiply(zxMinus, inv));
+        candidate(tz, &s, &inv);
+        choose(tz, XMVectorMultiply(zxPlus, inv), XMVectorMultiply(yzPlus, inv), XMVectorMultiply(s, half), XMVectorMultiply(xyMinus, inv));
+        return QuaternionNormalizeTransposed(q);
+    }
+}
+
 /******************************************************************************
 *   Math functions and methods
 ******************************************************************************/
@@ -84,11 +381,63 @@ King::FloatPoint3::FloatPoint3(FloatPoint4 vecIn)
     DirectX::XMVectorSetW(v, 0.f);
 }
 
+void King::FloatPoint3::OrthonormalBasis(const FloatPoint3 normalIn, FloatPoint3* tangentOut, FloatPoint3* bitangentOut)
+{
+    // Duff et al. 2017, "Building an Orthonormal Basis, Revisited", no branch on the hemisphere of z
+    assert(tangentOut && bitangentOut);
+    const auto n = normalIn.Get_XMFLOAT3();
+    const float sign = std::copysign(1.0f, n.z);
+    const float a = -1.0f / (sign + n.z);
+    const float b = n.x * n.y * a;
+    tangentOut->Set(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    bitangentOut->Set(b, sign + n.y * n.y * a, -n.y);
+}
+
+void King::FloatPoint3::OrthonormalBasis(const FloatPoint3* normalsIn, FloatPoint3* tangentsOut, FloatPoint3* bitangentsOut, size_t count)
+{
+    KING_MATH_COUNT("float3::OrthonormalBasis(batch)", count);
+    DirectX::XMMATRIX t, b;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        OrthonormalBasisTransposed(LoadTransposed4(normalsIn, i, count, DirectX::g_XMIdentityR2), &t, &b);
+        StoreTransposed4(tangentsOut, i, count, t);
+        StoreTransposed4(bitangentsOut, i, count, b);
+    }
+}
+
+void King::FloatPoint3::Orthonormalize(FloatPoint3& xInOut, FloatPoint3& yInOut, FloatPoint3& zOut)
+{
+    // Gram-Schmidt, x keeps its direction, y loses its x component and z is rebuilt from both
+    xInOut.Normalize();
+    yInOut = Normal(yInOut - xInOut * xInOut.DotProduct(yInOut));
+    zOut = CrossProduct(xInOut, yInOut);
+}
+
+void King::FloatPoint3::Orthonormalize(FloatPoint3* xInOut, FloatPoint3* yInOut, FloatPoint3* zOut, size_t count)
+{
+    KING_MATH_COUNT("float3::Orthonormalize(batch)", count);
+    using namespace DirectX;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX x = Normalize3Transposed(LoadTransposed4(xInOut, i, count, g_XMIdentityR0));
+        XMMATRIX y = LoadTransposed4(yInOut, i, count, g_XMIdentityR1);
+        const XMVECTOR d = Dot3Transposed(x, y);
+        y.r[0] = XMVectorNegativeMultiplySubtract(x.r[0], d, y.r[0]);
+        y.r[1] = XMVectorNegativeMultiplySubtract(x.r[1], d, y.r[1]);
+        y.r[2] = XMVectorNegativeMultiplySubtract(x.r[2], d, y.r[2]);
+        y = Normalize3Transposed(y);
+        StoreTransposed4(xInOut, i, count, x);
+        StoreTransposed4(yInOut, i, count, y);
+        StoreTransposed4(zOut, i, count, Cross3Transposed(x, y));
+    }
+}
+
 // Store the Euler angles in radians, credit to:
 // http://www.gamedev.net/topic/597324-quaternion-to-euler-angles-and-back-why-is-the-rotation-changing/
 // returns [-π , +π] radians
 DirectX::XMFLOAT3 King::Quaternion::GetEulerAngles() const
 {
+    KING_MATH_COUNT("Quaternion::GetEulerAngles", 1);
     DirectX::XMFLOAT3 pitchYawRoll; // output
     // x:ψ, y:θ, and z:φ
 
@@ -111,7 +460,7 @@ DirectX::XMFLOAT3 King::Quaternion::GetEulerAngles() const
     {
         // Singularity at north pole
         pitchYawRoll.x = 0.f;
-        pitchYawRoll.y = -2.f * atan2(q.x, q.w);
+        pitchYawRoll.y = -2.f * Scalar::ATan2(q.x, q.w);
         pitchYawRoll.z = -DirectX::XM_PIDIV2;
         return pitchYawRoll;
     }
@@ -119,7 +468,7 @@ DirectX::XMFLOAT3 King::Quaternion::GetEulerAngles() const
     {
         // Singularity at south pole
         pitchYawRoll.x = 0.f;
-        pitchYawRoll.y = 2.f * atan2(q.x, q.w);
+        pitchYawRoll.y = 2.f * Scalar::ATan2(q.x, q.w);
         pitchYawRoll.z = DirectX::XM_PIDIV2;
         return pitchYawRoll;
     }
@@ -189,9 +538,9 @@ DirectX::XMFLOAT3 King::Quaternion::GetEulerAngles() const
 
     // (+)x = w/RHS, thumb down the (+) x axis for 180 deg (+PI), then(-PI) increasing back to zero for 360 deg.
     // (+)y = w/RHS, thumb down the (+) y axis for 180 deg (+PI), then(-PI) increasing back to zero for 360 deg.
-    pitchYawRoll.x =  atan2(2.f * (q.x * q.w - q.y * q.z), -sq.x + sq.y - sq.z + sq.w); // range out is [-π, +π]
-    pitchYawRoll.y =  atan2(2.f * (q.y * q.w - q.x * q.z), sq.x - sq.y - sq.z + sq.w); // range out is [-π, +π]
-    pitchYawRoll.z =  asin(2.f * test / unit); // domain in is [-1.0, 1.0] and range out is [-π/2, + π/2]
+    pitchYawRoll.x =  Scalar::ATan2(2.f * (q.x * q.w - q.y * q.z), -sq.x + sq.y - sq.z + sq.w); // range out is [-π, +π]
+    pitchYawRoll.y =  Scalar::ATan2(2.f * (q.y * q.w - q.x * q.z), sq.x - sq.y - sq.z + sq.w); // range out is [-π, +π]
+    pitchYawRoll.z =  Scalar::ASin(2.f * test / unit); // domain in is [-1.0, 1.0] and range out is [-π/2, + π/2]
 
     // (+)z = w/RHS, thumb down the (+) z axis
     // EX: quadrant 1 (left of north), on (+) rotation as it crosses into quadrant 2:
@@ -220,6 +569,7 @@ DirectX::XMFLOAT3 King::Quaternion::GetEulerAngles() const
 
 DirectX::XMFLOAT3 King::Quaternion::CalculateAngularVelocity(const Quaternion prevRotation, float deltaTime) const
 {
+    KING_MATH_COUNT("Quaternion::CalculateAngularVelocity", 1);
     // Calculate the angular velocity from a (delta rotation) / (unit time), credit to:
     // DavidSWu at https://forum.unity.com/threads/manually-calculate-angular-velocity-of-gameobject.289462/
     auto delta = *this - prevRotation;
@@ -230,17 +580,120 @@ DirectX::XMFLOAT3 King::Quaternion::CalculateAngularVelocity(const Quaternion pr
     // handle negative angles
     if (rotation < 0.0f)
     {
-        const auto halfAngle = acos(-rotation);
-        gain = -2.0f * halfAngle / (sin(halfAngle) * deltaTime);
+        const auto halfAngle = Scalar::ACos(-rotation);
+        gain = -2.0f * halfAngle / (Scalar::Sin(halfAngle) * deltaTime);
     }
     else
     {
-        const auto halfAngle = acos(rotation);
-        gain = 2.0f * halfAngle / (sin(halfAngle) * deltaTime);
+        const auto halfAngle = Scalar::ACos(rotation);
+        gain = 2.0f * halfAngle / (Scalar::Sin(halfAngle) * deltaTime);
     }
     return float3(delta) * gain;
 }
 
+void King::Quaternion::CalculateAngularVelocity(const Quaternion* currentRotationsIn, const Quaternion* previousRotationsIn, float3* angularVelocitiesOut, size_t count, float deltaTime)
+{
+    KING_MATH_COUNT("Quaternion::CalculateAngularVelocity(batch)", count);
+    // Same delta rotation as the scalar method (current - previous), but the angle is recovered
+    // with the log-map, ω = 2 * atan2(|xyz|, |w|) * xyz / |xyz| / Δt, so small angles keep their
+    // precision instead of passing through acos(w) near 1.0. Sign of w picks the shortest arc.
+    using namespace DirectX;
+    assert(deltaTime > 0.f);
+
+    const XMVECTOR twoOverDt = XMVectorReplicate(2.0f / deltaTime);
+
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX c = LoadTransposed4(currentRotationsIn, i, count, XMQuaternionIdentity());
+        XMMATRIX p = LoadTransposed4(previousRotationsIn, i, count, XMQuaternionIdentity());
+        // conjugate as the inverse, the length scale it drops does not change the log-map below
+        p.r[0] = XMVectorNegate(p.r[0]);
+        p.r[1] = XMVectorNegate(p.r[1]);
+        p.r[2] = XMVectorNegate(p.r[2]);
+        XMMATRIX d = QuaternionMultiplyTransposed(c, p);
+
+        XMVECTOR gain = AngleOverSin(LengthSq3Transposed(d), XMVectorAbs(d.r[3]));
+        gain = XMVectorMultiply(gain, XMVectorSelect(twoOverDt, XMVectorNegate(twoOverDt), XMVectorLess(d.r[3], XMVectorZero())));
+
+        d.r[0] = XMVectorMultiply(d.r[0], gain);
+        d.r[1] = XMVectorMultiply(d.r[1], gain);
+        d.r[2] = XMVectorMultiply(d.r[2], gain);
+        d.r[3] = XMVectorZero();
+        StoreTransposed4(angularVelocitiesOut, i, count, d);
+    }
+}
+
+Quaternion King::Quaternion::Exp() const
+{
+    // e^w * (cos|xyz|, sin|xyz| * xyz / |xyz|), for a pure quaternion (w = 0) this is the rotation
+    // of angle 2|xyz| about xyz
+    return Quaternion(DirectX::XMVectorScale(DirectX::XMQuaternionExp(v), Scalar::Exp(GetW())));
+}
+
+Quaternion King::Quaternion::Log() const
+{
+    // (θ * xyz / |xyz|, ln|q|), for a unit quaternion this is the pure quaternion of half the rotation vector
+    const float length = DirectX::XMVectorGetX(DirectX::XMVector4Length(v));
+    if (length <= 0.f) return Quaternion(DirectX::XMVectorZero());
+    const auto ln = DirectX::XMQuaternionLn(DirectX::XMVectorScale(v, 1.0f / length));
+    return Quaternion(DirectX::XMVectorSetW(ln, Scalar::Log(length)));
+}
+
+void King::Quaternion::Integrate(const float3 & angularVelocity, float deltaTime)
+{
+    KING_MATH_COUNT("Quaternion::Integrate", 1);
+    // inverse of CalculateAngularVelocity(), the delta rotation is the exponential map of ω * Δt / 2
+    const auto delta = DirectX::XMQuaternionExp(DirectX::XMVectorScale(angularVelocity, 0.5f * deltaTime));
+    v = DirectX::XMQuaternionNormalize(DirectX::XMQuaternionMultiply(delta, v));
+}
+
+void King::Quaternion::Exp(const Quaternion* quaternionsIn, Quaternion* quaternionsOut, size_t count)
+{
+    KING_MATH_COUNT("Quaternion::Exp(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+        StoreTransposed4(quaternionsOut, i, count, QuaternionExpTransposed(LoadTransposed4(quaternionsIn, i, count, DirectX::XMVectorZero())));
+}
+
+void King::Quaternion::Log(const Quaternion* quaternionsIn, Quaternion* quaternionsOut, size_t count)
+{
+    KING_MATH_COUNT("Quaternion::Log(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+        StoreTransposed4(quaternionsOut, i, count, QuaternionLogTransposed(LoadTransposed4(quaternionsIn, i, count, DirectX::XMQuaternionIdentity())));
+}
+
+void King::Quaternion::Pow(const Quaternion* quaternionsIn, float exponent, Quaternion* quaternionsOut, size_t count)
+{
+    KING_MATH_COUNT("Quaternion::Pow(batch)", count);
+    using namespace DirectX;
+    const XMVECTOR t = XMVectorReplicate(exponent);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        XMMATRIX l = QuaternionLogTransposed(LoadTransposed4(quaternionsIn, i, count, XMQuaternionIdentity()));
+        l.r[0] = XMVectorMultiply(l.r[0], t);
+        l.r[1] = XMVectorMultiply(l.r[1], t);
+        l.r[2] = XMVectorMultiply(l.r[2], t);
+        l.r[3] = XMVectorMultiply(l.r[3], t);
+        StoreTransposed4(quaternionsOut, i, count, QuaternionExpTransposed(l));
+    }
+}
+
+void King::Quaternion::Integrate(Quaternion* rotationsInOut, const float3* angularVelocitiesIn, size_t count, float deltaTime)
+{
+    KING_MATH_COUNT("Quaternion::Integrate(batch)", count);
+    using namespace DirectX;
+    const XMVECTOR halfDt = XMVectorReplicate(0.5f * deltaTime);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX q = LoadTransposed4(rotationsInOut, i, count, XMQuaternionIdentity());
+        XMMATRIX w = LoadTransposed4(angularVelocitiesIn, i, count, XMVectorZero());
+        w.r[0] = XMVectorMultiply(w.r[0], halfDt);
+        w.r[1] = XMVectorMultiply(w.r[1], halfDt);
+        w.r[2] = XMVectorMultiply(w.r[2], halfDt);
+        w.r[3] = XMVectorZero();
+        StoreTransposed4(rotationsInOut, i, count, QuaternionNormalizeTransposed(QuaternionMultiplyTransposed(QuaternionExpTransposed(w), q)));
+    }
+}
+
 // Assignments
 
 void __vectorcall King::Quaternion::SetAxisAngle(float3 vector, float angleRadians)
@@ -271,6 +724,7 @@ void __vectorcall King::Quaternion::SetAxisAngle(float3 vector, float angleRadia
 //https://stackoverflow.com/questions/1171849/finding-quaternion-representing-the-rotation-from-one-vector-to-another
 void King::Quaternion::Set(const float3 &vFrom, const float3 &vTo)
 {
+    KING_MATH_COUNT("Quaternion::Set(vFrom, vTo)", 1);
     float t = vFrom.DotProduct(vTo);
 
     if (t > 0.999999)
@@ -278,10 +732,10 @@ void King::Quaternion::Set(const float3 &vFrom, const float3 &vTo)
         // parallel
         v = DirectX::XMQuaternionIdentity(); // 0 degrees
     }
-    if (t < -0.999999)
+    else if (t < -0.999999)
     {
-        // parallel and opposite
-        v = float3::Normal(vFrom); // axis
+        // parallel and opposite, any axis perpendicular to vFrom
+        v = DirectX::XMVector3Normalize(DirectX::XMVector3Orthogonal(vFrom)); // axis
         SetW(0.f); // 180 degree.
     }
     else
@@ -295,3 +749,574 @@ void King::Quaternion::Set(const float3 &vFrom, const float3 &vTo)
     }
 
 }
+
+void King::Quaternion::ShortestArc(const float3* vFromIn, const float3* vToIn, Quaternion* rotationsOut, size_t count)
+{
+    KING_MATH_COUNT("Quaternion::ShortestArc(batch)", count);
+    // q = (vFrom x vTo, |vFrom||vTo| + vFrom.vTo) normalized, which needs no unit inputs. Lanes that are
+    // antiparallel take 180 degrees about a perpendicular axis and zero length inputs are identity.
+    using namespace DirectX;
+    const XMVECTOR epsilon = XMVectorReplicate(1.0e-6f);
+    const XMVECTOR tiny = XMVectorReplicate(1.0e-20f);
+
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX a = LoadTransposed4(vFromIn, i, count, g_XMIdentityR0);
+        const XMMATRIX b = LoadTransposed4(vToIn, i, count, g_XMIdentityR0);
+        const XMVECTOR &ax = a.r[0], &ay = a.r[1], &az = a.r[2];
+        const XMVECTOR &bx = b.r[0], &by = b.r[1], &bz = b.r[2];
+
+        const XMVECTOR dot = XMVectorMultiplyAdd(ax, bx, XMVectorMultiplyAdd(ay, by, XMVectorMultiply(az, bz)));
+        const XMVECTOR lengths = XMVectorSqrt(XMVectorMultiply(LengthSq3Transposed(a), LengthSq3Transposed(b)));
+        const XMVECTOR w = XMVectorAdd(lengths, dot);
+        const XMVECTOR antiparallel = XMVectorLessOrEqual(w, XMVectorMultiply(lengths, epsilon));
+        const XMVECTOR degenerate = XMVectorLessOrEqual(lengths, tiny);
+
+        // perpendicular to vFrom from the two larger components
+        const XMVECTOR useXY = XMVectorGreater(XMVectorAbs(ax), XMVectorAbs(az));
+        const XMVECTOR ox = XMVectorSelect(XMVectorZero(), XMVectorNegate(ay), useXY);
+        const XMVECTOR oy = XMVectorSelect(XMVectorNegate(az), ax, useXY);
+        const XMVECTOR oz = XMVectorSelect(ay, XMVectorZero(), useXY);
+
+        XMMATRIX q;
+        q.r[0] = XMVectorSelect(XMVectorNegativeMultiplySubtract(az, by, XMVectorMultiply(ay, bz)), ox, antiparallel);
+        q.r[1] = XMVectorSelect(XMVectorNegativeMultiplySubtract(ax, bz, XMVectorMultiply(az, bx)), oy, antiparallel);
+        q.r[2] = XMVectorSelect(XMVectorNegativeMultiplySubtract(ay, bx, XMVectorMultiply(ax, by)), oz, antiparallel);
+        q.r[3] = XMVectorSelect(w, XMVectorZero(), antiparallel);
+        q = QuaternionNormalizeTransposed(q);
+
+        q.r[0] = XMVectorSelect(q.r[0], XMVectorZero(), degenerate);
+        q.r[1] = XMVectorSelect(q.r[1], XMVectorZero(), degenerate);
+        q.r[2] = XMVectorSelect(q.r[2], XMVectorZero(), degenerate);
+        q.r[3] = XMVectorSelect(q.r[3], XMVectorSplatOne(), degenerate);
+        StoreTransposed4(rotationsOut, i, count, q);
+    }
+}
+
+void King::Quaternion::SetLookRotation(const float3 & forward, const float3 & up)
+{
+    KING_MATH_COUNT("Quaternion::SetLookRotation", 1);
+    v = DirectX::XMQuaternionRotationMatrix(LookRotationMatrix(forward, up));
+}
+
+void King::Quaternion::LookRotation(const float3* forwardsIn, const float3* upsIn, Quaternion* rotationsOut, size_t count)
+{
+    KING_MATH_COUNT("Quaternion::LookRotation(batch)", count);
+    DirectX::XMMATRIX x, y, z;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        LookRotationTransposed(LoadTransposed4(forwardsIn, i, count, DirectX::g_XMIdentityR2), LoadTransposed4(upsIn, i, count, DirectX::g_XMIdentityR1), &x, &y, &z);
+        StoreTransposed4(rotationsOut, i, count, QuaternionFromRowsTransposed(x, y, z));
+    }
+}
+
+/******************************************************************************
+*   Look at
+******************************************************************************/
+DirectX::XMMATRIX __vectorcall King::LookRotationMatrix(const FloatPoint3 forward, const FloatPoint3 up)
+{
+    const float3 z = Normalize(forward);
+    float3 x = Cross(up, z);
+    if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(x)) <= DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(up)) * LookParallelSinSq)
+    {
+        float3 bitangent;
+        float3::OrthonormalBasis(z, &x, &bitangent);
+    }
+    else
+        x.Normalize();
+    return DirectX::XMMATRIX(x, Cross(z, x), z, DirectX::g_XMIdentityR3);
+}
+
+void King::LookRotationMatrix(const FloatPoint3* forwardsIn, const FloatPoint3* upsIn, DirectX::XMMATRIX* matricesOut, size_t count)
+{
+    KING_MATH_COUNT("LookRotationMatrix(batch)", count);
+    using namespace DirectX;
+    XMMATRIX x, y, z;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        LookRotationTransposed(LoadTransposed4(forwardsIn, i, count, g_XMIdentityR2), LoadTransposed4(upsIn, i, count, g_XMIdentityR1), &x, &y, &z);
+        x = XMMatrixTranspose(x);
+        y = XMMatrixTranspose(y);
+        z = XMMatrixTranspose(z);
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+            matricesOut[i + j] = XMMATRIX(x.r[j], y.r[j], z.r[j], g_XMIdentityR3);
+    }
+}
+
+void King::LookAtMatrix(const FloatPoint3* eyesIn, const FloatPoint3* targetsIn, const FloatPoint3* upsIn, DirectX::XMMATRIX* viewMatricesOut, size_t count)
+{
+    KING_MATH_COUNT("LookAtMatrix(batch)", count);
+    using namespace DirectX;
+    XMMATRIX x, y, z;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX eye = LoadTransposed4(eyesIn, i, count, XMVectorZero());
+        XMMATRIX forward = LoadTransposed4(targetsIn, i, count, g_XMIdentityR2);
+        forward.r[0] = XMVectorSubtract(forward.r[0], eye.r[0]);
+        forward.r[1] = XMVectorSubtract(forward.r[1], eye.r[1]);
+        forward.r[2] = XMVectorSubtract(forward.r[2], eye.r[2]);
+        LookRotationTransposed(forward, LoadTransposed4(upsIn, i, count, g_XMIdentityR1), &x, &y, &z);
+
+        // view is the inverse (transpose) of the rotation with the eye moved to the origin
+        const XMMATRIX r0 = XMMatrixTranspose(XMMATRIX(x.r[0], y.r[0], z.r[0], XMVectorZero()));
+        const XMMATRIX r1 = XMMatrixTranspose(XMMATRIX(x.r[1], y.r[1], z.r[1], XMVectorZero()));
+        const XMMATRIX r2 = XMMatrixTranspose(XMMATRIX(x.r[2], y.r[2], z.r[2], XMVectorZero()));
+        const XMMATRIX r3 = XMMatrixTranspose(XMMATRIX(XMVectorNegate(Dot3Transposed(x, eye)), XMVectorNegate(Dot3Transposed(y, eye)), XMVectorNegate(Dot3Transposed(z, eye)), XMVectorSplatOne()));
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+            viewMatricesOut[i + j] = XMMATRIX(r0.r[j], r1.r[j], r2.r[j], r3.r[j]);
+    }
+}
+
+/******************************************************************************
+*   SystemInfo
+******************************************************************************/
+namespace
+{
+    std::atomic<double> memoryBandwidthSet{ 0.0 };
+
+    // CPUID of a leaf and sub-leaf into eax, ebx, ecx, edx; false off x86 or when the leaf is beyond the maximum
+    bool CpuId(const unsigned leaf, const unsigned subLeaf, unsigned regs[4])
+    {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int r[4];
+        __cpuid(r, static_cast<int>(leaf & 0x80000000u));
+        if (static_cast<unsigned>(r[0]) < leaf)
+            return false;
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subLeaf));
+        for (int i = 0; i < 4; ++i)
+            regs[i] = static_cast<unsigned>(r[i]);
+        return true;
+#elif defined(__x86_64__) || defined(__i386__)
+        if (__get_cpuid_max(leaf & 0x80000000u, nullptr) < leaf)
+            return false;
+        __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+        return true;
+#else
+        (void)leaf; (void)subLeaf;
+        return false;
+#endif
+    }
+
+    // keeps the first cache reported for each level and type, sorted L1D, L1I, L2, L3
+    void AddCache(std::vector<CacheInfo>& caches, const CacheInfo& cache)
+    {
+        if (cache.level == 0 || cache.size == 0)
+            return;
+        for (const auto& c : caches)
+            if (c.level == cache.level && c.type == cache.type)
+                return;
+        caches.push_back(cache);
+        std::sort(caches.begin(), caches.end(), [](const CacheInfo& a, const CacheInfo& b) { return a.level != b.level ? a.level < b.level : a.type < b.type; });
+    }
+
+    // vendor, brand, and what the OS left unknown: caches from leaf 4 (0x8000001D on AMD) and SMT from leaf 0xB
+    void DiscoverCpuId(CpuTopology& topology)
+    {
+        unsigned regs[4];
+        if (!CpuId(0, 0, regs))
+            return;
+        char vendor[13] = {};
+        memcpy(vendor, &regs[1], 4); memcpy(vendor + 4, &regs[3], 4); memcpy(vendor + 8, &regs[2], 4);
+        topology.vendor = vendor;
+
+        char brand[49] = {};
+        for (unsigned leaf = 0; leaf < 3; ++leaf)
+        {
+            if (!CpuId(0x80000002u + leaf, 0, regs))
+                break;
+            memcpy(brand + leaf * 16, regs, 16);
+        }
+        topology.brand = brand;
+        topology.brand.erase(0, topology.brand.find_first_not_of(' '));
+
+        if (topology.caches.empty())
+        {
+            unsigned cacheLeaf = 4;
+            if (topology.vendor == "AuthenticAMD" || topology.vendor == "HygonGenuine")
+            {
+                // deterministic cache parameters need the topology extensions
+                cacheLeaf = (CpuId(0x80000001u, 0, regs) && (regs[2] & (1u << 22))) ? 0x8000001Du : 0;
+            }
+            for (unsigned subLeaf = 0; cacheLeaf && subLeaf < 16 && CpuId(cacheLeaf, subLeaf, regs); ++subLeaf)
+            {
+                const unsigned type = regs[0] & 0x1F;
+                if (type == 0)
+                    break;
+                CacheInfo cache;
+                cache.type = type == 1 ? 'D' : type == 2 ? 'I' : 'U';
+                cache.level = (regs[0] >> 5) & 0x7;
+                cache.sharedBy = ((regs[0] >> 14) & 0xFFF) + 1;
+                cache.lineSize = (regs[1] & 0xFFF) + 1;
+                const size_t partitions = ((regs[1] >> 12) & 0x3FF) + 1;
+                const size_t ways = ((regs[1] >> 22) & 0x3FF) + 1;
+                const size_t sets = static_cast<size_t>(regs[2]) + 1;
+                cache.associativity = (regs[0] & (1u << 9)) ? 0 : static_cast<unsigned>(ways);
+                cache.size = ways * partitions * cache.lineSize * sets;
+                AddCache(topology.caches, cache);
+            }
+        }
+        if (topology.threadsPerCore <= 1 && topology.physicalCores == 0 && CpuId(0xB, 0, regs) && ((regs[2] >> 8) & 0xFF) == 1)
+        {
+            topology.threadsPerCore = std::max(1u, regs[1] & 0xFFFF);
+            if (CpuId(0xB, 1, regs) && ((regs[2] >> 8) & 0xFF) == 2 && (regs[1] & 0xFFFF))
+            {
+                topology.logicalProcessors = regs[1] & 0xFFFF;
+                topology.physicalCores = topology.logicalProcessors / topology.threadsPerCore;
+                topology.packages = 1;
+            }
+            if (topology.source.empty())
+                topology.source = "cpuid";
+        }
+    }
+
+#if defined(_WIN32)
+    void DiscoverWindows(CpuTopology& topology)
+    {
+        DWORD length = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+        if (length == 0)
+            return;
+        std::vector<uint8_t> buffer(length);
+        if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+            return;
+
+        std::vector<std::vector<unsigned>> nodes;
+        std::vector<unsigned> nodeIds;
+        for (DWORD offset = 0; offset < length;)
+        {
+            const auto* item = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+            switch (item->Relationship)
+            {
+            case RelationProcessorCore:
+            {
+                ++topology.physicalCores;
+                unsigned threads = 0;
+                for (WORD g = 0; g < item->Processor.GroupCount; ++g)
+                    threads += static_cast<unsigned>(std::bitset<64>(item->Processor.GroupMask[g].Mask).count());
+                topology.logicalProcessors += threads;
+                topology.threadsPerCore = std::max(topology.threadsPerCore, threads);
+                break;
+            }
+            case RelationProcessorPackage:
+                ++topology.packages;
+                break;
+            case RelationNumaNode:
+            {
+                std::vector<unsigned> processors;
+                const GROUP_AFFINITY& affinity = item->NumaNode.GroupMask;
+                for (unsigned bit = 0; bit < 64; ++bit)
+                    if (affinity.Mask & (KAFFINITY(1) << bit))
+                        processors.push_back(affinity.Group * 64u + bit);
+                nodes.push_back(std::move(processors));
+                nodeIds.push_back(item->NumaNode.NodeNumber);
+                break;
+            }
+            case RelationCache:
+            {
+                CacheInfo cache;
+                cache.level = item->Cache.Level;
+                cache.type = item->Cache.Type == CacheData ? 'D' : item->Cache.Type == CacheInstruction ? 'I' : 'U';
+                cache.size = item->Cache.CacheSize;
+                cache.lineSize = item->Cache.LineSize;
+                cache.associativity = item->Cache.Associativity == CACHE_FULLY_ASSOCIATIVE ? 0 : item->Cache.Associativity;
+                cache.sharedBy = static_cast<unsigned>(std::bitset<64>(item->Cache.GroupMask.Mask).count());
+                if (item->Cache.Type != CacheTrace)
+                    AddCache(topology.caches, cache);
+                break;
+            }
+            default:
+                break;
+            }
+            offset += item->Size;
+        }
+        if (!nodes.empty())
+        {
+            topology.numaNodes = static_cast<unsigned>(nodes.size());
+            topology.numaNodeProcessors = std::move(nodes);
+            topology.numaNodeIds = std::move(nodeIds);
+        }
+        if (topology.logicalProcessors)
+            topology.source = "windows";
+    }
+#endif
+
+#if defined(__linux__)
+    std::string ReadLine(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+    // "0-3,8,10-11"
+    std::vector<unsigned> ParseCpuList(const std::string& list)
+    {
+        std::vector<unsigned> cpus;
+        std::istringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ','))
+        {
+            if (range.empty())
+                continue;
+            const auto dash = range.find('-');
+            const unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            const unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+            for (unsigned cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+    // "48K", "2048K", "32M"
+    size_t ParseSize(const std::string& text)
+    {
+        if (text.empty())
+            return 0;
+        size_t value = static_cast<size_t>(std::strtoull(text.c_str(), nullptr, 10));
+        switch (text.back())
+        {
+        case 'K': value <<= 10; break;
+        case 'M': value <<= 20; break;
+        case 'G': value <<= 30; break;
+        default: break;
+        }
+        return value;
+    }
+
+    void DiscoverSysfs(CpuTopology& topology)
+    {
+        namespace fs = std::filesystem;
+        const std::string cpuRoot = "/sys/devices/system/cpu/";
+        const auto online = ParseCpuList(ReadLine(cpuRoot + "online"));
+        if (online.empty())
+            return;
+        topology.logicalProcessors = static_cast<unsigned>(online.size());
+
+        std::set<std::pair<int, int>> cores;
+        std::set<int> packages;
+        for (const unsigned cpu : online)
+        {
+            const std::string path = cpuRoot + "cpu" + std::to_string(cpu) + "/topology/";
+            const std::string core = ReadLine(path + "core_id");
+            const std::string package = ReadLine(path + "physical_package_id");
+            if (core.empty())
+                continue;
+            const int packageId = package.empty() ? 0 : std::stoi(package);
+            cores.emplace(packageId, std::stoi(core));
+            packages.insert(packageId);
+        }
+        if (!cores.empty())
+        {
+            topology.physicalCores = static_cast<unsigned>(cores.size());
+            topology.packages = static_cast<unsigned>(packages.size());
+            topology.threadsPerCore = std::max(1u, topology.logicalProcessors / topology.physicalCores);
+        }
+
+        std::error_code error;
+        std::vector<std::pair<unsigned, std::vector<unsigned>>> nodes;
+        for (fs::directory_iterator it("/sys/devices/system/node", error), end; !error && it != end; it.increment(error))
+        {
+            const std::string name = it->path().filename().string();
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 && isdigit(static_cast<unsigned char>(name[4])))
+                nodes.emplace_back(static_cast<unsigned>(std::stoul(name.substr(4))), ParseCpuList(ReadLine(it->path().string() + "/cpulist")));
+        }
+        std::sort(nodes.begin(), nodes.end());
+        if (!nodes.empty())
+        {
+            topology.numaNodes = static_cast<unsigned>(nodes.size());
+            topology.numaNodeProcessors.clear();
+            topology.numaNodeIds.clear();
+            for (auto& node : nodes)
+            {
+                topology.numaNodeIds.push_back(node.first);
+                topology.numaNodeProcessors.push_back(std::move(node.second));
+            }
+        }
+
+        const std::string cacheRoot = cpuRoot + "cpu" + std::to_string(online.front()) + "/cache/";
+        for (unsigned index = 0; fs::exists(cacheRoot + "index" + std::to_string(index), error); ++index)
+        {
+            const std::string path = cacheRoot + "index" + std::to_string(index) + "/";
+            const std::string type = ReadLine(path + "type");
+            const std::string level = ReadLine(path + "level");
+            if (level.empty())
+                continue;
+            CacheInfo cache;
+            cache.level = static_cast<unsigned>(std::stoul(level));
+            cache.type = type == "Data" ? 'D' : type == "Instruction" ? 'I' : 'U';
+            cache.size = ParseSize(ReadLine(path + "size"));
+            cache.lineSize = ParseSize(ReadLine(path + "coherency_line_size"));
+            cache.associativity = static_cast<unsigned>(ParseSize(ReadLine(path + "ways_of_associativity")));
+            cache.sharedBy = static_cast<unsigned>(ParseCpuList(ReadLine(path + "shared_cpu_list")).size());
+            AddCache(topology.caches, cache);
+        }
+        topology.source = "sysfs";
+    }
+#endif
+
+    CpuTopology DiscoverTopology()
+    {
+        CpuTopology topology;
+#if defined(_WIN32)
+        DiscoverWindows(topology);
+#elif defined(__linux__)
+        DiscoverSysfs(topology);
+#endif
+        DiscoverCpuId(topology);
+        if (topology.logicalProcessors == 0)
+            topology.logicalProcessors = std::max(1u, std::thread::hardware_concurrency());
+        if (topology.physicalCores == 0)
+            topology.physicalCores = std::max(1u, topology.logicalProcessors / topology.threadsPerCore);
+        if (topology.packages == 0)
+            topology.packages = 1;
+        if (topology.numaNodeProcessors.empty())
+        {
+            std::vector<unsigned> all(topology.logicalProcessors);
+            for (unsigned i = 0; i < topology.logicalProcessors; ++i)
+                all[i] = i;
+            topology.numaNodes = 1;
+            topology.numaNodeProcessors.push_back(std::move(all));
+            topology.numaNodeIds.assign(1, 0u);
+        }
+        for (const auto& cache : topology.caches)
+        {
+            if (cache.level == 1 && cache.type != 'I' && cache.lineSize)
+            {
+                topology.cacheLineSize = cache.lineSize;
+                break;
+            }
+        }
+        if (topology.source.empty())
+            topology.source = "default";
+        return topology;
+    }
+
+    double MeasureMemoryBandwidth()
+    {
+        using namespace DirectX;
+        // larger than any last level cache, best of several passes with independent accumulators
+        const size_t count = (64ull << 20) / sizeof(XMFLOAT4A);
+        std::vector<XMFLOAT4A> buffer(count, XMFLOAT4A(1.0f, 1.0f, 1.0f, 1.0f));
+        XMVECTOR sink = XMVectorZero();
+        double best = 0.0;
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            XMVECTOR a0 = XMVectorZero(), a1 = XMVectorZero(), a2 = XMVectorZero(), a3 = XMVectorZero();
+            const auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; i += 4)
+            {
+                a0 = XMVectorAdd(a0, XMLoadFloat4A(&buffer[i]));
+                a1 = XMVectorAdd(a1, XMLoadFloat4A(&buffer[i + 1]));
+                a2 = XMVectorAdd(a2, XMLoadFloat4A(&buffer[i + 2]));
+                a3 = XMVectorAdd(a3, XMLoadFloat4A(&buffer[i + 3]));
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            sink = XMVectorAdd(sink, XMVectorAdd(XMVectorAdd(a0, a1), XMVectorAdd(a2, a3)));
+            if (seconds > 0.0)
+                best = std::max(best, static_cast<double>(count * sizeof(XMFLOAT4A)) / seconds);
+        }
+        volatile float keep = XMVectorGetX(sink); // keeps the reads from being optimized away
+        (void)keep;
+        return best;
+    }
+}
+
+double King::SystemInfo::GetMemoryBandwidth()
+{
+    const double set = memoryBandwidthSet.load(std::memory_order_relaxed);
+    if (set > 0.0)
+        return set;
+    static const double measured = MeasureMemoryBandwidth();
+    return measured;
+}
+
+void King::SystemInfo::SetMemoryBandwidth(const double bytesPerSecond) { memoryBandwidthSet.store(bytesPerSecond, std::memory_order_relaxed); }
+
+const CpuTopology& King::SystemInfo::GetTopology()
+{
+    static const CpuTopology topology = DiscoverTopology();
+    return topology;
+}
+
+size_t King::SystemInfo::GetCacheSize(const unsigned level, const char type)
+{
+    for (const auto& cache : GetTopology().caches)
+        if (cache.level == level && (cache.type == type || cache.type == 'U'))
+            return cache.size;
+    return 0;
+}
+
+uint64_t King::SystemInfo::GetInstalledMemory()
+{
+#if defined(_WIN32)
+    MEMORYSTATUSEX statex;
+    statex.dwLength = sizeof(statex);
+    if (GlobalMemoryStatusEx(&statex))
+        return statex.ullTotalPhys;
+#elif defined(__linux__)
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t value;
+    while (meminfo >> key >> value)
+    {
+        if (key == "MemTotal:")
+            return value * 1024; // reported in kB
+        meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+#endif
+    return 0;
+}
+
+std::string King::SystemInfo::GetGraphicsCardName()
+{
+#if defined(_WIN32)
+    DISPLAY_DEVICEA displayDevice;
+    displayDevice.cb = sizeof(displayDevice);
+    if (EnumDisplayDevicesA(nullptr, 0, &displayDevice, 0))
+        return displayDevice.DeviceString;
+#elif defined(__linux__)
+    // display controllers are PCI class 0x03; names need the pci.ids database so the ids and kernel driver are reported
+    namespace fs = std::filesystem;
+    std::error_code error;
+    for (fs::directory_iterator it("/sys/bus/pci/devices", error), end; !error && it != end; it.increment(error))
+    {
+        const std::string path = it->path().string() + "/";
+        if (ReadLine(path + "class").compare(0, 4, "0x03") != 0)
+            continue;
+        const std::string vendor = ReadLine(path + "vendor");
+        const std::string device = ReadLine(path + "device");
+        std::string name = vendor == "0x10de" ? "NVIDIA" : vendor == "0x1002" ? "AMD" : vendor == "0x8086" ? "Intel" : "PCI";
+        name += " " + vendor.substr(std::min<size_t>(2, vendor.size())) + ":" + device.substr(std::min<size_t>(2, device.size()));
+        std::error_code linkError;
+        const fs::path driver = fs::read_symlink(path + "driver", linkError);
+        if (!linkError)
+            name += " (" + driver.filename().string() + ")";
+        return name;
+    }
+#endif
+    return std::string();
+}
+
+void King::SystemInfo::GetSystemInfoToCout()
+{
+    const CpuTopology& topology = GetTopology();
+    cout << "CPU: " << topology.brand << " (" << topology.vendor << ")" << "\n";
+    cout << "  Packages: " << topology.packages << " Cores: " << topology.physicalCores << " Logical processors: " << topology.logicalProcessors
+        << " Threads per core: " << topology.threadsPerCore << " NUMA nodes: " << topology.numaNodes << " [" << topology.source << "]\n";
+    for (const auto& cache : topology.caches)
+        cout << "  L" << cache.level << cache.type << ": " << (cache.size >> 10) << " KB, " << cache.lineSize << " byte lines, " << cache.associativity << " way, shared by " << cache.sharedBy << "\n";
+    cout << "Installed Memory: " << (GetInstalledMemory() >> 20) << " MB" << "\n";
+    cout << "Graphics Card: " << GetGraphicsCardName() << endl;
+}
+
+void King::to_json(json& j, const CacheInfo& from)
+{
+    j = json{ {"level", from.level}, {"type", std::string(1, from.type)}, {"size", from.size}, {"lineSize", from.lineSize}, {"associativity", from.associativity}, {"sharedBy", from.sharedBy} };
+}
+
+void King::to_json(json& j, const CpuTopology& from)
+{
+    j = json{ {"vendor", from.vendor}, {"brand", from.brand}, {"logicalProcessors", from.logicalProcessors}, {"physicalCores", from.physicalCores},
+        {"packages", from.packages}, {"threadsPerCore", from.threadsPerCore}, {"numaNodes", from.numaNodes}, {"numaNodeProcessors", from.numaNodeProcessors}, {"numaNodeIds", from.numaNodeIds},
+        {"caches", from.caches}, {"cacheLineSize", from.cacheLineSize}, {"source", from.source} };
+}
@@ -58,7 +58,7 @@ SOFTWARE.
 #endif
 
 #define KING_MATH_VERSION_MAJOR 2
-#define KING_MATH_VERSION_MINOR 9
+#define KING_MATH_VERSION_MINOR 34
 #define KING_MATH_VERSION_PATCH 0
 
 /*
@@ -140,6 +140,116 @@ SOFTWARE.
     27NOV2023       Modified the new() and delete() methods for UIntPoint2, IntPoint2, and IntPoint3 for
                     multiple compiler use. Also added additional constexpr constructors and Set(...) method definitions
                     to all for compile time use in macros and templates (use case for UI in code templates)
+
+    Version 2.10.0  Added Quaternion::CalculateAngularVelocity(...) batch static for arrays of current and previous
+    17OCT2026       rotations. Four rotations are processed per call to the intrinsics using the log-map of the
+                    delta rotation which stays stable for tiny angles (scalar version zeros those out)
+
+    Version 2.11.0  Added Quaternion Exp(), Log(), Pow(exponent) and Integrate(angularVelocity, deltaTime) with
+    17OCT2026       batch statics of each. Integrate() applies the exponential map of ω * Δt / 2 so the axis and
+                    angle no longer need to be rebuilt every step, and is the inverse of CalculateAngularVelocity()
+
+    Version 2.12.0  Added Quaternion::ShortestArc(...) batch static to compute the rotations from arrays of vFrom to
+    17OCT2026       vTo directions without branches, antiparallel pairs are resolved with lane masks.
+                    Fixed Set(vFrom, vTo) for antiparallel vectors to rotate about a perpendicular axis
+
+    Version 2.13.0  Added float3 OrthonormalBasis(...) (branchless Frisvad/Duff) and Gram-Schmidt Orthonormalize(...),
+    17OCT2026       Quaternion SetLookRotation(forward, up), and LookRotationMatrix(...) and LookAtMatrix(...) functions
+                    each with batch versions for tangent frames and camera/bone aiming
+
+    Version 2.14.0  Added MathSIMDFixed.h with fix3 (Q16.16), fix3w (Q32.32) and fixquat (Q16.16) types on SSE2 integer
+    17OCT2026       lanes, and Fixed:: integer sqrt and CORDIC trig so lockstep simulation is bit identical across machines
+
+    Version 2.15.0  Added KING_MATH_DETERMINISTIC compile mode: estimate functions (GetMagnitudeEst, MagnitudeEst,
+    17OCT2026       RecipSqrt) use the exact instructions, builds with fast math, FMA or SSE4 dot products do not compile,
+                    and SumComponents always adds (x + y) + (z + w).  Added Hash(...) of component bits for golden replays
+                    and DeterminismSelfTest() with golden hashes, scalar transcendentals go through King::Scalar, the
+                    DirectXMath polynomials, and GCC builds turn off floating point contraction
+
+    Version 2.16.0  Added MathSIMDInstrument.h, with KING_MATH_INSTRUMENT defined the batch kernels and major scalar methods
+    17OCT2026       count calls, elements and rdtsc cycles into a registry queried with Instrument::GetCounters() or dumped
+                    to json with Instrument::DumpToJson()
+
+    Version 2.17.0  Added MathSIMDPerf.h with PerfCounters (Linux perf_event_open cycles, instructions, L1D/LLC and branch
+    17OCT2026       misses) and PerfHarness reporting IPC, bytes per cycle and bandwidth against SystemInfo::GetMemoryBandwidth()
+                    to tell compute bound kernels from memory bound ones
+
+    Version 2.18.0  SystemInfo returns CpuTopology data: cores, SMT threads per core, packages, NUMA nodes and their processors, cache
+    17OCT2026       levels with size, line size, ways and sharing, from /sys, GetLogicalProcessorInformationEx and CPUID leaf 4/0xB.
+                    Fixed Linux installed memory, graphics card from PCI sysfs and the undefined GetCPUInfoToCout member
+
+    Version 2.19.0  Added MathSIMDNuma.h, NumaArray<T> places one page aligned partition per NUMA node by mbind/VirtualAllocExNuma
+    17OCT2026       or first touch from pinned threads; ParallelFor keeps each thread on its node's partition and Numa::Transform,
+                    Numa::Rotate and Numa::Multiply run bulk float3/quat work node local on NumaPlanes, x/y/z/w float planes
+                    4 elements per XMVECTOR, with a persistent pool of worker threads pinned per node
+
+    Version 2.20.0  Added MathSIMDArena.h, Arena is a bump allocator on explicit (MAP_HUGETLB, MEM_LARGE_PAGES) or transparent
+    17OCT2026       (madvise MADV_HUGEPAGE) 2MB pages falling back to normal pages, with Reset() per frame, markers, ArenaScope and
+                    ArenaAllocator for standard containers
+
+    Version 2.21.0  Added MathSIMDPointCloud.h, PointCloudReader maps XYZ, XYZW or binary little endian PLY files and converts
+    17OCT2026       fixed size chunks into aligned SoA PointBlocks on a worker thread, double buffered, prefetching ahead and dropping
+                    converted pages so files larger than RAM stream with bounded memory
+
+    Version 2.22.0  Added MathSIMDAsyncIO.h, AsyncPipeline loads and stores binary King vector files (VectorFileHeader then packed
+    17OCT2026       floats) through io_uring, or blocking reads where it is unavailable, with chunks decoded and transformed on a thread
+                    pool while later chunks are read
+
+    Version 2.23.0  Added MathSIMDDelta.h, Delta::Encode/Decode compress float3, float4 and quat arrays against a baseline, lossless
+    17OCT2026       XOR or quantized zigzag deltas of 4 element SIMD groups with a lane mask, per component bit widths and Elias gamma
+                    runs of unchanged groups
+
+    Version 2.24.0  Added MathSIMDParse.h, Parse(text, length, vector) reads whitespace separated numbers into float, float2, float3
+    17OCT2026       or float4 arrays with SSE2 whitespace skipping and std::from_chars, reporting the offset, line and column of the
+                    first bad token; operator>> for vectors of float2/3/4 delegates to it
+
+    Version 2.25.0  Added MathSIMDColor.h, Color derives from FloatPoint4 with r, g, b, a in x, y, z, w; batch kernels for sRGB
+    17OCT2026       <-> linear, RGBA8 pack and unpack (table decode for sRGB encoded bytes), premultiply and unpremultiply,
+                    RGB <-> HSV (4 wide) and premultiplied Over, Add, Multiply and Screen blending
+
+    Version 2.26.0  Added MathSIMDGeometry2D.h, Rect2D, Circle2D and Segment2D held in one XMVECTOR each and Polygon2D with x and y
+    17OCT2026       arrays padded to 4; batch point and rect queries, circle overlap, segment intersection and distance 4 wide, even-odd
+                    point in polygon 4 edges or 4 points per step, Sutherland-Hodgman clipping against convex polygons and rects and a
+                    separating axis test returning the penetration normal and depth
+
+    Version 2.27.0  Added MathSIMDRectList.h, RectList keeps integer UI rects as padded min and max arrays with z and id and hit tests a
+    17OCT2026       point (or many) four rects per step with SSE2 integer compares returning the topmost rect, plus every hit and rect
+                    queries; DirtyRects merges invalidated rects while the union stays within a slack of their area and caps the count by
+                    merging the pair that grows least
+
+    Version 2.28.0  Added MathSIMDRasterizer.h, Rasterizer bins 2D triangles into square tiles and walks covered rows 4 pixels at a
+    17OCT2026       time with half-space edge functions, worker threads taking one tile at a time; vertices snap to 1/256 pixel so
+                    the edge functions are exact in double precision and with a top-left rule a mesh covers each pixel once; RasterSpan4
+                    carries the coverage mask, barycentric weights and transposed FloatPoint4 attributes, Coverage and TileCoverage
+                    return IntPoint2 pixels and tiles
+
+    Version 2.29.0  Added MathSIMDOcclusion.h, OcclusionBuffer transforms occluder meshes to clip space 4 vertices per step, clips them at
+    17OCT2026       the near plane and draws nearest depth with the tiled Rasterizer into a low resolution buffer; a max depth hierarchy is
+                    built 4 cells per step and world space boxes are projected 4 corners per step and tested against the coarsest level
+                    keeping the box within 8 x 8 cells
+
+    Version 2.30.0  Added MathSIMDVoxel.h, VoxelGrid marks the IntPoint3 voxels a FloatPoint3 triangle mesh touches with a separating axis
+    17OCT2026       test 4 voxels per step, or the voxels inside a closed mesh by parity of crossings rasterized on the y z plane;
+                    SignedDistanceField seeds the voxels near the surface with exact closest points, jump floods them on worker threads 4
+                    voxels per step, signs them with the solid voxelization and samples trilinearly 4 points per step
+
+    Version 2.31.0  Added MathSIMDHashMap.h, IntPoint3HashMap is an open addressing table of 16 slot groups with a control byte per slot
+    17OCT2026       matched a group at a time with SSE2, keyed by a Morton code of the coordinates mixed with their high bits; bulk InsertOrAssign,
+                    find and erase hash a block of keys and prefetch their groups before probing, ForEach walks the slots in memory order;
+                    IntPoint3Hash and IntPoint3Equal for the standard containers
+
+    Version 2.32.0  Added MathSIMDIsoSurface.h, MarchingCubes isosurface extraction over scalar grids
+    17OCT2026       Blocks of cells run on worker threads, edge vertices shared through IntPoint3HashMap
+                    Case table built from cube faces so ambiguous faces match in neighbouring cells
+
+    Version 2.33.0  Added MathSIMDStatistics.h, Covariance3 mean and covariance of FloatPoint3 arrays in one pass
+    17OCT2026       Blocks summed twice while in L1 then merged pairwise; Welford update for single points
+                    Cyclic Jacobi eigen decomposition, principal axes, best-fit planes and lines, oriented boxes
+                    FitPlanes batch over CSR point neighborhoods for surface normals
+
+    Version 2.34.0  Added MathSIMDSVD.h, SVD3 batched 3x3 singular value and polar decomposition
+    17OCT2026       Four matrices at once, one per SIMD lane; branch free Jacobi on AᵀA accumulated as a quaternion then Givens QR (McAdams et al.)
+                    Rotations returned as Quaternion, singular values as FloatPoint3; SymmetricEigen batch for covariance matrices
  
     PROPOSED Version 3 candidate:
                     Breaking change: Remove typedef and replace base class names with adopted names that are typed defined
@@ -153,6 +263,7 @@ using json = nlohmann::json;
 #include <windows.h>
 #include <memory>
 #include <vector>
+#include <string>
 #include <utility>
 #include <DirectXMath.h>
 #include <emmintrin.h> 
@@ -164,6 +275,46 @@ using json = nlohmann::json;
 #include <cstdlib>
 #include <cmath>
 
+// Deterministic float mode
+//  Define KING_MATH_DETERMINISTIC for replays and lockstep simulation that must reproduce bit for bit on any x64 CPU.
+//  Only IEEE exact instructions are used (no reciprocal or sqrt estimates which differ between CPU vendors), a multiply
+//  and add is always two rounded operations and reductions add in a fixed order.  Compile with /fp:precise (MSVC) or
+//  -ffp-contract=off without -ffast-math (GCC/Clang) and without /arch:AVX2, -mfma or -march=native so DirectXMath
+//  takes its SSE2 paths.  GCC contracts a * b + c by default and ignores the STDC pragma, so the header also turns
+//  contraction off for the functions that follow it; build every translation unit with -ffp-contract=off as well.
+//  Scalar transcendentals go through King::Scalar, the DirectXMath polynomials in place of the CRT.
+//  DeterminismSelfTest() checks a build against the golden hashes.
+#if defined(KING_MATH_DETERMINISTIC)
+#if defined(__FAST_MATH__) || defined(_M_FP_FAST) || defined(_M_FP_CONTRACT)
+#error KING_MATH_DETERMINISTIC cannot be built with fast math or floating point contraction
+#endif
+#if defined(_XM_FMA3_INTRINSICS_) || defined(_XM_FMA4_INTRINSICS_) || defined(_XM_AVX2_INTRINSICS_)
+#error KING_MATH_DETERMINISTIC requires XMVectorMultiplyAdd without FMA, build without AVX2/FMA
+#endif
+#if defined(__FMA__) || defined(__FMA4__) || defined(__FP_FAST_FMA) || defined(__FP_FAST_FMAF)
+#error KING_MATH_DETERMINISTIC cannot be built with FMA instructions the compiler may fuse into, build without -mfma or -march=native
+#endif
+#if defined(_XM_SVML_INTRINSICS_)
+#error KING_MATH_DETERMINISTIC requires the DirectXMath polynomials, SVML results differ between versions
+#endif
+#if defined(_XM_SSE4_INTRINSICS_) || defined(_XM_AVX_INTRINSICS_)
+#error KING_MATH_DETERMINISTIC requires the SSE2 dot products, DPPS rounds differently, build without AVX/SSE4
+#endif
+#if defined(_XM_ARM_NEON_INTRINSICS_)
+#error KING_MATH_DETERMINISTIC matches the x64 SSE2 results only, NEON fuses multiply and add
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+#define KING_MATH_EST(function) function // exact in place of the estimate
+#else
+#define KING_MATH_EST(function) function##Est
+#endif
+
 namespace King {
     // Our data types defined:
     // Unique data types built on Single Instruction Multiple Data, SIMD, DirectXMath library of intrinsics 
@@ -187,6 +338,36 @@ namespace King {
     typedef FloatPoint4     float4;
     typedef Quaternion      quat;
 
+    // (x + y) + (z + w) on every target, XMVectorSum adds in another order without intrinsics
+    inline DirectX::XMVECTOR __vectorcall SumComponentsFixedOrder(DirectX::FXMVECTOR v)
+    {
+        const DirectX::XMVECTOR pairs = DirectX::XMVectorAdd(v, DirectX::XMVectorSwizzle<1, 0, 3, 2>(v));
+        return DirectX::XMVectorAdd(pairs, DirectX::XMVectorSwizzle<2, 3, 0, 1>(pairs));
+    }
+
+    // scalar transcendentals; the CRT results differ between libraries, so KING_MATH_DETERMINISTIC builds use the
+    // DirectXMath polynomials made of exact IEEE operations
+    namespace Scalar
+    {
+#if defined(KING_MATH_DETERMINISTIC)
+        inline float ATan2(const float y, const float x) { return DirectX::XMVectorGetX(DirectX::XMVectorATan2(DirectX::XMVectorReplicate(y), DirectX::XMVectorReplicate(x))); }
+        inline float ASin(const float x) { return DirectX::XMScalarASin(x); }
+        inline float ACos(const float x) { return DirectX::XMScalarACos(x); }
+        inline float Sin(const float x) { return DirectX::XMScalarSin(x); }
+        inline float Exp(const float x) { return DirectX::XMVectorGetX(DirectX::XMVectorExpE(DirectX::XMVectorReplicate(x))); }
+        inline float Log(const float x) { return DirectX::XMVectorGetX(DirectX::XMVectorLogE(DirectX::XMVectorReplicate(x))); }
+        inline float Pow(const float x, const float y) { return DirectX::XMVectorGetX(DirectX::XMVectorExp2(DirectX::XMVectorMultiply(DirectX::XMVectorReplicate(y), DirectX::XMVectorLog2(DirectX::XMVectorReplicate(x))))); } // x > 0
+#else
+        inline float ATan2(const float y, const float x) { return std::atan2(y, x); }
+        inline float ASin(const float x) { return std::asin(x); }
+        inline float ACos(const float x) { return std::acos(x); }
+        inline float Sin(const float x) { return std::sin(x); }
+        inline float Exp(const float x) { return std::exp(x); }
+        inline float Log(const float x) { return std::log(x); }
+        inline float Pow(const float x, const float y) { return std::pow(x, y); }
+#endif
+    }
+
     // macros
 #define ISNAN(x)  (bool)((*(const uint32_t*)&(x) & 0x7F800000) == 0x7F800000 && (*(const uint32_t*)&(x) & 0x7FFFFF) != 0)
 
@@ -662,7 +843,7 @@ namespace King {
         inline const DirectX::XMVECTOR&         GetVecConst() const { return v; } // constant type
 
         float virtual                           GetMagnitude() const { return DirectX::XMVectorGetX(DirectX::XMVector2Length(v)); }
-        float virtual                           GetMagnitudeEst() const { return DirectX::XMVectorGetX(DirectX::XMVector2LengthEst(v)); }
+        float virtual                           GetMagnitudeEst() const { return DirectX::XMVectorGetX(DirectX::KING_MATH_EST(XMVector2Length)(v)); }
         // Assignments
         inline void __vectorcall                Set(FloatPoint2 in) noexcept { v = in.v; }
         inline void __vectorcall                Set(DirectX::XMVECTOR in) noexcept { v = in; }
@@ -694,12 +875,12 @@ namespace King {
         // Statics
         static FloatPoint2 __vectorcall         Normal(const FloatPoint2 point2In) { return FloatPoint2(DirectX::XMVector2Normalize(point2In)); }
         static const float __vectorcall         Magnitude(const FloatPoint2 point2In) { return DirectX::XMVectorGetX(DirectX::XMVector2Length(point2In)); }
-        static const float __vectorcall         MagnitudeEst(const FloatPoint2 point2In) { return DirectX::XMVectorGetX(DirectX::XMVector2LengthEst(point2In)); }
+        static const float __vectorcall         MagnitudeEst(const FloatPoint2 point2In) { return DirectX::XMVectorGetX(DirectX::KING_MATH_EST(XMVector2Length)(point2In)); }
         static FloatPoint2 __vectorcall         DotProduct(const FloatPoint2 vec1In, const FloatPoint2 vec2In) { return DirectX::XMVector2Dot(vec1In, vec2In); } // order does not mater A•B = B•A
         static FloatPoint2 __vectorcall         CrossProduct(const FloatPoint2 vec1In, const FloatPoint2 vec2In) { return DirectX::XMVector2Cross(vec1In, vec2In); } // order does mater AxB = -(BxA)
-        static float __vectorcall               SumComponents(const FloatPoint2 vec1In) { return DirectX::XMVectorGetX(DirectX::XMVectorSum(vec1In)); }
+        static float __vectorcall               SumComponents(const FloatPoint2 vec1In) { return DirectX::XMVectorGetX(SumComponentsFixedOrder(vec1In)); }
         static FloatPoint2 __vectorcall         MultiplyAdd(const FloatPoint2 vec1MulIn, const FloatPoint2 & vec2MulIn, const FloatPoint2 & vec3AddIn) { return DirectX::XMVectorMultiplyAdd(vec1MulIn, vec2MulIn, vec3AddIn); }
-        static FloatPoint2                      Average(const std::vector<FloatPoint2> & arrayIn) { assert(arrayIn.size()); FloatPoint2 ave; for (const auto& each : arrayIn) ave += each; ave /= (float)arrayIn.size(); return ave; }
+        static FloatPoint2                      Average(const std::vector<FloatPoint2> & arrayIn) { assert(arrayIn.size()); FloatPoint2 ave; for (const auto& each : arrayIn) ave += each; ave /= (float)arrayIn.size(); return ave; } // summed in index order
     };
     /******************************************************************************
     *   FloatPoint3
@@ -791,7 +972,7 @@ namespace King {
         inline const float2                     GetYZ() const { return float2((float)DirectX::XMVectorGetY(v), (float)DirectX::XMVectorGetZ(v)); }
         inline const float2                     GetXY() const { return float2((float)DirectX::XMVectorGetX(v), (float)DirectX::XMVectorGetY(v)); }
         float virtual                           GetMagnitude() const { return DirectX::XMVectorGetX(DirectX::XMVector3Length(v)); }
-        float virtual                           GetMagnitudeEst() const { return DirectX::XMVectorGetX(DirectX::XMVector3LengthEst(v)); }
+        float virtual                           GetMagnitudeEst() const { return DirectX::XMVectorGetX(DirectX::KING_MATH_EST(XMVector3Length)(v)); }
         // Assignments
         inline void                             SetZ(const float z) { v = DirectX::XMVectorSetZ(v, z); }
 
@@ -821,12 +1002,16 @@ namespace King {
         // Statics
         static FloatPoint3 __vectorcall         Normal(const FloatPoint3 point3In) { return FloatPoint3(DirectX::XMVector3Normalize(point3In.GetVecConst())); }
         static const float __vectorcall         Magnitude(const FloatPoint3 point3In) { return DirectX::XMVectorGetX(DirectX::XMVector3Length(point3In.GetVecConst())); }
-        static const float __vectorcall         MagnitudeEst(const FloatPoint3 point3In) { return DirectX::XMVectorGetX(DirectX::XMVector3LengthEst(point3In.GetVecConst())); }
+        static const float __vectorcall         MagnitudeEst(const FloatPoint3 point3In) { return DirectX::XMVectorGetX(DirectX::KING_MATH_EST(XMVector3Length)(point3In.GetVecConst())); }
         static FloatPoint3 __vectorcall         DotProduct(const FloatPoint3 vec1In, const FloatPoint3 vec2In) { return DirectX::XMVector3Dot(vec1In, vec2In); } // order does not mater A•B = B•A
         static FloatPoint3 __vectorcall         CrossProduct(const FloatPoint3 vec1In, const FloatPoint3 vec2In) { return FloatPoint3( DirectX::XMVector3Cross(vec1In, vec2In)); } // order does mater AxB = -(BxA) // note: this is LHS for DirectX, swap the terms for RHS
-        static float __vectorcall               SumComponents(const FloatPoint3 vec1In) { return DirectX::XMVectorGetX(DirectX::XMVectorSum(vec1In)); }
+        static float __vectorcall               SumComponents(const FloatPoint3 vec1In) { return DirectX::XMVectorGetX(SumComponentsFixedOrder(vec1In)); }
         static FloatPoint3 __vectorcall         MultiplyAdd(const FloatPoint3 vec1MulIn, const FloatPoint3 vec2MulIn, const FloatPoint3 vec3AddIn) { return DirectX::XMVectorMultiplyAdd(vec1MulIn, vec2MulIn, vec3AddIn); }
-        static FloatPoint3                      Average(const std::vector<FloatPoint3> & arrayIn) { assert(arrayIn.size()); FloatPoint3 ave; for (const auto& each : arrayIn) ave += each; ave /= (float)arrayIn.size(); return ave; }
+        static FloatPoint3                      Average(const std::vector<FloatPoint3> & arrayIn) { assert(arrayIn.size()); FloatPoint3 ave; for (const auto& each : arrayIn) ave += each; ave /= (float)arrayIn.size(); return ave; } // summed in index order
+        static void                             OrthonormalBasis(const FloatPoint3 normalIn, FloatPoint3* tangentOut, FloatPoint3* bitangentOut); // normalIn unit length, branchless (Frisvad, Duff et al.)
+        static void                             OrthonormalBasis(const FloatPoint3* normalsIn, FloatPoint3* tangentsOut, FloatPoint3* bitangentsOut, size_t count); // batch, 4 wide
+        static void                             Orthonormalize(FloatPoint3& xInOut, FloatPoint3& yInOut, FloatPoint3& zOut); // Gram-Schmidt, x keeps direction, z = x cross y
+        static void                             Orthonormalize(FloatPoint3* xInOut, FloatPoint3* yInOut, FloatPoint3* zOut, size_t count); // batch, 4 wide
     };
     /******************************************************************************
     *   FloatPoint4
@@ -954,9 +1139,9 @@ namespace King {
         static const float __vectorcall         Magnitude(const FloatPoint4 point4In) { return DirectX::XMVectorGetX(DirectX::XMVector4Length(point4In.GetVecConst())); }
         static FloatPoint4 __vectorcall         DotProduct(const FloatPoint4 vec1In, const FloatPoint4 & vec2In) { return DirectX::XMVector4Dot(vec1In, vec2In); } // order does not mater A•B = B•A
         static FloatPoint4 __vectorcall         CrossProduct(const FloatPoint4 vec1In, const FloatPoint4 & vec2In, const FloatPoint4 & vec3In) { return DirectX::XMVector4Cross(vec1In, vec2In, vec3In); } // order does mater AxB = -(BxA) // note: this is LHS for DirectX, swap the terms for RHS
-        static float __vectorcall               SumComponents(const FloatPoint4 vec1In) { return DirectX::XMVectorGetX(DirectX::XMVectorSum(vec1In)); }
+        static float __vectorcall               SumComponents(const FloatPoint4 vec1In) { return DirectX::XMVectorGetX(SumComponentsFixedOrder(vec1In)); }
         static FloatPoint4 __vectorcall         MultiplyAdd(const FloatPoint4 vec1MulIn, const FloatPoint4 & vec2MulIn, const FloatPoint4 & vec3AddIn) { return DirectX::XMVectorMultiplyAdd(vec1MulIn, vec2MulIn, vec3AddIn); }
-        static FloatPoint4                      Average(const std::vector<FloatPoint4> arrayIn) { assert(arrayIn.size()); FloatPoint4 ave; for (const auto& each : arrayIn) ave += each; ave /= (float)arrayIn.size(); return ave; }
+        static FloatPoint4                      Average(const std::vector<FloatPoint4> & arrayIn) { assert(arrayIn.size()); FloatPoint4 ave; for (const auto& each : arrayIn) ave += each; ave /= (float)arrayIn.size(); return ave; } // summed in index order
 
     };
     /******************************************************************************
@@ -1035,10 +1220,24 @@ namespace King {
         inline Quaternion   Inverse() const { return Quaternion(DirectX::XMQuaternionInverse(v)); }
         DirectX::XMFLOAT3   GetEulerAngles() const;
         DirectX::XMFLOAT3   CalculateAngularVelocity(const Quaternion previousRotation, float deltaTime) const;
+        Quaternion          Exp() const; // e^w * (cos|xyz|, sin|xyz| * xyz/|xyz|)
+        Quaternion          Log() const; // (θ * xyz/|xyz|, ln|q|), unit quaternion returns half the rotation vector
+        inline Quaternion   Pow(const float exponent) const { auto l = Log(); l.v = DirectX::XMVectorScale(l.v, exponent); return l.Exp(); } // fraction of the rotation for unit quaternions
+        void                Integrate(const float3 & angularVelocity, float deltaTime); // rotate by ω * Δt, radians per second
         void                Validate() noexcept { if (DirectX::XMQuaternionIsNaN(v)) v = DirectX::XMQuaternionIdentity(); }
+        // Statics
+        static void         CalculateAngularVelocity(const Quaternion* currentRotationsIn, const Quaternion* previousRotationsIn, float3* angularVelocitiesOut, size_t count, float deltaTime); // batch, 4 wide
+        static std::vector<float3> CalculateAngularVelocity(const std::vector<Quaternion>& currentRotationsIn, const std::vector<Quaternion>& previousRotationsIn, float deltaTime) { assert(currentRotationsIn.size() == previousRotationsIn.size()); std::vector<float3> out(currentRotationsIn.size()); CalculateAngularVelocity(currentRotationsIn.data(), previousRotationsIn.data(), out.data(), out.size(), deltaTime); return out; }
+        static void         Exp(const Quaternion* quaternionsIn, Quaternion* quaternionsOut, size_t count); // batch, 4 wide, in and out may alias
+        static void         Log(const Quaternion* quaternionsIn, Quaternion* quaternionsOut, size_t count); // batch, 4 wide, in and out may alias
+        static void         Pow(const Quaternion* quaternionsIn, float exponent, Quaternion* quaternionsOut, size_t count); // batch, 4 wide, in and out may alias
+        static void         Integrate(Quaternion* rotationsInOut, const float3* angularVelocitiesIn, size_t count, float deltaTime); // batch, 4 wide
+        static void         ShortestArc(const float3* vFromIn, const float3* vToIn, Quaternion* rotationsOut, size_t count); // batch, 4 wide, same as Set(vFrom, vTo)
+        static std::vector<Quaternion> ShortestArc(const std::vector<float3>& vFromIn, const std::vector<float3>& vToIn) { assert(vFromIn.size() == vToIn.size()); std::vector<Quaternion> out(vFromIn.size()); ShortestArc(vFromIn.data(), vToIn.data(), out.data(), out.size()); return out; }
+        static void         LookRotation(const float3* forwardsIn, const float3* upsIn, Quaternion* rotationsOut, size_t count); // batch, 4 wide, same as SetLookRotation(forward, up)
         // Accessors
         inline float3       GetAxis() const { float3 xyz = v; xyz.MakeNormalize(); return xyz; } // since v.xyz = N * sin(angle / 2), we can just re-normalized to retrieve the axis
-        inline float        GetAngleEuler() const { auto a = std::atan2(DirectX::XMVectorGetX(DirectX::XMVector3Length(v)), DirectX::XMVectorGetW(v)); return a; } // [-π , +π] radians; euler angle about the axis
+        inline float        GetAngleEuler() const { auto a = Scalar::ATan2(DirectX::XMVectorGetX(DirectX::XMVector3Length(v)), DirectX::XMVectorGetW(v)); return a; } // [-π , +π] radians; euler angle about the axis
         inline float        GetAngleQuaternion() const { auto a = 2.0f * DirectX::XMScalarACos(GetW()); return a; } // [0 , +π] radians; quternion angle about the axis
         [[deprecated("GetAngleQuaternion() or GetAngleEuler() instead")]]
         inline float        GetAngle() const { auto a = 2.0f * DirectX::XMScalarACos(GetW()); return a; } // [0 , +π] radians; quternion angle about the axis
@@ -1050,6 +1249,7 @@ namespace King {
         inline void         SetEulerAngles(const float3 & eulerAngles) { v = DirectX::XMQuaternionRotationRollPitchYawFromVector(eulerAngles); }
         inline void         Set(const Quaternion & qIn) noexcept { v = qIn; Validate(); }
         void                Set(const float3 &vFrom, const float3 &vTo);
+        void                SetLookRotation(const float3 & forward, const float3 & up); // rotates +z to forward with +y toward up
     };
 
     /******************************************************************************
@@ -1112,7 +1312,7 @@ namespace King {
 #define MAKE_SIMD_FUNCS( Type ) \
     inline Type __vectorcall Sqrt( Type s ) { return Type(XMVectorSqrt(s)); } \
     inline Type __vectorcall Recip( Type s ) { return Type(XMVectorReciprocal(s)); } \
-    inline Type __vectorcall RecipSqrt( Type s ) { return Type(XMVectorReciprocalSqrtEst(s)); } \
+    inline Type __vectorcall RecipSqrt( Type s ) { return Type(KING_MATH_EST(XMVectorReciprocalSqrt)(s)); } \
     inline Type __vectorcall Floor( Type s ) { return Type(XMVectorFloor(s)); } \
     inline Type __vectorcall Ceiling( Type s ) { return Type(XMVectorCeiling(s)); } \
     inline Type __vectorcall Round( Type s ) { return Type(XMVectorRound(s)); } \
@@ -1139,6 +1339,14 @@ namespace King {
     inline FloatPoint2 __vectorcall Normalize(const FloatPoint2 vec1In) { return FloatPoint2(DirectX::XMVector2Normalize(vec1In)); }
     inline FloatPoint3 __vectorcall Normalize(const FloatPoint3 vec1In) { return FloatPoint3(DirectX::XMVector3Normalize(vec1In)); }
     inline FloatPoint4 __vectorcall Normalize(const FloatPoint4 vec1In) { return FloatPoint4(DirectX::XMVector4Normalize(vec1In)); }
+
+    DirectX::XMMATRIX __vectorcall LookRotationMatrix(const FloatPoint3 forward, const FloatPoint3 up); // rows right, up, forward; inverse of the XMMatrixLookToLH rotation
+    void LookRotationMatrix(const FloatPoint3* forwardsIn, const FloatPoint3* upsIn, DirectX::XMMATRIX* matricesOut, size_t count); // batch, 4 wide
+    void LookAtMatrix(const FloatPoint3* eyesIn, const FloatPoint3* targetsIn, const FloatPoint3* upsIn, DirectX::XMMATRIX* viewMatricesOut, size_t count); // batch XMMatrixLookAtLH, 4 wide
+
+    inline Quaternion __vectorcall Exp(const Quaternion q) { return q.Exp(); } // exact match so a Quaternion does not convert to the float4 Exp()
+    inline Quaternion __vectorcall Log(const Quaternion q) { return q.Log(); }
+    inline Quaternion __vectorcall Pow(const Quaternion q, const float exponent) { return q.Pow(exponent); }
            
     inline UIntPoint2 Min(const UIntPoint2& a, const UIntPoint2& b) { return UIntPoint2((a.u[0] < b.u[0]) ? a.u[0] : b.u[0], (a.u[1] < b.u[1]) ? a.u[1] : b.u[1]); }
     inline UIntPoint2 Max(const UIntPoint2& a, const UIntPoint2& b) { return UIntPoint2((a.u[0] > b.u[0]) ? a.u[0] : b.u[0], (a.u[1] > b.u[1]) ? a.u[1] : b.u[1]); }
@@ -1200,139 +1408,75 @@ namespace King {
     void from_json(const json& j, FloatPoint4& to);
     void from_json(const json& j, Quaternion& to);
 
+    /******************************************************************************
+    *   Determinism
+    *       FNV-1a 64 of the component bits (no vtable or padding) so a replay can
+    *       be compared to golden hashes frame by frame
+    ******************************************************************************/
+    constexpr uint64_t HashSeed = 14695981039346656037ull;
+    uint64_t HashBits(const void* bytesIn, size_t size, uint64_t hash = HashSeed);
+    uint64_t Hash(const FloatPoint2* in, size_t count, uint64_t hash = HashSeed);
+    uint64_t Hash(const FloatPoint3* in, size_t count, uint64_t hash = HashSeed);
+    uint64_t Hash(const FloatPoint4* in, size_t count, uint64_t hash = HashSeed);
+    uint64_t Hash(const Quaternion* in, size_t count, uint64_t hash = HashSeed);
+    template<class T> inline uint64_t Hash(const std::vector<T>& in, uint64_t hash = HashSeed) { return Hash(in.data(), in.size(), hash); }
+    // recomputes the golden hashes of fixed inputs through Normalize, GetMagnitudeEst, RecipSqrt, Average and
+    // SumComponents; they match in KING_MATH_DETERMINISTIC builds only, the names of failed cases are appended
+    bool DeterminismSelfTest(std::vector<std::string>* failuresOut = nullptr);
+
 
     /******************************************************************************
     *   SystemInfo
-    *       Class for identifying the CPU and capabilities of the system
-    *
+    *       Identifies the CPU, its topology and caches, memory and graphics card
+    *       and returns them as data so thread pools and the block sizes of batch
+    *       kernels can be tuned on the machine they run on
     ******************************************************************************/
+    struct CacheInfo
+    {
+        unsigned                                level = 0;          // 1, 2, 3
+        char                                    type = 'U';         // 'D'ata, 'I'nstruction or 'U'nified
+        size_t                                  size = 0;           // bytes of one instance
+        size_t                                  lineSize = 0;       // bytes
+        unsigned                                associativity = 0;  // ways, 0 if unknown or fully associative
+        unsigned                                sharedBy = 0;       // logical processors sharing one instance
+    };
+    struct CpuTopology
+    {
+        std::string                             vendor;
+        std::string                             brand;
+        unsigned                                logicalProcessors = 0;
+        unsigned                                physicalCores = 0;
+        unsigned                                packages = 0;
+        unsigned                                threadsPerCore = 1; // SMT siblings of each core
+        unsigned                                numaNodes = 1;
+        std::vector<std::vector<unsigned>>      numaNodeProcessors; // logical processor ids of each node
+        std::vector<unsigned>                   numaNodeIds;        // OS node number of each entry, ids may be sparse
+        std::vector<CacheInfo>                  caches;             // one entry per level and type
+        size_t                                  cacheLineSize = 64;
+        std::string                             source;             // where the topology came from: sysfs, windows or cpuid
+    };
+
     class SystemInfo 
     {
     public:
-        inline void GetSystemInfoToCout();
-    private:
-        inline void GetCPUInfoToCout();
-        inline void GetInstalledMemoryToCout();
-        inline void GetGraphicsCardInfoToCout();
+        void GetSystemInfoToCout();
+        // topology is discovered once (sysfs on Linux, GetLogicalProcessorInformationEx on Windows, CPUID leaf 4/0x8000001D
+        // and 0xB to fill what the OS did not report) and the same data is returned after that
+        static const CpuTopology&               GetTopology();
+        static size_t                           GetCacheSize(const unsigned level, const char type = 'D'); // data or unified, 0 if none
+        static inline size_t                    GetCacheLineSize() { return GetTopology().cacheLineSize; }
+        static inline unsigned                  GetLogicalProcessorCount() { return GetTopology().logicalProcessors; }
+        static inline unsigned                  GetPhysicalCoreCount() { return GetTopology().physicalCores; }
+        static inline unsigned                  GetNumaNodeCount() { return GetTopology().numaNodes; }
+        static uint64_t                         GetInstalledMemory(); // bytes
+        static std::string                      GetGraphicsCardName(); // Linux reports the PCI vendor:device and driver
+        // peak memory bandwidth in bytes per second, measured once with streaming SIMD reads unless set from the
+        // installed memory (channels * MT/s * 8 bytes) which the OS does not report without elevated rights
+        static double                           GetMemoryBandwidth();
+        static void                             SetMemoryBandwidth(const double bytesPerSecond);
     };
 
-    inline void SystemInfo::GetSystemInfoToCout() { GetCPUInfoToCout(); GetInstalledMemoryToCout(); GetGraphicsCardInfoToCout(); }
-
-#if defined(__GNUC__) || defined(__clang__)
-    // For GCC and Clang
-    inline void GetCPUInfoToCout() {
-        unsigned int eax, ebx, ecx, edx;
-        __asm__ __volatile__("cpuid"
-            : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
-            : "a"(1), "c"(0));
-
-        // Check CPU capabilities based on the values in eax, ebx, ecx, and edx
-        // Interpret the values as needed for your application
-        std::cout << "CPU capabilities for GCC/Clang:\n"
-            << "EAX: " << eax << "\n"
-            << "EBX: " << ebx << "\n"
-            << "ECX: " << ecx << "\n"
-            << "EDX: " << edx << "\n";
-    }
-#elif defined(_MSC_VER)
-    // For Visual Studio
-#include <intrin.h>
-    inline void GetCPUInfoToCout() {
-        int info[4];
-        __cpuid(info, 1);
-
-        // Check CPU capabilities based on the values in info
-        // Interpret the values as needed for your application
-        std::cout << "CPU capabilities for Visual Studio:\n"
-            << "EAX: " << info[0] << "\n"
-            << "EBX: " << info[1] << "\n"
-            << "ECX: " << info[2] << "\n"
-            << "EDX: " << info[3] << "\n";
-    }
-#else
-    inline void GetCPUInfo() {
-        std::cout << "CPU capabilities not supported for this compiler\n";
-    }
-#endif
-
-#if defined(_WIN32) || defined(_WIN64)
-    // For Windows
-    inline void SystemInfo::GetInstalledMemoryToCout() {
-        // Windows-specific installed memory retrieval (e.g., using Windows API)
-        MEMORYSTATUSEX memoryStatus;
-        memoryStatus.dwLength = sizeof(memoryStatus);
-
-        if (GlobalMemoryStatusEx(&memoryStatus))
-            std::cout << "Total Installed Memory (Windows): " << memoryStatus.ullTotalPhys / 1024 / 1024 << " MB\n";
-        else
-            std::cout << "Unable to retrieve installed memory information on Windows\n";
-    }
-    inline void SystemInfo::GetGraphicsCardInfoToCout() {
-        // Windows-specific graphics card info retrieval (e.g., using Windows API)
-        DISPLAY_DEVICE displayDevice;
-        displayDevice.cb = sizeof(DISPLAY_DEVICE);
-
-        if (EnumDisplayDevices(nullptr, 0, &displayDevice, 0))
-            std::cout << "Graphics Card Name (Windows): " << displayDevice.DeviceString << "\n";
-        else
-            std::cout << "Unable to retrieve graphics card information on Windows\n";
-    }
-
-#elif defined(__linux__)
-    // For Linux
-#include <fstream>
-#include <sstream>
-    inline void SystemInfo::GetInstalledMemoryToCout() {
-        // Linux-specific installed memory retrieval (e.g., reading /proc/meminfo)
-        std::ifstream meminfo("/proc/meminfo");
-        std::string line;
-
-        while (std::getline(meminfo, line)) {
-            std::istringstream iss(line);
-            std::string token, value;
-
-            if (iss >> token >> value && token == "MemTotal:") {
-                // Total installed memory is in kilobytes
-                std::cout << "Total Installed Memory (Linux): " << value / 1024 << " MB\n";
-                break;
-            }
-        }
-
-        meminfo.close();
-    }
-    inline void SystemInfo::GetGraphicsCardInfoToCout() {
-        // Linux-specific graphics card info retrieval (e.g., parsing lspci)
-        std::ifstream lspci("/usr/sbin/lspci -v");
-
-        if (lspci.is_open()) {
-            std::string line;
-
-            while (std::getline(lspci, line)) {
-                // Look for lines containing "VGA" to identify the graphics card
-                if (line.find("VGA") != std::string::npos) {
-                    std::cout << "Graphics Card Name (Linux): " << line << "\n";
-                    break;
-                }
-            }
-
-            lspci.close();
-        }
-        else {
-            std::cout << "Unable to retrieve graphics card information on Linux\n";
-        }
-    }
-
-#else
-    // Default case for unsupported platforms
-    inline void SystemInfo::GetCPUInfoToCout() {
-        std::cout << "CPU information not supported for this platform\n";
-    }
-    inline void SystemInfo::GetInstalledMemoryToCout() {
-        std::cout << "Installed memory information not supported for this platform\n";
-    }
-    inline void SystemInfo::GetGraphicsCardInfoToCout() {
-        std::cout << "Graphics card information not supported for this platform\n";
-    }
-#endif
+    void to_json(json& j, const CacheInfo& from);
+    void to_json(json& j, const CpuTopology& from);
 
 } // Kind namespace
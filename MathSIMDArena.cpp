@@ -0,0 +1,123 @@
+﻿#include "MathSIMDArena.h"
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace King;
+using namespace std;
+
+namespace
+{
+    inline size_t RoundUp(const size_t bytes, const size_t granule) { return (bytes + granule - 1) / granule * granule; }
+
+#if !defined(_WIN32)
+    size_t NormalPageSize() { return static_cast<size_t>(sysconf(_SC_PAGESIZE)); }
+
+    // over maps by one huge page and trims so the mapping starts and ends on 2MB boundaries
+    char* MapAligned(const size_t bytes)
+    {
+        const size_t over = bytes + Arena::HugePageSize;
+        void* address = mmap(nullptr, over, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED)
+            return nullptr;
+        char* raw = static_cast<char*>(address);
+        char* aligned = reinterpret_cast<char*>(RoundUp(reinterpret_cast<uintptr_t>(raw), Arena::HugePageSize));
+        if (aligned > raw)
+            munmap(raw, aligned - raw);
+        const size_t tail = (raw + over) - (aligned + bytes);
+        if (tail)
+            munmap(aligned + bytes, tail);
+        return aligned;
+    }
+#endif
+}
+
+void King::Arena::Create(const size_t capacityIn, const Pages pagesIn)
+{
+    Destroy();
+    if (capacityIn == 0)
+        return;
+    char* address = nullptr;
+    Pages got = Pages::Normal;
+    size_t bytes = 0;
+#if defined(_WIN32)
+    // large pages need SeLockMemoryPrivilege and are committed up front; Windows has no transparent huge pages
+    const size_t largePage = GetLargePageMinimum();
+    if (pagesIn == Pages::Explicit && largePage)
+    {
+        bytes = RoundUp(capacityIn, largePage);
+        address = static_cast<char*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+        if (address)
+            got = Pages::Explicit;
+    }
+    if (!address)
+    {
+        bytes = RoundUp(capacityIn, 1ull << 16);
+        address = static_cast<char*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    }
+#else
+#if defined(MAP_HUGETLB)
+    // needs pages reserved in /proc/sys/vm/nr_hugepages
+    if (pagesIn == Pages::Explicit)
+    {
+        bytes = RoundUp(capacityIn, HugePageSize);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_2MB)
+        flags |= MAP_HUGE_2MB;
+#endif
+        void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (mapping != MAP_FAILED)
+        {
+            address = static_cast<char*>(mapping);
+            got = Pages::Explicit;
+        }
+    }
+#endif
+#if defined(MADV_HUGEPAGE)
+    // transparent huge pages when /sys/kernel/mm/transparent_hugepage/enabled is madvise or always
+    if (!address && pagesIn != Pages::Normal)
+    {
+        bytes = RoundUp(capacityIn, HugePageSize);
+        address = MapAligned(bytes);
+        if (address && madvise(address, bytes, MADV_HUGEPAGE) == 0)
+            got = Pages::Transparent;
+    }
+#endif
+    if (!address)
+    {
+        bytes = RoundUp(capacityIn, NormalPageSize());
+        void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        address = mapping == MAP_FAILED ? nullptr : static_cast<char*>(mapping);
+    }
+#endif
+    if (!address)
+        throw std::bad_alloc();
+    base = address;
+    capacity = capacityIn;
+    mapped = bytes;
+    offset = peak = 0;
+    pages = got;
+}
+
+void King::Arena::Destroy()
+{
+    if (!base)
+        return;
+#if defined(_WIN32)
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    munmap(base, mapped);
+#endif
+    base = nullptr;
+    capacity = mapped = offset = peak = 0;
+    pages = Pages::Normal;
+}
+
+void King::Arena::Touch()
+{
+    // one write per 4KB covers every page size; the byte is read and written back so live allocations keep their data
+    volatile char* p = reinterpret_cast<volatile char*>(base);
+    for (size_t i = 0; i < mapped; i += 4096)
+        p[i] = p[i];
+}
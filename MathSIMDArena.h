@@ -0,0 +1,166 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDArena
+
+Description:    Linear arena for bulk temporary geometry backed by 2MB huge
+                pages.  Hundreds of MB of per frame transform buffers on 4KB
+                pages need tens of thousands of TLB entries; on 2MB pages a few
+                hundred.  Explicit huge pages (MAP_HUGETLB, MEM_LARGE_PAGES)
+                are tried first when asked for, then transparent huge pages
+                (2MB aligned mapping with madvise MADV_HUGEPAGE), then normal
+                pages, so the arena always works and GetPages() tells what it
+                got.  Allocation is a pointer bump; Reset() frees the frame.
+
+                    static King::Arena frame(512ull << 20);
+                    frame.Reset();
+                    float3* world = frame.Allocate<float3>(n);
+                    std::vector<quat, King::ArenaAllocator<quat>> rotations(n, frame);
+
+                Destructors are not run by Reset(), the King vector types hold
+                no resources.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <new>
+#include <cstdint>
+
+namespace King {
+
+    /******************************************************************************
+    *   Arena
+    ******************************************************************************/
+    class Arena
+    {
+    public:
+        enum class Pages { Normal, Transparent, Explicit };
+        static const size_t                     HugePageSize = 2ull << 20;
+
+        /* variables */
+    private:
+        char*                                   base = nullptr;
+        size_t                                  capacity = 0;
+        size_t                                  mapped = 0;         // bytes of the mapping, capacity rounded to its page size
+        size_t                                  offset = 0;
+        size_t                                  peak = 0;
+        Pages                                   pages = Pages::Normal;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        Arena() = default;
+        explicit Arena(const size_t capacityIn, const Pages pagesIn = Pages::Transparent) { Create(capacityIn, pagesIn); }
+        Arena(const Arena&) = delete;
+        Arena(Arena&& in) noexcept { *this = std::move(in); }
+        ~Arena() { Destroy(); }
+        // Operators
+        Arena& operator= (const Arena&) = delete;
+        Arena& operator= (Arena&& in) noexcept
+        {
+            if (this != &in)
+            {
+                Destroy();
+                std::swap(base, in.base); std::swap(capacity, in.capacity); std::swap(mapped, in.mapped);
+                std::swap(offset, in.offset); std::swap(peak, in.peak); std::swap(pages, in.pages);
+            }
+            return *this;
+        }
+        // Functionality
+        void                                    Create(const size_t capacityIn, const Pages pagesIn = Pages::Transparent); // throws bad_alloc
+        void                                    Destroy();
+        // bump allocation, throws bad_alloc when the arena is full
+        inline void*                            Allocate(const size_t bytes, const size_t alignment = 16)
+        {
+            assert(alignment && (alignment & (alignment - 1)) == 0);
+            const size_t start = (offset + alignment - 1) & ~(alignment - 1);
+            if (start > capacity || bytes > capacity - start)
+                throw std::bad_alloc();
+            offset = start + bytes;
+            peak = std::max(peak, offset);
+            return base + start;
+        }
+        // constructed elements, aligned for the type
+        template<class T>
+        inline T*                               Allocate(const size_t count, const T& value = T())
+        {
+            if (count > SIZE_MAX / sizeof(T))
+                throw std::bad_alloc();
+            T* elements = static_cast<T*>(Allocate(count * sizeof(T), std::max<size_t>(alignof(T), 16)));
+            for (size_t i = 0; i < count; ++i)
+                new (&elements[i]) T(value);
+            return elements;
+        }
+        inline void                             Reset() { offset = 0; } // frame scoped, memory stays mapped
+        inline size_t                           GetMarker() const { return offset; }
+        inline void                             Rollback(const size_t marker) { assert(marker <= offset); offset = marker; }
+        void                                    Touch(); // faults every page in so the first frame does not, contents are kept so it is safe after Allocate
+        // Accessors
+        inline Pages                            GetPages() const { return pages; }
+        inline bool                             IsHugePageBacked() const { return pages != Pages::Normal; }
+        inline size_t                           GetCapacity() const { return capacity; }
+        inline size_t                           GetUsed() const { return offset; }
+        inline size_t                           GetAvailable() const { return capacity - offset; }
+        inline size_t                           GetPeak() const { return peak; } // most used since Create
+        inline bool                             Owns(const void* p) const { return p >= base && p < base + capacity; }
+    };
+    /******************************************************************************
+    *   ArenaScope
+    *       Rolls the arena back to where it was when the scope began
+    ******************************************************************************/
+    class ArenaScope
+    {
+    public:
+        inline explicit ArenaScope(Arena& arenaIn) : arena(arenaIn), marker(arenaIn.GetMarker()) {}
+        inline ~ArenaScope() { arena.Rollback(marker); }
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator= (const ArenaScope&) = delete;
+    private:
+        Arena&                                  arena;
+        const size_t                            marker;
+    };
+    /******************************************************************************
+    *   ArenaAllocator
+    *       Standard allocator so containers can live in an arena, deallocate
+    *       is a no-op until the arena is reset
+    ******************************************************************************/
+    template<class T>
+    class ArenaAllocator
+    {
+    public:
+        typedef T                               value_type;
+        Arena*                                  arena;
+
+        inline ArenaAllocator(Arena& arenaIn) noexcept : arena(&arenaIn) {}
+        template<class U>
+        inline ArenaAllocator(const ArenaAllocator<U>& in) noexcept : arena(in.arena) {}
+        inline T*                               allocate(const size_t count) { if (count > SIZE_MAX / sizeof(T)) throw std::bad_alloc(); return static_cast<T*>(arena->Allocate(count * sizeof(T), std::max<size_t>(alignof(T), 16))); }
+        inline void                             deallocate(T*, size_t) noexcept {}
+        template<class U>
+        inline bool                             operator== (const ArenaAllocator<U>& rhs) const { return arena == rhs.arena; }
+        template<class U>
+        inline bool                             operator!= (const ArenaAllocator<U>& rhs) const { return arena != rhs.arena; }
+    };
+}
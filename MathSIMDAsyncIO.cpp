@@ -0,0 +1,655 @@
+﻿#include "MathSIMDAsyncIO.h"
+#include "MathSIMDInstrument.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <new>
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace King;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    // io_uring takes a 32 bit length per read or write, chunks stay below 4GB in whole 4KB pages
+    const size_t MaxChunkBytes = static_cast<size_t>(UINT32_MAX) & ~size_t(4095);
+
+    bool SeekFile(FILE* file, const uint64_t offset)
+    {
+#if defined(_MSC_VER)
+        return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    FILE* OpenFile(const std::string& fileName, const char* mode)
+    {
+        FILE* file = nullptr;
+#if defined(_MSC_VER)
+        if (fopen_s(&file, fileName.c_str(), mode) != 0)
+            return nullptr;
+#else
+        file = fopen(fileName.c_str(), mode);
+#endif
+        return file;
+    }
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    /******************************************************************************
+    *   Ring
+    *       Submission and completion queues shared with the kernel
+    ******************************************************************************/
+    struct Ring
+    {
+        int                                     fd = -1;
+        unsigned                                entries = 0;
+        unsigned*                               sqHead = nullptr;
+        unsigned*                               sqTail = nullptr;
+        unsigned                                sqMask = 0;
+        unsigned*                               sqArray = nullptr;
+        io_uring_sqe*                           sqes = nullptr;
+        unsigned*                               cqHead = nullptr;
+        unsigned*                               cqTail = nullptr;
+        unsigned                                cqMask = 0;
+        io_uring_cqe*                           cqes = nullptr;
+        void*                                   sqRing = MAP_FAILED;
+        void*                                   cqRing = MAP_FAILED;
+        size_t                                  sqRingBytes = 0;
+        size_t                                  cqRingBytes = 0;
+        size_t                                  sqesBytes = 0;
+
+        ~Ring() { Destroy(); }
+
+        bool Create(const unsigned entriesIn)
+        {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entriesIn, &params));
+            if (fd < 0)
+                return false;
+            entries = params.sq_entries;
+            sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single)
+                sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+            sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sqRing == MAP_FAILED)
+                return Destroy();
+            cqRing = single ? sqRing : mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED)
+                return Destroy();
+            sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqeMemory = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if (sqeMemory == MAP_FAILED)
+                return Destroy();
+            sqes = static_cast<io_uring_sqe*>(sqeMemory);
+
+            char* sq = static_cast<char*>(sqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            char* cq = static_cast<char*>(cqRing);
+            cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            return true;
+        }
+
+        bool Destroy()
+        {
+            if (sqes)
+                munmap(sqes, sqesBytes);
+            if (cqRing != MAP_FAILED && cqRing != sqRing)
+                munmap(cqRing, cqRingBytes);
+            if (sqRing != MAP_FAILED)
+                munmap(sqRing, sqRingBytes);
+            if (fd >= 0)
+                close(fd);
+            sqes = nullptr;
+            sqRing = cqRing = MAP_FAILED;
+            fd = -1;
+            return false;
+        }
+
+        bool Push(const uint8_t opcode, const int file, void* data, const unsigned bytes, const uint64_t offset, const uint64_t tag)
+        {
+            const unsigned tail = *sqTail; // only this thread moves the tail
+            const unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            if (tail - head >= entries)
+                return false;
+            const unsigned index = tail & sqMask;
+            io_uring_sqe& sqe = sqes[index];
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = opcode;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<uint64_t>(data);
+            sqe.len = bytes;
+            sqe.off = offset;
+            sqe.user_data = tag;
+            sqArray[index] = index;
+            __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+            return syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0) >= 0;
+        }
+
+        bool Pop(uint64_t* tag, int64_t* result)
+        {
+            for (;;)
+            {
+                const unsigned head = *cqHead;
+                const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+                if (head != tail)
+                {
+                    const io_uring_cqe& cqe = cqes[head & cqMask];
+                    *tag = cqe.user_data;
+                    *result = cqe.res;
+                    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                    return true;
+                }
+                if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                    return false;
+            }
+        }
+    };
+#endif
+
+    /******************************************************************************
+    *   IoQueue
+    *       Positional reads or writes of one file; io_uring completes them in
+    *       the background, the blocking backend completes them on Submit
+    ******************************************************************************/
+    class IoQueue
+    {
+    public:
+        ~IoQueue() { Close(); }
+
+        bool Open(const std::string& fileName, const bool writeIn, const bool useRing, const unsigned entries)
+        {
+            write = writeIn;
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+            if (useRing)
+            {
+                fd = write ? open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : open(fileName.c_str(), O_RDONLY);
+                if (fd < 0)
+                    return false;
+                if (ring.Create(entries))
+                    return true;
+                close(fd);
+                fd = -1;
+            }
+#else
+            (void)useRing; (void)entries;
+#endif
+            file = OpenFile(fileName, write ? "wb" : "rb");
+            return file != nullptr;
+        }
+
+        void Close()
+        {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+            ring.Destroy();
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+#endif
+            if (file)
+                fclose(file);
+            file = nullptr;
+        }
+
+        bool Submit(const uint64_t tag, uint8_t* data, const size_t bytes, const uint64_t offset)
+        {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+            assert(bytes <= MaxChunkBytes); // the SQE length is 32 bits
+            if (fd >= 0)
+                return ring.Push(static_cast<uint8_t>(write ? IORING_OP_WRITE : IORING_OP_READ), fd, data, static_cast<unsigned>(bytes), offset, tag);
+#endif
+            completed.emplace_back(tag, Sync(data, bytes, offset) ? static_cast<int64_t>(bytes) : -1);
+            return true;
+        }
+
+        bool Wait(uint64_t* tag, int64_t* result)
+        {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+            if (fd >= 0)
+                return ring.Pop(tag, result);
+#endif
+            if (completed.empty())
+                return false;
+            *tag = completed.front().first;
+            *result = completed.front().second;
+            completed.pop_front();
+            return true;
+        }
+
+        // blocking transfer of the whole range, also finishes short or refused (older kernel) ring requests
+        bool Sync(uint8_t* data, const size_t bytes, const uint64_t offset)
+        {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+            if (fd >= 0)
+            {
+                for (size_t done = 0; done < bytes;)
+                {
+                    const ssize_t n = write ? pwrite(fd, data + done, bytes - done, static_cast<off_t>(offset + done)) : pread(fd, data + done, bytes - done, static_cast<off_t>(offset + done));
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        return false;
+                    done += static_cast<size_t>(n);
+                }
+                return true;
+            }
+#endif
+            if (!file || !SeekFile(file, offset))
+                return false;
+            return (write ? fwrite(data, 1, bytes, file) : fread(data, 1, bytes, file)) == bytes;
+        }
+
+    private:
+        bool                                    write = false;
+        FILE*                                   file = nullptr;
+        std::deque<std::pair<uint64_t, int64_t>> completed;
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+        int                                     fd = -1;
+        Ring                                    ring;
+#endif
+    };
+
+    struct Job
+    {
+        int                                     buffer = 0;
+        uint64_t                                offset = 0;     // relative to the range
+        size_t                                  bytes = 0;
+    };
+
+    /******************************************************************************
+    *   StagePool
+    *       Decode or encode threads, finished jobs return their buffer
+    ******************************************************************************/
+    class StagePool
+    {
+    public:
+        StagePool(const unsigned threadCount, std::function<void(const Job&)> workIn) : work(std::move(workIn))
+        {
+            for (unsigned t = 0; t < threadCount; ++t)
+                threads.emplace_back(&StagePool::Run, this);
+        }
+        ~StagePool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            condition.notify_all();
+            for (auto& thread : threads)
+                thread.join();
+        }
+        void Push(const Job& job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queued.push_back(job);
+                ++busy;
+            }
+            condition.notify_all();
+        }
+        bool TryPop(Job* job)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return PopLocked(job);
+        }
+        Job WaitPop()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return !finished.empty(); });
+            Job job;
+            PopLocked(&job);
+            return job;
+        }
+        inline unsigned Busy() const { return busy; } // calling thread only
+        inline std::exception_ptr GetError() const { return error; }
+
+    private:
+        bool PopLocked(Job* job)
+        {
+            if (finished.empty())
+                return false;
+            *job = finished.front();
+            finished.pop_front();
+            --busy;
+            return true;
+        }
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                condition.wait(lock, [this]() { return stop || !queued.empty(); });
+                if (stop)
+                    return;
+                const Job job = queued.front();
+                queued.pop_front();
+                lock.unlock();
+                std::exception_ptr failure;
+                try { work(job); }
+                catch (...) { failure = std::current_exception(); }
+                lock.lock();
+                if (failure && !error)
+                    error = failure;
+                finished.push_back(job);
+                condition.notify_all();
+            }
+        }
+
+        std::function<void(const Job&)>         work;
+        std::vector<std::thread>                threads;
+        std::mutex                              mutex;
+        std::condition_variable                 condition;
+        std::deque<Job>                         queued;
+        std::deque<Job>                         finished;
+        unsigned                                busy = 0;
+        bool                                    stop = false;
+        std::exception_ptr                      error;
+    };
+
+    // 16 byte aligned chunk buffers so the decoders can use aligned loads
+    struct Buffers
+    {
+        struct AlignedDelete { void operator() (uint8_t* p) const { ::operator delete(p, std::align_val_t{ 16 }); } };
+        std::vector<std::unique_ptr<uint8_t, AlignedDelete>> memory;
+        Buffers(const unsigned count, const size_t bytes) { for (unsigned i = 0; i < count; ++i) memory.emplace_back(static_cast<uint8_t*>(::operator new(std::max<size_t>(16, bytes), std::align_val_t{ 16 }))); }
+        inline uint8_t* operator[] (const int i) { return memory[i].get(); }
+    };
+
+    template<class T> struct VectorTraits;
+    template<> struct VectorTraits<float2>
+    {
+        static const VectorFileType type = VectorFileType::Float2;
+        static const uint32_t components = 2;
+        static inline void Decode(const float* from, float2& to) { to = XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(from)); }
+        static inline void Encode(const float2& from, float* to) { XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(to), from); }
+    };
+    template<> struct VectorTraits<float3>
+    {
+        static const VectorFileType type = VectorFileType::Float3;
+        static const uint32_t components = 3;
+        static inline void Decode(const float* from, float3& to) { to = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(from)); }
+        static inline void Encode(const float3& from, float* to) { XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(to), from); }
+    };
+    template<> struct VectorTraits<float4>
+    {
+        static const VectorFileType type = VectorFileType::Float4;
+        static const uint32_t components = 4;
+        static inline void Decode(const float* from, float4& to) { to = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(from)); }
+        static inline void Encode(const float4& from, float* to) { XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(to), from); }
+    };
+    template<> struct VectorTraits<Quaternion>
+    {
+        static const VectorFileType type = VectorFileType::Quaternion;
+        static const uint32_t components = 4;
+        static inline void Decode(const float* from, Quaternion& to) { to = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(from)); }
+        static inline void Encode(const Quaternion& from, float* to) { XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(to), from); }
+    };
+
+    uint64_t FileSize(const std::string& fileName)
+    {
+        FILE* file = OpenFile(fileName, "rb");
+        if (!file)
+            return 0;
+#if defined(_MSC_VER)
+        _fseeki64(file, 0, SEEK_END);
+        const uint64_t size = static_cast<uint64_t>(_ftelli64(file));
+#else
+        fseeko(file, 0, SEEK_END);
+        const uint64_t size = static_cast<uint64_t>(ftello(file));
+#endif
+        fclose(file);
+        return size;
+    }
+
+    template<class T>
+    bool LoadVectors(AsyncPipeline& pipeline, const std::string& fileName, std::vector<T>& out, const std::function<void(T*, size_t)>& transform)
+    {
+        typedef VectorTraits<T> Traits;
+        VectorFileHeader header;
+        if (!AsyncPipeline::ReadHeader(fileName, &header) || header.type != Traits::type || header.components != Traits::components)
+            return false;
+        const size_t elementBytes = Traits::components * sizeof(float);
+        // count comes from the file, a size that wraps would pass the file size test and be under-read
+        if (header.count > (SIZE_MAX - sizeof(header)) / elementBytes || FileSize(fileName) < sizeof(header) + header.count * elementBytes)
+            return false;
+        out.clear();
+        out.resize(static_cast<size_t>(header.count));
+        T* elements = out.data();
+        return pipeline.Read(fileName, sizeof(header), header.count * elementBytes, [elements, elementBytes, &transform](uint64_t offset, const uint8_t* data, size_t bytes)
+        {
+            const size_t first = static_cast<size_t>(offset / elementBytes);
+            const size_t count = bytes / elementBytes;
+            for (size_t i = 0; i < count; ++i)
+                Traits::Decode(reinterpret_cast<const float*>(data + i * elementBytes), elements[first + i]);
+            if (transform)
+                transform(elements + first, count);
+        }, elementBytes);
+    }
+
+    template<class T>
+    bool StoreVectors(AsyncPipeline& pipeline, const std::string& fileName, const T* in, const size_t count)
+    {
+        typedef VectorTraits<T> Traits;
+        assert(in || count == 0);
+        VectorFileHeader header;
+        header.type = Traits::type;
+        header.components = Traits::components;
+        header.count = count;
+        const size_t elementBytes = Traits::components * sizeof(float);
+        return pipeline.Write(fileName, &header, sizeof(header), count * elementBytes, [in, elementBytes](uint64_t offset, uint8_t* data, size_t bytes)
+        {
+            const size_t first = static_cast<size_t>(offset / elementBytes);
+            for (size_t i = 0; i < bytes / elementBytes; ++i)
+                Traits::Encode(in[first + i], reinterpret_cast<float*>(data + i * elementBytes));
+        }, elementBytes);
+    }
+}
+
+/******************************************************************************
+*   AsyncPipeline
+******************************************************************************/
+King::AsyncPipeline::AsyncPipeline(const Backend backendIn, const size_t chunkBytesIn, const unsigned depthIn, const unsigned threadsIn) :
+    backend(backendIn),
+    chunkBytes(std::min<size_t>(std::max<size_t>(4096, chunkBytesIn), MaxChunkBytes)),
+    depth(std::max(2u, depthIn)),
+    threads(threadsIn ? threadsIn : std::max(1u, SystemInfo::GetLogicalProcessorCount() - 1))
+{
+    if (backend != Backend::Threads)
+        backend = IsIoUringAvailable() ? Backend::IoUring : Backend::Threads;
+}
+
+bool King::AsyncPipeline::IsIoUringAvailable()
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    static const bool available = []() { Ring ring; return ring.Create(2); }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+bool King::AsyncPipeline::ReadHeader(const std::string& fileName, VectorFileHeader* headerOut)
+{
+    assert(headerOut);
+    FILE* file = OpenFile(fileName, "rb");
+    if (!file)
+        return false;
+    const bool read = fread(headerOut, sizeof(VectorFileHeader), 1, file) == 1;
+    fclose(file);
+    return read && headerOut->IsValid();
+}
+
+bool King::AsyncPipeline::Read(const std::string& fileName, const uint64_t offset, const uint64_t bytes, const ReadStage& stage, const size_t granule)
+{
+    KING_MATH_COUNT("AsyncPipeline::Read", bytes);
+    IoQueue queue;
+    if (!queue.Open(fileName, false, backend == Backend::IoUring, depth))
+        return false;
+    const size_t chunk = std::max(granule, chunkBytes / granule * granule);
+    Buffers buffers(depth, chunk);
+    std::vector<Job> submitted(depth);
+    std::vector<int> idle;
+    for (unsigned b = 0; b < depth; ++b)
+        idle.push_back(static_cast<int>(b));
+    StagePool pool(threads, [&buffers, &stage](const Job& job) { stage(job.offset, buffers[job.buffer], job.bytes); });
+
+    // reads stay queued on every idle buffer, each completion goes straight to the decode threads
+    uint64_t next = 0;
+    unsigned inFlight = 0;
+    bool ok = true;
+    while (ok)
+    {
+        while (!idle.empty() && next < bytes)
+        {
+            Job job;
+            job.buffer = idle.back();
+            job.offset = next;
+            job.bytes = static_cast<size_t>(std::min<uint64_t>(chunk, bytes - next));
+            if (!queue.Submit(static_cast<uint64_t>(job.buffer), buffers[job.buffer], job.bytes, offset + job.offset))
+            {
+                ok = false;
+                break;
+            }
+            idle.pop_back();
+            submitted[job.buffer] = job;
+            next += job.bytes;
+            ++inFlight;
+        }
+        Job done;
+        if (!ok)
+            break;
+        else if (pool.TryPop(&done))
+            idle.push_back(done.buffer);
+        else if (inFlight)
+        {
+            uint64_t tag;
+            int64_t result;
+            if (!queue.Wait(&tag, &result))
+            {
+                ok = false;
+                break;
+            }
+            --inFlight;
+            const Job& job = submitted[tag];
+            if (result != static_cast<int64_t>(job.bytes) && !queue.Sync(buffers[job.buffer], job.bytes, offset + job.offset))
+                ok = false;
+            else
+                pool.Push(job);
+        }
+        else if (pool.Busy())
+            idle.push_back(pool.WaitPop().buffer);
+        else
+            break;
+    }
+    // the kernel may still be writing into the buffers
+    int64_t ignored;
+    for (uint64_t tag; inFlight && queue.Wait(&tag, &ignored); --inFlight) {}
+    while (pool.Busy())
+        pool.WaitPop();
+    if (pool.GetError())
+        std::rethrow_exception(pool.GetError());
+    return ok && next == bytes;
+}
+
+bool King::AsyncPipeline::Write(const std::string& fileName, const void* header, const size_t headerBytes, const uint64_t bytes, const WriteStage& stage, const size_t granule)
+{
+    KING_MATH_COUNT("AsyncPipeline::Write", bytes);
+    IoQueue queue;
+    if (!queue.Open(fileName, true, backend == Backend::IoUring, depth))
+        return false;
+    if (headerBytes && !queue.Sync(static_cast<uint8_t*>(const_cast<void*>(header)), headerBytes, 0))
+        return false;
+    const size_t chunk = std::max(granule, chunkBytes / granule * granule);
+    Buffers buffers(depth, chunk);
+    std::vector<Job> submitted(depth);
+    std::vector<int> idle;
+    for (unsigned b = 0; b < depth; ++b)
+        idle.push_back(static_cast<int>(b));
+    StagePool pool(threads, [&buffers, &stage](const Job& job) { stage(job.offset, buffers[job.buffer], job.bytes); });
+
+    // idle buffers are produced on the pool, produced buffers are written while more are produced
+    uint64_t next = 0;
+    unsigned inFlight = 0;
+    bool ok = true;
+    auto submit = [&](const Job& job)
+    {
+        submitted[job.buffer] = job;
+        if (queue.Submit(static_cast<uint64_t>(job.buffer), buffers[job.buffer], job.bytes, headerBytes + job.offset))
+            ++inFlight;
+        else
+            ok = false;
+    };
+    while (ok)
+    {
+        while (!idle.empty() && next < bytes)
+        {
+            Job job;
+            job.buffer = idle.back();
+            job.offset = next;
+            job.bytes = static_cast<size_t>(std::min<uint64_t>(chunk, bytes - next));
+            idle.pop_back();
+            pool.Push(job);
+            next += job.bytes;
+        }
+        Job done;
+        if (pool.TryPop(&done))
+            submit(done);
+        else if (inFlight)
+        {
+            uint64_t tag;
+            int64_t result;
+            if (!queue.Wait(&tag, &result))
+            {
+                ok = false;
+                break;
+            }
+            --inFlight;
+            const Job& job = submitted[tag];
+            if (result != static_cast<int64_t>(job.bytes) && !queue.Sync(buffers[job.buffer], job.bytes, headerBytes + job.offset))
+                ok = false;
+            idle.push_back(job.buffer);
+        }
+        else if (pool.Busy())
+            submit(pool.WaitPop());
+        else
+            break;
+    }
+    int64_t ignored;
+    for (uint64_t tag; inFlight && queue.Wait(&tag, &ignored); --inFlight) {}
+    while (pool.Busy())
+        pool.WaitPop();
+    if (pool.GetError())
+        std::rethrow_exception(pool.GetError());
+    return ok && next == bytes;
+}
+
+bool King::AsyncPipeline::Load(const std::string& fileName, std::vector<float2>& out, const std::function<void(float2*, size_t)>& transform) { return LoadVectors(*this, fileName, out, transform); }
+bool King::AsyncPipeline::Load(const std::string& fileName, std::vector<float3>& out, const std::function<void(float3*, size_t)>& transform) { return LoadVectors(*this, fileName, out, transform); }
+bool King::AsyncPipeline::Load(const std::string& fileName, std::vector<float4>& out, const std::function<void(float4*, size_t)>& transform) { return LoadVectors(*this, fileName, out, transform); }
+bool King::AsyncPipeline::Load(const std::string& fileName, std::vector<Quaternion>& out, const std::function<void(Quaternion*, size_t)>& transform) { return LoadVectors(*this, fileName, out, transform); }
+bool King::AsyncPipeline::Store(const std::string& fileName, const float2* in, const size_t count) { return StoreVectors(*this, fileName, in, count); }
+bool King::AsyncPipeline::Store(const std::string& fileName, const float3* in, const size_t count) { return StoreVectors(*this, fileName, in, count); }
+bool King::AsyncPipeline::Store(const std::string& fileName, const float4* in, const size_t count) { return StoreVectors(*this, fileName, in, count); }
+bool King::AsyncPipeline::Store(const std::string& fileName, const Quaternion* in, const size_t count) { return StoreVectors(*this, fileName, in, count); }
@@ -0,0 +1,110 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDAsyncIO
+
+Description:    Asynchronous load and store of binary King vector files so
+                multi-GB geometry is decoded and transformed while the rest of
+                it is still being read.  A fixed number of chunk buffers cycle
+                between the I/O queue and a pool of decode threads: io_uring on
+                Linux (raw system calls, no liburing), or blocking reads on the
+                calling thread where io_uring is missing or refused, which still
+                overlaps decoding with reading.
+
+                    King::AsyncPipeline pipeline;
+                    std::vector<King::float3> points;
+                    pipeline.Load("mesh.kvec", points, [&](King::float3* p, size_t n)
+                        { for (size_t i = 0; i < n; ++i) p[i] = p[i] * world; });
+
+                File layout, little endian: a 32 byte VectorFileHeader then
+                packed components (2, 3 or 4 floats per element, no padding).
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <string>
+#include <functional>
+
+namespace King {
+
+    enum class VectorFileType : uint32_t { Float2 = 1, Float3 = 2, Float4 = 3, Quaternion = 4 };
+
+    struct VectorFileHeader
+    {
+        char                                    magic[4] = { 'K', 'V', 'E', 'C' };
+        uint32_t                                version = 1;
+        VectorFileType                          type = VectorFileType::Float3;
+        uint32_t                                components = 3;         // floats per element
+        uint64_t                                count = 0;              // elements
+        uint64_t                                reserved = 0;
+
+        inline bool                             IsValid() const { return magic[0] == 'K' && magic[1] == 'V' && magic[2] == 'E' && magic[3] == 'C' && version == 1 && components >= 2 && components <= 4; }
+    };
+    static_assert(sizeof(VectorFileHeader) == 32, "VectorFileHeader is stored as is");
+
+    /******************************************************************************
+    *   AsyncPipeline
+    ******************************************************************************/
+    class AsyncPipeline
+    {
+    public:
+        enum class Backend { Auto, IoUring, Threads };
+        // on decode threads, chunks of one call may run concurrently and finish out of order; offsets are relative to the range
+        typedef std::function<void(uint64_t offset, const uint8_t* data, size_t bytes)>   ReadStage;
+        typedef std::function<void(uint64_t offset, uint8_t* data, size_t bytes)>         WriteStage;
+
+        /* variables */
+    private:
+        Backend                                 backend;
+        size_t                                  chunkBytes;
+        unsigned                                depth;                  // buffers in flight between I/O and decode
+        unsigned                                threads;                // decode threads
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        // chunkBytesIn is clamped to [4KB, 4GB - 4KB], one io_uring read or write per chunk
+        explicit AsyncPipeline(const Backend backendIn = Backend::Auto, const size_t chunkBytesIn = 4ull << 20, const unsigned depthIn = 4, const unsigned threadsIn = 0);
+        // Functionality
+        // stage runs for every chunk of [offset, offset + bytes) as soon as it is read; chunks are multiples of granule bytes
+        bool                                    Read(const std::string& fileName, const uint64_t offset, const uint64_t bytes, const ReadStage& stage, const size_t granule = 1);
+        // writes header synchronously, then bytes of body produced by stage a chunk at a time with writes overlapping production
+        bool                                    Write(const std::string& fileName, const void* header, const size_t headerBytes, const uint64_t bytes, const WriteStage& stage, const size_t granule = 1);
+        // elements are decoded and passed to transform on the decode threads while later chunks are read
+        bool                                    Load(const std::string& fileName, std::vector<float2>& out, const std::function<void(float2*, size_t)>& transform = nullptr);
+        bool                                    Load(const std::string& fileName, std::vector<float3>& out, const std::function<void(float3*, size_t)>& transform = nullptr);
+        bool                                    Load(const std::string& fileName, std::vector<float4>& out, const std::function<void(float4*, size_t)>& transform = nullptr);
+        bool                                    Load(const std::string& fileName, std::vector<Quaternion>& out, const std::function<void(Quaternion*, size_t)>& transform = nullptr);
+        bool                                    Store(const std::string& fileName, const float2* in, const size_t count);
+        bool                                    Store(const std::string& fileName, const float3* in, const size_t count);
+        bool                                    Store(const std::string& fileName, const float4* in, const size_t count);
+        bool                                    Store(const std::string& fileName, const Quaternion* in, const size_t count);
+        static bool                             ReadHeader(const std::string& fileName, VectorFileHeader* headerOut);
+        // Accessors
+        inline Backend                          GetBackend() const { return backend; } // resolved, never Auto
+        inline size_t                           GetChunkBytes() const { return chunkBytes; }
+        static bool                             IsIoUringAvailable();
+    };
+}
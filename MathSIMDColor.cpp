@@ -0,0 +1,325 @@
+﻿#include "MathSIMDColor.h"
+#include "MathSIMDInstrument.h"
+#include <array>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Streams
+******************************************************************************/
+std::ostream& King::operator<< (std::ostream& os, const King::Color& in) { return os << "{ " << "r: " << setw(9) << std::setprecision( 6 ) << in.f[0] << " g: " << setw(9) << in.f[1] << " b: " << setw(9) << in.f[2] << " a: " << setw(9) << in.f[3] << " }"; }
+std::wostream& King::operator<< (std::wostream& os, const King::Color& in) { return os << L"{ " << L"r: " << setw(9) << in.f[0] << L" g: " << setw(9) << in.f[1] << L" b: " << setw(9) << in.f[2] << L" a: " << setw(9) << in.f[3] << L" }"; }
+std::istream& King::operator>> (std::istream& is, Color& in) { DirectX::XMFLOAT4 f; is >> f.x >> f.y >> f.z >> f.w; in.Set(f); return is; }
+
+/******************************************************************************
+*   json
+******************************************************************************/
+void King::to_json(json& j, const Color& from) { j = json{ {"r", from.f[0]}, {"g", from.f[1]}, {"b", from.f[2]}, {"a", from.f[3]} }; }
+void King::from_json(const json& j, Color& to) { j.at("r").get_to(to.f[0]); j.at("g").get_to(to.f[1]); j.at("b").get_to(to.f[2]); j.at("a").get_to(to.f[3]); }
+
+/******************************************************************************
+*   Helpers
+*       Transfer functions and HSV on whole vectors, the HSV forms work on four
+*       colors transposed into r's, g's, b's and a's
+******************************************************************************/
+namespace
+{
+    // x^e for x > 0, lanes at or below zero are not used by the callers
+    inline DirectX::XMVECTOR __vectorcall PowPositive(DirectX::FXMVECTOR x, const float e) { using namespace DirectX; return XMVectorExp2(XMVectorMultiply(XMVectorLog2(x), XMVectorReplicate(e))); }
+
+    // IEC 61966-2-1 piecewise curve on r, g and b
+    inline DirectX::XMVECTOR __vectorcall SRGBToLinearVector(DirectX::FXMVECTOR c)
+    {
+        using namespace DirectX;
+        const XMVECTOR linear = XMVectorScale(c, 1.0f / 12.92f);
+        const XMVECTOR curve = PowPositive(XMVectorMultiplyAdd(c, XMVectorReplicate(1.0f / 1.055f), XMVectorReplicate(0.055f / 1.055f)), 2.4f);
+        const XMVECTOR rgb = XMVectorSelect(curve, linear, XMVectorLessOrEqual(c, XMVectorReplicate(0.04045f)));
+        return XMVectorSelect(c, rgb, g_XMSelect1110);
+    }
+
+    inline DirectX::XMVECTOR __vectorcall LinearToSRGBVector(DirectX::FXMVECTOR c)
+    {
+        using namespace DirectX;
+        const XMVECTOR linear = XMVectorScale(c, 12.92f);
+        const XMVECTOR curve = XMVectorMultiplyAdd(PowPositive(c, 1.0f / 2.4f), XMVectorReplicate(1.055f), XMVectorReplicate(-0.055f));
+        const XMVECTOR rgb = XMVectorSelect(curve, linear, XMVectorLessOrEqual(c, XMVectorReplicate(0.0031308f)));
+        return XMVectorSelect(c, rgb, g_XMSelect1110);
+    }
+
+    inline __m128i __vectorcall ToBytes(DirectX::FXMVECTOR c) { using namespace DirectX; return _mm_cvtps_epi32(XMVectorMultiply(XMVectorSaturate(c), XMVectorReplicate(255.0f))); } // rounds to nearest
+
+    // four colors to four RGBA8, r in the low byte
+    inline __m128i __vectorcall PackRGBA8x4(DirectX::FXMVECTOR c0, DirectX::FXMVECTOR c1, DirectX::FXMVECTOR c2, DirectX::GXMVECTOR c3)
+    {
+        return _mm_packus_epi16(_mm_packs_epi32(ToBytes(c0), ToBytes(c1)), _mm_packs_epi32(ToBytes(c2), ToBytes(c3)));
+    }
+
+    inline DirectX::XMVECTOR __vectorcall FromBytes(const __m128i rgba) { using namespace DirectX; return XMVectorDivide(_mm_cvtepi32_ps(rgba), XMVectorReplicate(255.0f)); } // exact c / 255, the reciprocal is an ulp off for half the values
+
+    inline DirectX::XMMATRIX __vectorcall RGBToHSVTransposed(DirectX::FXMMATRIX m)
+    {
+        using namespace DirectX;
+        const XMVECTOR zero = XMVectorZero();
+        const XMVECTOR maxc = XMVectorMax(m.r[0], XMVectorMax(m.r[1], m.r[2]));
+        const XMVECTOR minc = XMVectorMin(m.r[0], XMVectorMin(m.r[1], m.r[2]));
+        const XMVECTOR delta = XMVectorSubtract(maxc, minc);
+        const XMVECTOR gray = XMVectorLessOrEqual(delta, zero);
+        const XMVECTOR inverseDelta = XMVectorReciprocal(XMVectorSelect(delta, XMVectorSplatOne(), gray));
+        // sector from the largest channel, red wins ties so gray and pure red agree
+        const XMVECTOR hr = XMVectorMultiply(XMVectorSubtract(m.r[1], m.r[2]), inverseDelta);
+        const XMVECTOR hg = XMVectorMultiplyAdd(XMVectorSubtract(m.r[2], m.r[0]), inverseDelta, XMVectorReplicate(2.0f));
+        const XMVECTOR hb = XMVectorMultiplyAdd(XMVectorSubtract(m.r[0], m.r[1]), inverseDelta, XMVectorReplicate(4.0f));
+        XMVECTOR h = XMVectorSelect(hb, hg, XMVectorEqual(maxc, m.r[1]));
+        h = XMVectorSelect(h, hr, XMVectorEqual(maxc, m.r[0]));
+        h = XMVectorScale(h, 1.0f / 6.0f);
+        h = XMVectorSelect(h, XMVectorAdd(h, XMVectorSplatOne()), XMVectorLess(h, zero));
+        h = XMVectorSelect(h, zero, gray);
+        const XMVECTOR s = XMVectorSelect(zero, XMVectorDivide(delta, maxc), XMVectorGreater(maxc, zero));
+        XMMATRIX hsv;
+        hsv.r[0] = h;
+        hsv.r[1] = s;
+        hsv.r[2] = maxc;
+        hsv.r[3] = m.r[3];
+        return hsv;
+    }
+
+    inline DirectX::XMMATRIX __vectorcall HSVToRGBTransposed(DirectX::FXMMATRIX m)
+    {
+        using namespace DirectX;
+        const XMVECTOR one = XMVectorSplatOne();
+        const XMVECTOR h = XMVectorSubtract(m.r[0], XMVectorFloor(m.r[0])); // wrap to [0, 1]
+        const XMVECTOR s = m.r[1];
+        const XMVECTOR value = m.r[2];
+        const XMVECTOR h6 = XMVectorScale(h, 6.0f);
+        const XMVECTOR sector = XMVectorFloor(h6); // 6 when h wrapped to 1, which falls through to sector 0 with f of 0
+        const XMVECTOR f = XMVectorSubtract(h6, sector);
+        const XMVECTOR p = XMVectorMultiply(value, XMVectorSubtract(one, s));
+        const XMVECTOR q = XMVectorMultiply(value, XMVectorNegativeMultiplySubtract(s, f, one));
+        const XMVECTOR t = XMVectorMultiply(value, XMVectorNegativeMultiplySubtract(s, XMVectorSubtract(one, f), one));
+        XMVECTOR r = value, g = t, b = p;
+        XMVECTOR in = XMVectorEqual(sector, XMVectorReplicate(1.0f));
+        r = XMVectorSelect(r, q, in); g = XMVectorSelect(g, value, in); b = XMVectorSelect(b, p, in);
+        in = XMVectorEqual(sector, XMVectorReplicate(2.0f));
+        r = XMVectorSelect(r, p, in); g = XMVectorSelect(g, value, in); b = XMVectorSelect(b, t, in);
+        in = XMVectorEqual(sector, XMVectorReplicate(3.0f));
+        r = XMVectorSelect(r, p, in); g = XMVectorSelect(g, q, in); b = XMVectorSelect(b, value, in);
+        in = XMVectorEqual(sector, XMVectorReplicate(4.0f));
+        r = XMVectorSelect(r, t, in); g = XMVectorSelect(g, p, in); b = XMVectorSelect(b, value, in);
+        in = XMVectorEqual(sector, XMVectorReplicate(5.0f));
+        r = XMVectorSelect(r, value, in); g = XMVectorSelect(g, p, in); b = XMVectorSelect(b, q, in);
+        XMMATRIX rgb;
+        rgb.r[0] = r;
+        rgb.r[1] = g;
+        rgb.r[2] = b;
+        rgb.r[3] = m.r[3];
+        return rgb;
+    }
+
+    template<class T>
+    inline DirectX::XMMATRIX __vectorcall LoadTransposed4(const T* in, size_t index, size_t count)
+    {
+        DirectX::XMMATRIX m;
+        for (size_t j = 0; j < 4; ++j)
+            m.r[j] = (index + j < count) ? in[index + j].GetVecConst() : DirectX::XMVectorZero();
+        return DirectX::XMMatrixTranspose(m);
+    }
+
+    template<class T>
+    inline void __vectorcall StoreTransposed4(T* out, size_t index, size_t count, DirectX::FXMMATRIX soa)
+    {
+        auto m = DirectX::XMMatrixTranspose(soa);
+        for (size_t j = 0; j < 4 && index + j < count; ++j)
+            out[index + j] = m.r[j];
+    }
+
+    inline DirectX::XMVECTOR __vectorcall BlendVector(DirectX::FXMVECTOR s, DirectX::FXMVECTOR d, const Color::BlendMode mode)
+    {
+        using namespace DirectX;
+        switch (mode)
+        {
+        case Color::BlendMode::Add:
+            return XMVectorSaturate(XMVectorAdd(s, d));
+        case Color::BlendMode::Multiply:
+            // s * d + s * (1 - da) + d * (1 - sa), alpha works out to sa + da - sa * da
+            return XMVectorNegativeMultiplySubtract(d, XMVectorSplatW(s), XMVectorNegativeMultiplySubtract(s, XMVectorSplatW(d), XMVectorMultiplyAdd(s, d, XMVectorAdd(s, d))));
+        case Color::BlendMode::Screen:
+            return XMVectorNegativeMultiplySubtract(s, d, XMVectorAdd(s, d));
+        case Color::BlendMode::Over:
+        default:
+            return XMVectorNegativeMultiplySubtract(d, XMVectorSplatW(s), XMVectorAdd(s, d));
+        }
+    }
+
+    // one pass per mode so the switch stays out of the loop
+    template<Color::BlendMode Mode>
+    inline void BlendArray(const Color* srcIn, const Color* dstIn, Color* colorsOut, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            colorsOut[i] = BlendVector(srcIn[i], dstIn[i], Mode);
+    }
+
+    // sRGB encoded byte to linear, built on first use
+    const float* SRGBToLinearTable()
+    {
+        static const auto table = []()
+        {
+            std::array<float, 256> t;
+            for (size_t i = 0; i < t.size(); ++i)
+            {
+                const float c = static_cast<float>(i) / 255.0f;
+                t[i] = c <= 0.04045f ? c / 12.92f : Scalar::Pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return t;
+        }();
+        return table.data();
+    }
+}
+
+/******************************************************************************
+*   Color
+******************************************************************************/
+Color __vectorcall King::Color::ToLinear() const { return Color(SRGBToLinearVector(v)); }
+
+Color __vectorcall King::Color::ToSRGB() const { return Color(LinearToSRGBVector(v)); }
+
+Color __vectorcall King::Color::ToHSV() const
+{
+    DirectX::XMMATRIX m;
+    m.r[0] = m.r[1] = m.r[2] = m.r[3] = v;
+    return Color(DirectX::XMMatrixTranspose(RGBToHSVTransposed(DirectX::XMMatrixTranspose(m))).r[0]);
+}
+
+Color __vectorcall King::Color::ToRGB() const
+{
+    DirectX::XMMATRIX m;
+    m.r[0] = m.r[1] = m.r[2] = m.r[3] = v;
+    return Color(DirectX::XMMatrixTranspose(HSVToRGBTransposed(DirectX::XMMatrixTranspose(m))).r[0]);
+}
+
+uint32_t __vectorcall King::Color::PackRGBA8() const
+{
+    const __m128i words = _mm_packs_epi32(ToBytes(v), ToBytes(v));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+}
+
+Color King::Color::UnpackRGBA8(const uint32_t rgba8)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return Color(FromBytes(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(rgba8)), zero), zero)));
+}
+
+Color __vectorcall King::Color::Unpremultiply() const
+{
+    using namespace DirectX;
+    const XMVECTOR a = XMVectorSplatW(v);
+    const XMVECTOR rgb = XMVectorSelect(XMVectorZero(), XMVectorDivide(v, a), XMVectorGreater(a, XMVectorZero()));
+    return Color(XMVectorSelect(v, rgb, g_XMSelect1110));
+}
+
+Color __vectorcall King::Color::Blend(const Color src, const Color dst, const BlendMode mode) { return Color(BlendVector(src, dst, mode)); }
+
+void King::Color::SRGBToLinear(const Color* colorsIn, Color* colorsOut, size_t count)
+{
+    KING_MATH_COUNT("Color::SRGBToLinear(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        colorsOut[i] = SRGBToLinearVector(colorsIn[i]);
+}
+
+void King::Color::LinearToSRGB(const Color* colorsIn, Color* colorsOut, size_t count)
+{
+    KING_MATH_COUNT("Color::LinearToSRGB(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        colorsOut[i] = LinearToSRGBVector(colorsIn[i]);
+}
+
+void King::Color::PackRGBA8(const Color* colorsIn, uint32_t* rgba8Out, size_t count)
+{
+    KING_MATH_COUNT("Color::PackRGBA8(batch)", count);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba8Out + i), PackRGBA8x4(colorsIn[i], colorsIn[i + 1], colorsIn[i + 2], colorsIn[i + 3]));
+    for (; i < count; ++i)
+        rgba8Out[i] = colorsIn[i].PackRGBA8();
+}
+
+void King::Color::UnpackRGBA8(const uint32_t* rgba8In, Color* colorsOut, size_t count)
+{
+    KING_MATH_COUNT("Color::UnpackRGBA8(batch)", count);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba8In + i));
+        const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        colorsOut[i] = FromBytes(_mm_unpacklo_epi16(lo, zero));
+        colorsOut[i + 1] = FromBytes(_mm_unpackhi_epi16(lo, zero));
+        colorsOut[i + 2] = FromBytes(_mm_unpacklo_epi16(hi, zero));
+        colorsOut[i + 3] = FromBytes(_mm_unpackhi_epi16(hi, zero));
+    }
+    for (; i < count; ++i)
+        colorsOut[i] = UnpackRGBA8(rgba8In[i]);
+}
+
+void King::Color::DecodeSRGBA8(const uint32_t* srgba8In, Color* linearOut, size_t count)
+{
+    KING_MATH_COUNT("Color::DecodeSRGBA8(batch)", count);
+    const float* table = SRGBToLinearTable();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t c = srgba8In[i];
+        linearOut[i] = DirectX::XMVectorSet(table[c & 0xFF], table[(c >> 8) & 0xFF], table[(c >> 16) & 0xFF], static_cast<float>(c >> 24) / 255.0f);
+    }
+}
+
+void King::Color::EncodeSRGBA8(const Color* linearIn, uint32_t* srgba8Out, size_t count)
+{
+    KING_MATH_COUNT("Color::EncodeSRGBA8(batch)", count);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(srgba8Out + i), PackRGBA8x4(LinearToSRGBVector(linearIn[i]), LinearToSRGBVector(linearIn[i + 1]), LinearToSRGBVector(linearIn[i + 2]), LinearToSRGBVector(linearIn[i + 3])));
+    for (; i < count; ++i)
+        srgba8Out[i] = linearIn[i].ToSRGB().PackRGBA8();
+}
+
+void King::Color::Premultiply(const Color* colorsIn, Color* colorsOut, size_t count)
+{
+    KING_MATH_COUNT("Color::Premultiply(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        colorsOut[i] = colorsIn[i].Premultiply();
+}
+
+void King::Color::Unpremultiply(const Color* colorsIn, Color* colorsOut, size_t count)
+{
+    KING_MATH_COUNT("Color::Unpremultiply(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        colorsOut[i] = colorsIn[i].Unpremultiply();
+}
+
+void King::Color::RGBToHSV(const Color* colorsIn, Color* hsvOut, size_t count)
+{
+    KING_MATH_COUNT("Color::RGBToHSV(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+        StoreTransposed4(hsvOut, i, count, RGBToHSVTransposed(LoadTransposed4(colorsIn, i, count)));
+}
+
+void King::Color::HSVToRGB(const Color* hsvIn, Color* colorsOut, size_t count)
+{
+    KING_MATH_COUNT("Color::HSVToRGB(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+        StoreTransposed4(colorsOut, i, count, HSVToRGBTransposed(LoadTransposed4(hsvIn, i, count)));
+}
+
+void King::Color::Blend(const Color* srcIn, const Color* dstIn, Color* colorsOut, size_t count, const BlendMode mode)
+{
+    KING_MATH_COUNT("Color::Blend(batch)", count);
+    switch (mode)
+    {
+    case BlendMode::Add: BlendArray<BlendMode::Add>(srcIn, dstIn, colorsOut, count); break;
+    case BlendMode::Multiply: BlendArray<BlendMode::Multiply>(srcIn, dstIn, colorsOut, count); break;
+    case BlendMode::Screen: BlendArray<BlendMode::Screen>(srcIn, dstIn, colorsOut, count); break;
+    case BlendMode::Over:
+    default: BlendArray<BlendMode::Over>(srcIn, dstIn, colorsOut, count); break;
+    }
+}
@@ -0,0 +1,146 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDColor
+
+Description:    Color on the FloatPoint4 SIMD base with r, g, b, a in x, y, z, w.
+                The type does not track whether channels are sRGB encoded or
+                linear, conversions are explicit.  Batch kernels cover the CPU
+                side compositing and image processing paths: sRGB <-> linear,
+                RGBA8 pack and unpack, premultiplied alpha, HSV and blending
+                over arrays.
+
+                    std::vector<uint32_t> pixels = ...;
+                    std::vector<King::Color> linear(pixels.size());
+                    King::Color::DecodeSRGBA8(pixels.data(), linear.data(), pixels.size());
+                    King::Color::Premultiply(linear.data(), linear.data(), linear.size());
+                    King::Color::Blend(layer.data(), linear.data(), linear.data(), linear.size(), King::Color::BlendMode::Over);
+                    King::Color::Unpremultiply(linear.data(), linear.data(), linear.size());
+                    King::Color::EncodeSRGBA8(linear.data(), pixels.data(), linear.size());
+
+                RGBA8 is r in the low byte, DXGI_FORMAT_R8G8B8A8_UNORM order on
+                little endian.  Alpha is never sRGB encoded.  HSV keeps hue in
+                [0, 1) in r, saturation in g and value in b.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   Color
+    ******************************************************************************/
+    class alignas(16) Color : public FloatPoint4
+    {
+    public:
+        // premultiplied alpha compositing, source over destination
+        enum class BlendMode
+        {
+            Over,       // s + d * (1 - sa)
+            Add,        // saturate(s + d)
+            Multiply,   // s * d + s * (1 - da) + d * (1 - sa)
+            Screen,     // s + d - s * d
+        };
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        static std::shared_ptr<Color> Create() { return std::make_shared<Color>(); }
+        static std::unique_ptr<Color> CreateUnique() { return std::make_unique<Color>(); }
+        inline Color() noexcept { v = DirectX::g_XMIdentityR3; } // opaque black
+        inline Color(const float r, const float g, const float b, const float a = 1.0f) { Set(r, g, b, a); }
+        inline Color(const FloatPoint3 rgb, const float a = 1.0f) { Set(rgb, a); }
+        inline explicit Color(const uint32_t rgba8) { v = UnpackRGBA8(rgba8); }
+        inline explicit Color(const FloatPoint4 in) { v = in; }
+        inline explicit Color(const DirectX::XMVECTOR & vec) { v = vec; }
+        inline Color(const DirectX::XMFLOAT4 & in) { Set(in); }
+        inline Color(const Color & in) noexcept { v = in.v; } // copy
+        inline Color(Color && in) noexcept { v = std::move(in.v); } // move
+        virtual ~Color() = default;
+        // Operators
+        inline Color& operator= (const Color & in) = default; // copy assignment
+        inline Color& operator= (Color && in) = default; // move assignment
+        inline Color& operator= (const DirectX::FXMVECTOR & in) { v = in; return *this; }
+        inline Color operator+ (const Color rhs) const { return Color(DirectX::XMVectorAdd(v, rhs)); }
+        inline Color operator- (const Color rhs) const { return Color(DirectX::XMVectorSubtract(v, rhs)); }
+        inline Color operator* (const Color rhs) const { return Color(DirectX::XMVectorMultiply(v, rhs)); } // modulate
+        inline Color operator* (const float s) const { return Color(DirectX::XMVectorScale(v, s)); }
+        inline Color& operator+= (const Color rhs) { v = DirectX::XMVectorAdd(v, rhs); return *this; }
+        inline Color& operator-= (const Color rhs) { v = DirectX::XMVectorSubtract(v, rhs); return *this; }
+        inline Color& operator*= (const Color rhs) { v = DirectX::XMVectorMultiply(v, rhs); return *this; }
+        inline Color& operator*= (const float s) { v = DirectX::XMVectorScale(v, s); return *this; }
+        // Conversions
+        inline explicit operator uint32_t() const { return PackRGBA8(); }
+        // Comparators
+        inline bool operator== (const Color& rhs) const { return DirectX::XMVector4Equal(v, rhs.GetVecConst()); }
+        inline bool operator!= (const Color& rhs) const { return DirectX::XMVector4NotEqual(v, rhs.GetVecConst()); }
+        // Functionality
+        Color __vectorcall                      ToLinear() const; // sRGB encoded to linear, alpha unchanged
+        Color __vectorcall                      ToSRGB() const; // linear to sRGB encoded, alpha unchanged
+        Color __vectorcall                      ToHSV() const; // hue [0, 1), saturation, value, alpha
+        Color __vectorcall                      ToRGB() const; // from hue [0, 1), saturation, value, alpha
+        uint32_t __vectorcall                   PackRGBA8() const; // saturated and rounded to nearest
+        inline Color                            Premultiply() const { return Color(DirectX::XMVectorSelect(v, DirectX::XMVectorMultiply(v, DirectX::XMVectorSplatW(v)), DirectX::g_XMSelect1110)); }
+        Color __vectorcall                      Unpremultiply() const; // alpha of zero gives transparent black
+        inline Color                            Saturate() const { return Color(DirectX::XMVectorSaturate(v)); }
+        inline float                            GetLuminance() const { return DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, DirectX::XMVectorSet(0.2126f, 0.7152f, 0.0722f, 0.0f))); } // Rec. 709 weights, linear channels
+        // Accessors
+        inline float                            GetR() const { return GetX(); }
+        inline float                            GetG() const { return GetY(); }
+        inline float                            GetB() const { return GetZ(); }
+        inline float                            GetA() const { return GetW(); }
+        inline FloatPoint3                      GetRGB() const { return FloatPoint3(v); }
+        // Assignments
+        inline void                             SetR(const float r) { SetX(r); }
+        inline void                             SetG(const float g) { SetY(g); }
+        inline void                             SetB(const float b) { SetZ(b); }
+        inline void                             SetA(const float a) { SetW(a); }
+        inline void                             SetRGB(const FloatPoint3 rgb) { v = DirectX::XMVectorSelect(v, rgb, DirectX::g_XMSelect1110); }
+        // Statics
+        static Color __vectorcall               Blend(const Color src, const Color dst, const BlendMode mode = BlendMode::Over); // premultiplied
+        static inline Color __vectorcall        Lerp(const Color c1, const Color c2, const float t) { return Color(DirectX::XMVectorLerp(c1, c2, t)); }
+        static inline Color                     FromHSV(const float h, const float s, const float value, const float a = 1.0f) { return Color(h, s, value, a).ToRGB(); }
+        static Color                            UnpackRGBA8(const uint32_t rgba8);
+        static void                             SRGBToLinear(const Color* colorsIn, Color* colorsOut, size_t count); // batch, in and out may alias
+        static void                             LinearToSRGB(const Color* colorsIn, Color* colorsOut, size_t count); // batch, in and out may alias
+        static void                             PackRGBA8(const Color* colorsIn, uint32_t* rgba8Out, size_t count); // batch, 4 wide
+        static void                             UnpackRGBA8(const uint32_t* rgba8In, Color* colorsOut, size_t count); // batch, 4 wide
+        static void                             DecodeSRGBA8(const uint32_t* srgba8In, Color* linearOut, size_t count); // batch, sRGB encoded RGBA8 to linear through a table
+        static void                             EncodeSRGBA8(const Color* linearIn, uint32_t* srgba8Out, size_t count); // batch, linear to sRGB encoded RGBA8
+        static void                             Premultiply(const Color* colorsIn, Color* colorsOut, size_t count); // batch, in and out may alias
+        static void                             Unpremultiply(const Color* colorsIn, Color* colorsOut, size_t count); // batch, in and out may alias
+        static void                             RGBToHSV(const Color* colorsIn, Color* hsvOut, size_t count); // batch, 4 wide, in and out may alias
+        static void                             HSVToRGB(const Color* hsvIn, Color* colorsOut, size_t count); // batch, 4 wide, in and out may alias
+        static void                             Blend(const Color* srcIn, const Color* dstIn, Color* colorsOut, size_t count, const BlendMode mode = BlendMode::Over); // batch, premultiplied, out may alias either input
+    };
+
+    std::ostream& operator<< (std::ostream& os, const Color& in);
+    std::wostream& operator<< (std::wostream& os, const Color& in);
+    std::istream& operator>> (std::istream& is, Color& in);
+
+    void to_json(json& j, const Color& from);
+    void from_json(const json& j, Color& to);
+}
@@ -0,0 +1,291 @@
+﻿#include "MathSIMDDelta.h"
+#include "MathSIMDInstrument.h"
+#include <cstring>
+
+using namespace King;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    // mode, components, type, reserved, precision, count
+    const size_t                                HeaderBytes = 12;
+    enum : uint8_t { TypeFloat3 = 3, TypeFloat4 = 4, TypeQuaternion = 5 };
+
+    inline uint32_t LowMask(const unsigned bits) { return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1u; }
+    inline unsigned BitWidth(uint32_t value)
+    {
+        unsigned width = 0;
+        if (value >> 16) { width += 16; value >>= 16; }
+        if (value >> 8) { width += 8; value >>= 8; }
+        if (value >> 4) { width += 4; value >>= 4; }
+        if (value >> 2) { width += 2; value >>= 2; }
+        if (value >> 1) { width += 1; value >>= 1; }
+        return width + value;
+    }
+
+    /******************************************************************************
+    *   BitWriter, BitReader
+    *       Least significant bit first
+    ******************************************************************************/
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& outIn) : out(outIn) {}
+        inline void Write(const uint32_t value, const unsigned bits)
+        {
+            assert(bits <= 32);
+            accumulator |= static_cast<uint64_t>(value & LowMask(bits)) << used;
+            used += bits;
+            while (used >= 8)
+            {
+                out.push_back(static_cast<uint8_t>(accumulator));
+                accumulator >>= 8;
+                used -= 8;
+            }
+        }
+        // Elias gamma, value >= 1: width - 1 zeros, a one, then the bits under the leading one
+        inline void WriteGamma(const uint32_t value)
+        {
+            assert(value >= 1);
+            const unsigned width = BitWidth(value);
+            Write(1u << (width - 1), width);
+            Write(value, width - 1);
+        }
+        inline void Flush() { if (used) { out.push_back(static_cast<uint8_t>(accumulator)); accumulator = 0; used = 0; } }
+    private:
+        std::vector<uint8_t>&                   out;
+        uint64_t                                accumulator = 0;
+        unsigned                                used = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t* dataIn, const size_t bytesIn) : data(dataIn), bits(bytesIn * 8) {}
+        inline uint32_t Read(const unsigned count)
+        {
+            if (count == 0)
+                return 0;
+            if (position + count > bits)
+            {
+                overrun = true;
+                return 0;
+            }
+            const size_t byte = position >> 3;
+            uint64_t window = 0;
+            memcpy(&window, data + byte, std::min<size_t>(8, bits / 8 - byte));
+            const uint32_t value = static_cast<uint32_t>(window >> (position & 7)) & LowMask(count);
+            position += count;
+            return value;
+        }
+        inline uint32_t ReadGamma()
+        {
+            unsigned zeros = 0;
+            while (!overrun && Read(1) == 0)
+                if (++zeros >= 32)
+                    overrun = true;
+            return overrun ? 0 : (zeros ? (1u << zeros) | Read(zeros) : 1u);
+        }
+        inline bool IsOverrun() const { return overrun; }
+    private:
+        const uint8_t*                          data;
+        size_t                                  bits;
+        size_t                                  position = 0;
+        bool                                    overrun = false;
+    };
+
+    // 4 elements as component rows, lanes past count are zero in both arrays so their delta is zero
+    template<class T>
+    inline XMMATRIX LoadGroup(const T* elements, const size_t index, const size_t count)
+    {
+        XMMATRIX m;
+        for (size_t k = 0; k < 4; ++k)
+            m.r[k] = index + k < count ? static_cast<XMVECTOR>(elements[index + k]) : XMVectorZero();
+        return XMMatrixTranspose(m);
+    }
+
+    template<class T>
+    inline void StoreGroup(const XMMATRIX& rows, T* elements, const size_t index, const size_t count)
+    {
+        const XMMATRIX m = XMMatrixTranspose(rows);
+        for (size_t k = 0; k < 4 && index + k < count; ++k)
+            elements[index + k] = m.r[k];
+    }
+
+    inline __m128i Quantize(const XMVECTOR v, const XMVECTOR inversePrecision)
+    {
+        // clamped so differences of two stay inside int32
+        const XMVECTOR limit = XMVectorReplicate(1073741824.0f);
+        return _mm_cvtps_epi32(XMVectorClamp(XMVectorMultiply(v, inversePrecision), XMVectorNegate(limit), limit));
+    }
+    inline __m128i ZigZag(const __m128i d) { return _mm_xor_si128(_mm_slli_epi32(d, 1), _mm_srai_epi32(d, 31)); }
+    inline __m128i UnZigZag(const __m128i z) { return _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi32(1)))); }
+
+    // q and -q are one rotation, the one nearer the baseline quantizes to smaller deltas
+    inline XMMATRIX AlignQuaternions(const XMMATRIX& current, const XMMATRIX& baseline)
+    {
+        XMVECTOR dot = XMVectorMultiply(current.r[0], baseline.r[0]);
+        for (int c = 1; c < 4; ++c)
+            dot = XMVectorMultiplyAdd(current.r[c], baseline.r[c], dot);
+        const __m128i flip = _mm_and_si128(_mm_castps_si128(XMVectorLess(dot, XMVectorZero())), _mm_set1_epi32(static_cast<int>(0x80000000u)));
+        XMMATRIX aligned;
+        for (int c = 0; c < 4; ++c)
+            aligned.r[c] = _mm_castsi128_ps(_mm_xor_si128(_mm_castps_si128(current.r[c]), flip));
+        return aligned;
+    }
+
+    inline __m128i ComponentDelta(const XMVECTOR current, const XMVECTOR baseline, const Delta::Settings& settings, const XMVECTOR inversePrecision)
+    {
+        if (settings.mode == Delta::Mode::Xor)
+            return _mm_xor_si128(_mm_castps_si128(current), _mm_castps_si128(baseline));
+        return ZigZag(_mm_sub_epi32(Quantize(current, inversePrecision), Quantize(baseline, inversePrecision)));
+    }
+
+    // the decoder's result for a changed group: changed lanes from the deltas, the others keep the baseline
+    inline XMMATRIX Reconstruct(const XMMATRIX& baseline, const __m128i* deltas, const unsigned components, const unsigned laneMask, const Delta::Settings& settings, const XMVECTOR inversePrecision)
+    {
+        const __m128i lanes = _mm_set_epi32(laneMask & 8 ? -1 : 0, laneMask & 4 ? -1 : 0, laneMask & 2 ? -1 : 0, laneMask & 1 ? -1 : 0);
+        const XMVECTOR step = XMVectorReplicate(settings.precision);
+        XMMATRIX rows = baseline;
+        for (unsigned c = 0; c < components; ++c)
+        {
+            __m128i value;
+            if (settings.mode == Delta::Mode::Xor)
+                value = _mm_xor_si128(_mm_castps_si128(baseline.r[c]), deltas[c]);
+            else
+                value = _mm_castps_si128(XMVectorMultiply(_mm_cvtepi32_ps(_mm_add_epi32(Quantize(baseline.r[c], inversePrecision), UnZigZag(deltas[c]))), step));
+            rows.r[c] = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(lanes, value), _mm_andnot_si128(lanes, _mm_castps_si128(baseline.r[c]))));
+        }
+        return rows;
+    }
+
+    template<class T>
+    size_t EncodeGroups(const T* baseline, const T* current, const size_t count, std::vector<uint8_t>& out, const Delta::Settings& settings, T* reconstructedOut, const uint8_t type, const unsigned components)
+    {
+        assert(count == 0 || (baseline && current));
+        assert(count <= 0xFFFFFFFFull);
+        assert(settings.mode == Delta::Mode::Xor || settings.precision > 0.0f);
+        KING_MATH_COUNT("Delta::Encode", count);
+        const size_t start = out.size();
+        out.resize(start + HeaderBytes);
+        uint8_t* header = out.data() + start;
+        header[0] = static_cast<uint8_t>(settings.mode);
+        header[1] = static_cast<uint8_t>(components);
+        header[2] = type;
+        header[3] = 0;
+        const uint32_t count32 = static_cast<uint32_t>(count);
+        memcpy(header + 4, &settings.precision, 4);
+        memcpy(header + 8, &count32, 4);
+
+        const XMVECTOR inversePrecision = XMVectorReplicate(settings.mode == Delta::Mode::Quantized ? 1.0f / settings.precision : 1.0f);
+        BitWriter writer(out);
+        uint32_t run = 0;
+        for (size_t i = 0; i < count; i += 4)
+        {
+            const XMMATRIX base = LoadGroup(baseline, i, count);
+            XMMATRIX now = LoadGroup(current, i, count);
+            if (type == TypeQuaternion && settings.mode == Delta::Mode::Quantized)
+                now = AlignQuaternions(now, base);
+
+            __m128i deltas[4];
+            __m128i changed = _mm_setzero_si128();
+            for (unsigned c = 0; c < components; ++c)
+            {
+                deltas[c] = ComponentDelta(now.r[c], base.r[c], settings, inversePrecision);
+                changed = _mm_or_si128(changed, deltas[c]);
+            }
+            const unsigned laneMask = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(changed, _mm_setzero_si128())))) & 0xF;
+            if (laneMask == 0)
+            {
+                ++run;
+                if (reconstructedOut && reconstructedOut != baseline)
+                    for (size_t k = i; k < std::min(i + 4, count); ++k)
+                        reconstructedOut[k] = baseline[k];
+                continue;
+            }
+            writer.WriteGamma(run + 1);
+            run = 0;
+            writer.Write(laneMask, 4);
+            for (unsigned c = 0; c < components; ++c)
+            {
+                alignas(16) uint32_t lane[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lane), deltas[c]);
+                const unsigned width = BitWidth(lane[0] | lane[1] | lane[2] | lane[3]);
+                writer.Write(width, 6);
+                for (unsigned k = 0; k < 4; ++k)
+                    if (laneMask & (1u << k))
+                        writer.Write(lane[k], width);
+            }
+            if (reconstructedOut)
+                StoreGroup(Reconstruct(base, deltas, components, laneMask, settings, inversePrecision), reconstructedOut, i, count);
+        }
+        if (run)
+            writer.WriteGamma(run + 1);
+        writer.Flush();
+        return out.size() - start;
+    }
+
+    template<class T>
+    bool DecodeGroups(const T* baseline, const uint8_t* data, const size_t bytes, T* currentOut, const size_t count, const uint8_t type, const unsigned components)
+    {
+        assert((count == 0 || (baseline && currentOut)) && (data || bytes == 0));
+        KING_MATH_COUNT("Delta::Decode", count);
+        if (bytes < HeaderBytes || data[1] != components || data[2] != type || data[0] > static_cast<uint8_t>(Delta::Mode::Quantized))
+            return false;
+        Delta::Settings settings;
+        uint32_t count32;
+        settings.mode = static_cast<Delta::Mode>(data[0]);
+        memcpy(&settings.precision, data + 4, 4);
+        memcpy(&count32, data + 8, 4);
+        if (count32 != count || (settings.mode == Delta::Mode::Quantized && !(settings.precision > 0.0f)))
+            return false;
+
+        const XMVECTOR inversePrecision = XMVectorReplicate(settings.mode == Delta::Mode::Quantized ? 1.0f / settings.precision : 1.0f);
+        BitReader reader(data + HeaderBytes, bytes - HeaderBytes);
+        const size_t groups = (count + 3) / 4;
+        size_t group = 0;
+        while (group < groups)
+        {
+            const uint32_t run = reader.ReadGamma() - 1;
+            if (reader.IsOverrun() || run > groups - group)
+                return false;
+            if (currentOut != baseline)
+                for (size_t k = group * 4; k < std::min((group + run) * 4, count); ++k)
+                    currentOut[k] = baseline[k];
+            group += run;
+            if (group == groups)
+                break;
+
+            const size_t i = group * 4;
+            const unsigned laneMask = reader.Read(4);
+            __m128i deltas[4];
+            for (unsigned c = 0; c < components; ++c)
+            {
+                const unsigned width = reader.Read(6);
+                if (width > 32)
+                    return false;
+                alignas(16) uint32_t lane[4] = {};
+                for (unsigned k = 0; k < 4; ++k)
+                    if (laneMask & (1u << k))
+                        lane[k] = reader.Read(width);
+                deltas[c] = _mm_load_si128(reinterpret_cast<const __m128i*>(lane));
+            }
+            if (reader.IsOverrun() || laneMask == 0)
+                return false;
+            StoreGroup(Reconstruct(LoadGroup(baseline, i, count), deltas, components, laneMask, settings, inversePrecision), currentOut, i, count);
+            ++group;
+        }
+        return true;
+    }
+}
+
+/******************************************************************************
+*   Delta
+******************************************************************************/
+size_t King::Delta::Encode(const float3* baseline, const float3* current, const size_t count, std::vector<uint8_t>& out, const Settings& settings, float3* reconstructedOut) { return EncodeGroups(baseline, current, count, out, settings, reconstructedOut, TypeFloat3, 3); }
+size_t King::Delta::Encode(const float4* baseline, const float4* current, const size_t count, std::vector<uint8_t>& out, const Settings& settings, float4* reconstructedOut) { return EncodeGroups(baseline, current, count, out, settings, reconstructedOut, TypeFloat4, 4); }
+size_t King::Delta::Encode(const Quaternion* baseline, const Quaternion* current, const size_t count, std::vector<uint8_t>& out, const Settings& settings, Quaternion* reconstructedOut) { return EncodeGroups(baseline, current, count, out, settings, reconstructedOut, TypeQuaternion, 4); }
+bool King::Delta::Decode(const float3* baseline, const uint8_t* data, const size_t bytes, float3* currentOut, const size_t count) { return DecodeGroups(baseline, data, bytes, currentOut, count, TypeFloat3, 3); }
+bool King::Delta::Decode(const float4* baseline, const uint8_t* data, const size_t bytes, float4* currentOut, const size_t count) { return DecodeGroups(baseline, data, bytes, currentOut, count, TypeFloat4, 4); }
+bool King::Delta::Decode(const Quaternion* baseline, const uint8_t* data, const size_t bytes, Quaternion* currentOut, const size_t count) { return DecodeGroups(baseline, data, bytes, currentOut, count, TypeQuaternion, 4); }
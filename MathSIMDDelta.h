@@ -0,0 +1,78 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDDelta
+
+Description:    Delta compression of float3, float4 and Quaternion state arrays
+                against a baseline snapshot both ends already hold, for network
+                replication and replay files where most vectors did not change.
+
+                Elements are taken 4 at a time and transposed so each component
+                of 4 elements is one SIMD register.  Xor mode is lossless: the
+                bits of current XOR baseline.  Quantized mode rounds both to a
+                grid of precision and keeps the integer difference (zigzag).
+                A group whose 4 deltas are all zero costs nothing but its share
+                of a run length; a changed group stores a 4 bit lane mask, then
+                per component the bit width of the largest delta and the changed
+                lanes packed at that width.
+
+                    std::vector<uint8_t> packet;
+                    King::Delta::Encode(acked.data(), bodies.data(), n, packet, settings, acked.data()); // acked becomes what the client decodes
+                    King::Delta::Decode(acked.data(), packet.data(), packet.size(), bodies.data(), n);
+
+                In quantized mode keep the reconstructed values (last argument
+                of Encode) as the next baseline so the ends never drift apart.
+                Quaternions are sign flipped toward their baseline first, q and
+                -q are the same rotation.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    namespace Delta
+    {
+        enum class Mode : uint8_t { Xor = 0, Quantized = 1 };
+
+        struct Settings
+        {
+            Mode                                mode = Mode::Quantized;
+            float                               precision = 1.0f / 1024.0f; // quantized grid, error is below one step
+
+            Settings() = default;
+            Settings(const Mode modeIn, const float precisionIn) : mode(modeIn), precision(precisionIn) {}
+        };
+
+        // appends to out and returns the bytes appended; reconstructedOut (may be baseline or null) receives what Decode will return
+        size_t                                  Encode(const float3* baseline, const float3* current, const size_t count, std::vector<uint8_t>& out, const Settings& settings = Settings(), float3* reconstructedOut = nullptr);
+        size_t                                  Encode(const float4* baseline, const float4* current, const size_t count, std::vector<uint8_t>& out, const Settings& settings = Settings(), float4* reconstructedOut = nullptr);
+        size_t                                  Encode(const Quaternion* baseline, const Quaternion* current, const size_t count, std::vector<uint8_t>& out, const Settings& settings = Settings(Mode::Quantized, 1.0f / 16384.0f), Quaternion* reconstructedOut = nullptr);
+        // false when the data is truncated or was encoded for another type or count; currentOut may be baseline
+        bool                                    Decode(const float3* baseline, const uint8_t* data, const size_t bytes, float3* currentOut, const size_t count);
+        bool                                    Decode(const float4* baseline, const uint8_t* data, const size_t bytes, float4* currentOut, const size_t count);
+        bool                                    Decode(const Quaternion* baseline, const uint8_t* data, const size_t bytes, Quaternion* currentOut, const size_t count);
+    }
+}
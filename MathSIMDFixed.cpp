@@ -0,0 +1,303 @@
+﻿#include "MathSIMDFixed.h"
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Streams
+******************************************************************************/
+std::ostream& King::operator<< (std::ostream& os, const King::FixedPoint3& in) { return os << "{ " << "x: " << setw(9) << std::setprecision( 6 ) << Fixed::ToFloat16(in.i[0]) << " y: " << setw(9) << Fixed::ToFloat16(in.i[1]) << " z: " << setw(9) << Fixed::ToFloat16(in.i[2]) << " }"; }
+std::ostream& King::operator<< (std::ostream& os, const King::FixedPoint3Wide& in) { return os << "{ " << "x: " << setw(9) << std::setprecision( 6 ) << Fixed::ToFloat32(in.i[0]) << " y: " << setw(9) << Fixed::ToFloat32(in.i[1]) << " z: " << setw(9) << Fixed::ToFloat32(in.i[2]) << " }"; }
+std::ostream& King::operator<< (std::ostream& os, const King::FixedQuaternion& in) { return os << "{ " << "x: " << setw(9) << std::setprecision( 6 ) << Fixed::ToFloat16(in.i[0]) << " y: " << setw(9) << Fixed::ToFloat16(in.i[1]) << " z: " << setw(9) << Fixed::ToFloat16(in.i[2]) << " w: " << setw(9) << Fixed::ToFloat16(in.i[3]) << " }"; }
+
+/******************************************************************************
+*   json
+******************************************************************************/
+void King::to_json(json& j, const FixedPoint3& from) { j = json{ {"x", from.i[0]}, {"y", from.i[1]}, {"z", from.i[2]} }; }
+void King::to_json(json& j, const FixedPoint3Wide& from) { j = json{ {"x", from.i[0]}, {"y", from.i[1]}, {"z", from.i[2]} }; }
+void King::to_json(json& j, const FixedQuaternion& from) { j = json{ {"x", from.i[0]}, {"y", from.i[1]}, {"z", from.i[2]}, {"w", from.i[3]} }; }
+
+void King::from_json(const json& j, FixedPoint3& to) { to.Set(j.at("x").get<int32_t>(), j.at("y").get<int32_t>(), j.at("z").get<int32_t>()); }
+void King::from_json(const json& j, FixedPoint3Wide& to) { to.Set(j.at("x").get<int64_t>(), j.at("y").get<int64_t>(), j.at("z").get<int64_t>()); }
+void King::from_json(const json& j, FixedQuaternion& to) { to.Set(j.at("x").get<int32_t>(), j.at("y").get<int32_t>(), j.at("z").get<int32_t>(), j.at("w").get<int32_t>()); }
+
+/******************************************************************************
+*   Fixed
+******************************************************************************/
+namespace
+{
+    // full 64 x 64 = 128 bit product from 32 bit halves, same result on every compiler
+    inline uint64_t UMul128(const uint64_t a, const uint64_t b, uint64_t* hiOut)
+    {
+        const uint64_t aLo = a & 0xFFFFFFFFull, aHi = a >> 32;
+        const uint64_t bLo = b & 0xFFFFFFFFull, bHi = b >> 32;
+        const uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+        const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFull) + (hl & 0xFFFFFFFFull);
+        *hiOut = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        return (mid << 32) | (ll & 0xFFFFFFFFull);
+    }
+    inline uint64_t UAbs(const int64_t a) { return a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a); }
+
+    // round(atan(2^-i) * 2^32)
+    constexpr int64_t cordicAtan[32] = {
+        3373259426ll, 1991351318ll, 1052175346ll, 534100635ll, 268086748ll, 134174063ll, 67103403ll, 33553749ll,
+        16777131ll, 8388597ll, 4194303ll, 2097152ll, 1048576ll, 524288ll, 262144ll, 131072ll,
+        65536ll, 32768ll, 16384ll, 8192ll, 4096ll, 2048ll, 1024ll, 512ll,
+        256ll, 128ll, 64ll, 32ll, 16ll, 8ll, 4ll, 2ll };
+    constexpr int64_t cordicGain = 2608131496ll; // round(2^32 / prod(sqrt(1 + 2^-2i)))
+
+    // conditional negate without a branch, mask is 0 or -1
+    inline int64_t Negate(const int64_t a, const int64_t mask) { return (a ^ mask) - mask; }
+}
+
+int64_t King::Fixed::Mul32(const int64_t a, const int64_t b)
+{
+    uint64_t hi;
+    uint64_t lo = UMul128(UAbs(a), UAbs(b), &hi);
+    if ((a < 0) != (b < 0))
+    {
+        // two's complement of the 128 bit product so the shift below floors like Mul16()
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0 ? 1 : 0);
+    }
+    return static_cast<int64_t>((hi << 32) | (lo >> 32));
+}
+
+int64_t King::Fixed::Div32(const int64_t a, const int64_t b)
+{
+    assert(b != 0);
+    if (b == 0)
+        return a < 0 ? INT64_MIN : INT64_MAX;
+    // restoring long division of |a| * 2^32 (96 bits) by |b|
+    const uint64_t numerator = UAbs(a);
+    const uint64_t denominator = UAbs(b);
+    uint64_t quotient = 0, remainder = 0;
+    for (int bit = 95; bit >= 0; --bit)
+    {
+        const uint64_t next = bit >= 32 ? (numerator >> (bit - 32)) & 1 : 0;
+        remainder = (remainder << 1) | next;
+        quotient <<= 1;
+        if (remainder >= denominator)
+        {
+            remainder -= denominator;
+            quotient |= 1;
+        }
+    }
+    return (a < 0) != (b < 0) ? static_cast<int64_t>(0 - quotient) : static_cast<int64_t>(quotient);
+}
+
+uint32_t King::Fixed::ISqrt(uint64_t x)
+{
+    uint64_t result = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > x)
+        bit >>= 2;
+    while (bit)
+    {
+        if (x >= result + bit)
+        {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+            result >>= 1;
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+uint64_t King::Fixed::ISqrt(const uint64_t hi, const uint64_t lo)
+{
+    // one result bit at a time, keep it when its square still fits under the radicand
+    uint64_t result = 0;
+    for (int bit = 63; bit >= 0; --bit)
+    {
+        const uint64_t candidate = result | (1ull << bit);
+        uint64_t sqHi;
+        const uint64_t sqLo = UMul128(candidate, candidate, &sqHi);
+        if (sqHi < hi || (sqHi == hi && sqLo <= lo))
+            result = candidate;
+    }
+    return result;
+}
+
+int64_t King::Fixed::Sqrt32(const int64_t q)
+{
+    if (q <= 0)
+        return 0;
+    const uint64_t u = static_cast<uint64_t>(q);
+    return static_cast<int64_t>(ISqrt(u >> 32, u << 32));
+}
+
+void King::Fixed::SinCos32(const int64_t angle, int64_t* sinOut, int64_t* cosOut)
+{
+    assert(sinOut && cosOut);
+    // reduce to [-π, π] then to [-π/2, π/2] where CORDIC converges, the half turn flips the signs
+    int64_t a = angle % TwoPi32;
+    if (a > Pi32) a -= TwoPi32;
+    else if (a < -Pi32) a += TwoPi32;
+    int64_t flip = 0;
+    if (a > HalfPi32) { a -= Pi32; flip = -1; }
+    else if (a < -HalfPi32) { a += Pi32; flip = -1; }
+
+    int64_t x = cordicGain, y = 0;
+    for (int i = 0; i < 32; ++i)
+    {
+        const int64_t direction = a >> 63; // 0 rotates counter clockwise, -1 clockwise
+        const int64_t dx = y >> i, dy = x >> i;
+        x -= Negate(dx, direction);
+        y += Negate(dy, direction);
+        a -= Negate(cordicAtan[i], direction);
+    }
+    *sinOut = Negate(y, flip);
+    *cosOut = Negate(x, flip);
+}
+
+void King::Fixed::SinCos16(const int32_t angle, int32_t* sinOut, int32_t* cosOut)
+{
+    assert(sinOut && cosOut);
+    int64_t s, c;
+    SinCos32(Q16ToQ32(angle), &s, &c);
+    *sinOut = Q32ToQ16(s);
+    *cosOut = Q32ToQ16(c);
+}
+
+int64_t King::Fixed::Atan2_32(const int64_t y, const int64_t x)
+{
+    if (x == 0 && y == 0)
+        return 0;
+    // scale so the larger magnitude sits at bit 60, CORDIC gain then stays inside 63 bits
+    uint64_t ax = UAbs(x), ay = UAbs(y);
+    const uint64_t largest = ax > ay ? ax : ay;
+    int top = 63;
+    while (!(largest >> top))
+        --top;
+    if (top > 60) { ax >>= top - 60; ay >>= top - 60; }
+    else { ax <<= 60 - top; ay <<= 60 - top; }
+
+    // left half plane is turned by π into the right half plane where CORDIC converges
+    int64_t vx = static_cast<int64_t>(ax);
+    int64_t vy = y < 0 ? -static_cast<int64_t>(ay) : static_cast<int64_t>(ay);
+    int64_t result = 0;
+    if (x < 0)
+    {
+        vy = -vy;
+        result = y < 0 ? -Pi32 : Pi32;
+    }
+    for (int i = 0; i < 32; ++i)
+    {
+        const int64_t direction = vy >> 63; // 0 for y above the axis rotates clockwise
+        const int64_t dx = vy >> i, dy = vx >> i;
+        vx += Negate(dx, direction);
+        vy -= Negate(dy, direction);
+        result += Negate(cordicAtan[i], direction);
+    }
+    return result;
+}
+
+/******************************************************************************
+*   FixedPoint3
+******************************************************************************/
+uint64_t King::FixedPoint3::GetMagnitudeSq() const
+{
+    const uint64_t x = UAbs(i[0]), y = UAbs(i[1]), z = UAbs(i[2]);
+    return x * x + y * y + z * z;
+}
+
+int32_t King::FixedPoint3::GetMagnitude() const
+{
+    const uint32_t length = Fixed::ISqrt(GetMagnitudeSq());
+    return length > static_cast<uint32_t>(INT32_MAX) ? INT32_MAX : static_cast<int32_t>(length);
+}
+
+King::FixedPoint3 King::FixedPoint3::Normal() const
+{
+    const int32_t length = GetMagnitude();
+    if (length == 0)
+        return FixedPoint3();
+    return FromRaw(Fixed::Div16(i[0], length), Fixed::Div16(i[1], length), Fixed::Div16(i[2], length));
+}
+
+/******************************************************************************
+*   FixedPoint3Wide
+******************************************************************************/
+int64_t King::FixedPoint3Wide::GetMagnitude() const
+{
+    uint64_t hi = 0, lo = 0;
+    for (int n = 0; n < 3; ++n)
+    {
+        const uint64_t a = UAbs(i[n]);
+        uint64_t sqHi;
+        const uint64_t sqLo = UMul128(a, a, &sqHi);
+        lo += sqLo;
+        hi += sqHi + (lo < sqLo ? 1 : 0);
+    }
+    const uint64_t length = Fixed::ISqrt(hi, lo);
+    return length > static_cast<uint64_t>(INT64_MAX) ? INT64_MAX : static_cast<int64_t>(length);
+}
+
+King::FixedPoint3Wide King::FixedPoint3Wide::Normal() const
+{
+    const int64_t length = GetMagnitude();
+    if (length == 0)
+        return FixedPoint3Wide();
+    return FromRaw(Fixed::Div32(i[0], length), Fixed::Div32(i[1], length), Fixed::Div32(i[2], length));
+}
+
+/******************************************************************************
+*   FixedQuaternion
+******************************************************************************/
+King::FixedQuaternion King::FixedQuaternion::operator* (const FixedQuaternion & rhs) const
+{
+    // XMQuaternionMultiply(this, rhs) as four lane wise products, each floored then summed in a fixed order
+    const __m128i q1 = v;
+    const __m128i t0 = Fixed::Mul16(_mm_shuffle_epi32(rhs.v, _MM_SHUFFLE(3, 3, 3, 3)), q1);
+    __m128i t1 = Fixed::Mul16(_mm_shuffle_epi32(rhs.v, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_epi32(q1, _MM_SHUFFLE(0, 1, 2, 3)));
+    __m128i t2 = Fixed::Mul16(_mm_shuffle_epi32(rhs.v, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_epi32(q1, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128i t3 = Fixed::Mul16(_mm_shuffle_epi32(rhs.v, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_epi32(q1, _MM_SHUFFLE(2, 3, 0, 1)));
+    const __m128i sign1 = _mm_setr_epi32(0, -1, 0, -1);
+    const __m128i sign2 = _mm_setr_epi32(0, 0, -1, -1);
+    const __m128i sign3 = _mm_setr_epi32(-1, 0, 0, -1);
+    t1 = _mm_sub_epi32(_mm_xor_si128(t1, sign1), sign1);
+    t2 = _mm_sub_epi32(_mm_xor_si128(t2, sign2), sign2);
+    t3 = _mm_sub_epi32(_mm_xor_si128(t3, sign3), sign3);
+    return FixedQuaternion(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32(t0, t1), t2), t3));
+}
+
+void King::FixedQuaternion::SetAxisAngle(const FixedPoint3 & unitAxis, const int32_t angle)
+{
+    // half angle taken at Q32.32 so no bit of the Q16.16 angle is lost
+    int64_t s, c;
+    Fixed::SinCos32(static_cast<int64_t>(angle) * 32768, &s, &c);
+    const FixedPoint3 axis = unitAxis.Scale(Fixed::Q32ToQ16(s));
+    Set(axis.i[0], axis.i[1], axis.i[2], Fixed::Q32ToQ16(c));
+}
+
+King::FixedQuaternion King::FixedQuaternion::Normal() const
+{
+    // components of 2^30 or more are divided by 4 first so the four squares stay below 2^64 and the length fits int32;
+    // the direction is unchanged and the division truncates toward zero so q and -q normalize symmetrically
+    uint64_t largest = 0;
+    for (int n = 0; n < 4; ++n)
+        largest = std::max(largest, UAbs(i[n]));
+    const int32_t divisor = largest >= (uint64_t(1) << 30) ? 4 : 1;
+    int32_t q[4];
+    uint64_t lengthSq = 0;
+    for (int n = 0; n < 4; ++n)
+    {
+        q[n] = i[n] / divisor;
+        lengthSq += UAbs(q[n]) * UAbs(q[n]);
+    }
+    const int32_t length = static_cast<int32_t>(Fixed::ISqrt(lengthSq));
+    if (length == 0)
+        return FixedQuaternion();
+    return FromRaw(Fixed::Div16(q[0], length), Fixed::Div16(q[1], length), Fixed::Div16(q[2], length), Fixed::Div16(q[3], length));
+}
+
+King::FixedPoint3 King::FixedQuaternion::Rotate(const FixedPoint3 & vecIn) const
+{
+    // v' = v + w t + u x t, t = 2 (u x v)
+    const FixedPoint3 u = GetAxis();
+    const FixedPoint3 t = u.CrossProduct(vecIn) << 1;
+    return vecIn + t.Scale(i[3]) + u.CrossProduct(t);
+}
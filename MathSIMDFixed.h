@@ -0,0 +1,328 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDFixed
+
+Description:    Fixed point vector types for deterministic simulation.  Lockstep
+                multiplayer needs every machine to produce the same bits each
+                step, which floating point does not promise across compilers and
+                CPUs.  Integer arithmetic does, so positions and rotations that
+                drive the simulation are kept in fixed point and converted to
+                float types only for rendering.
+
+                fix3    Q16.16 three component vector, SSE2 integer lanes
+                fix3w   Q32.32 three component vector for large worlds
+                fixquat Q16.16 quaternion, SSE2 integer lanes
+
+                Every operation is defined by integer math only: products are
+                floored (arithmetic shift), divides truncate toward zero, sqrt
+                is the floor of the exact integer root and trig is CORDIC with
+                a fixed table, so results are bit identical on any platform.
+                These types have no virtual table so their memory is only the
+                data and can be hashed or sent over the network as is.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <cstdint>
+
+namespace King {
+
+    class FixedPoint3; // SIMD integer, Q16.16
+    class FixedPoint3Wide; // SIMD integer add/subtract, Q32.32
+    class FixedQuaternion; // SIMD integer, Q16.16
+
+    typedef FixedPoint3         fix3;
+    typedef FixedPoint3Wide     fix3w;
+    typedef FixedQuaternion     fixquat;
+
+    /******************************************************************************
+    *   Fixed
+    *       Scalar Q16.16 (int32_t) and Q32.32 (int64_t) operations that the
+    *       vector types are built on
+    ******************************************************************************/
+    namespace Fixed
+    {
+        constexpr int32_t   One16 = 1 << 16;
+        constexpr int32_t   Half16 = 1 << 15;
+        constexpr int32_t   Pi16 = 205887; // round(pi * 2^16)
+        constexpr int64_t   One32 = int64_t(1) << 32;
+        constexpr int64_t   Half32 = int64_t(1) << 31;
+        constexpr int64_t   Pi32 = 13493037705ll; // round(pi * 2^32)
+        constexpr int64_t   HalfPi32 = 6746518852ll;
+        constexpr int64_t   TwoPi32 = 26986075409ll;
+
+        // conversions, float in is rounded to nearest (half away from zero) independent of the FPU rounding mode and
+        // clamped to the representable range
+        inline int32_t      FromInt16(const int i) { return static_cast<int32_t>(static_cast<uint32_t>(i) << 16); }
+        inline int64_t      FromInt32(const int64_t i) { return static_cast<int64_t>(static_cast<uint64_t>(i) << 32); }
+        inline int32_t      FromFloat16(const float f) { return static_cast<int32_t>(std::lround((f > 32767.99f ? 32767.99f : f < -32767.99f ? -32767.99f : f) * 65536.0f)); }
+        inline int64_t      FromFloat32(const float f) { const double d = f; return std::llround((d > 2147483647.0 ? 2147483647.0 : d < -2147483647.0 ? -2147483647.0 : d) * 4294967296.0); }
+        inline float        ToFloat16(const int32_t q) { return static_cast<float>(q) * (1.0f / 65536.0f); }
+        inline float        ToFloat32(const int64_t q) { return static_cast<float>(static_cast<double>(q) * (1.0 / 4294967296.0)); }
+        inline int32_t      Q32ToQ16(const int64_t q) { return static_cast<int32_t>((q + (Half16)) >> 16); } // rounded
+        inline int64_t      Q16ToQ32(const int32_t q) { return static_cast<int64_t>(q) * 65536; }
+
+        // products floor, quotients truncate toward zero
+        inline int32_t      Mul16(const int32_t a, const int32_t b) { return static_cast<int32_t>((static_cast<int64_t>(a) * b) >> 16); }
+        inline int32_t      Div16(const int32_t a, const int32_t b) { assert(b != 0); return static_cast<int32_t>((static_cast<int64_t>(a) * 65536) / b); }
+        int64_t             Mul32(const int64_t a, const int64_t b);
+        int64_t             Div32(const int64_t a, const int64_t b);
+
+        // floor of the exact root, zero for negative input
+        uint32_t            ISqrt(const uint64_t x);
+        uint64_t            ISqrt(const uint64_t hi, const uint64_t lo); // 128 bit radicand
+        inline int32_t      Sqrt16(const int32_t q) { return q > 0 ? static_cast<int32_t>(ISqrt(static_cast<uint64_t>(q) << 16)) : 0; }
+        int64_t             Sqrt32(const int64_t q);
+
+        // CORDIC, radians in and out
+        void                SinCos32(const int64_t angle, int64_t* sinOut, int64_t* cosOut);
+        void                SinCos16(const int32_t angle, int32_t* sinOut, int32_t* cosOut);
+        int64_t             Atan2_32(const int64_t y, const int64_t x);
+        inline int32_t      Atan2_16(const int32_t y, const int32_t x) { return Q32ToQ16(Atan2_32(y, x)); }
+        inline int32_t      Sin16(const int32_t angle) { int32_t s, c; SinCos16(angle, &s, &c); return s; }
+        inline int32_t      Cos16(const int32_t angle) { int32_t s, c; SinCos16(angle, &s, &c); return c; }
+
+        // lane wise Q16.16 product of four int32, matches Mul16() bit for bit
+        inline __m128i __vectorcall Mul16(const __m128i a, const __m128i b)
+        {
+            // unsigned 32 x 32 = 64 of the even and odd lanes keeping bits 16..47
+            const __m128i even = _mm_srli_epi64(_mm_mul_epu32(a, b), 16);
+            const __m128i odd = _mm_slli_epi64(_mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), 16), 32);
+            const __m128i product = _mm_or_si128(_mm_and_si128(even, _mm_set_epi32(0, -1, 0, -1)), odd);
+            // signed correction of the high half, (a < 0 ? b : 0) + (b < 0 ? a : 0)
+            const __m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), _mm_and_si128(_mm_srai_epi32(b, 31), a));
+            return _mm_sub_epi32(product, _mm_slli_epi32(correction, 16));
+        }
+    }
+
+    /******************************************************************************
+    *   FixedPoint3
+    *       Q16.16, range +/-32768 with 1/65536 resolution
+    ******************************************************************************/
+    class alignas(16) FixedPoint3
+    {
+        /* variables */
+    public:
+        union
+        {
+            int32_t     i[4]; // x, y, z, 0
+            __m128i     v;
+        };
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline FixedPoint3() : v(_mm_setzero_si128()) {}
+        inline FixedPoint3(const FixedPoint3 & in) = default; // copy
+        inline explicit FixedPoint3(const __m128i vecIn) : v(vecIn) {}
+        inline explicit FixedPoint3(const IntPoint3 & in) : v(_mm_slli_epi32(_mm_setr_epi32(in.i[0], in.i[1], in.i[2], 0), 16)) {}
+        inline explicit FixedPoint3(const FloatPoint3 & in) { const auto f = in.Get_XMFLOAT3(); Set(Fixed::FromFloat16(f.x), Fixed::FromFloat16(f.y), Fixed::FromFloat16(f.z)); }
+        inline explicit FixedPoint3(const FixedPoint3Wide & in);
+        static inline FixedPoint3               FromRaw(const int32_t x, const int32_t y, const int32_t z) { FixedPoint3 r; r.Set(x, y, z); return r; }
+        // Operators
+        inline FixedPoint3& operator= (const FixedPoint3 & in) = default; // copy assignment
+        // Conversions
+        inline explicit operator bool() const { return _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_setzero_si128())) != 0xFFFF; } // non-zero
+        inline bool operator !() const { return _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_setzero_si128())) == 0xFFFF; } // empty
+        inline int32_t operator[](int idx) const { return i[idx]; }
+        inline FloatPoint3                      ToFloatPoint3() const { return FloatPoint3(Fixed::ToFloat16(i[0]), Fixed::ToFloat16(i[1]), Fixed::ToFloat16(i[2])); }
+        inline IntPoint3                        ToIntPoint3() const { const FixedPoint3 f(_mm_srai_epi32(v, 16)); return IntPoint3(f.i[0], f.i[1], f.i[2]); } // floor
+        // Comparators
+        inline bool operator== (const FixedPoint3 & rhs) const { return _mm_movemask_epi8(_mm_cmpeq_epi32(v, rhs.v)) == 0xFFFF; }
+        inline bool operator!= (const FixedPoint3 & rhs) const { return !(*this == rhs); }
+        // Math Operators
+        inline FixedPoint3 operator- () const { return FixedPoint3(_mm_sub_epi32(_mm_setzero_si128(), v)); }
+        inline FixedPoint3 operator+ (const FixedPoint3 & p) const { return FixedPoint3(_mm_add_epi32(v, p.v)); }
+        inline FixedPoint3 operator- (const FixedPoint3 & p) const { return FixedPoint3(_mm_sub_epi32(v, p.v)); }
+        inline FixedPoint3 operator* (const FixedPoint3 & p) const { return FixedPoint3(Fixed::Mul16(v, p.v)); } // component wise
+        inline FixedPoint3 operator* (const int s) const { return FixedPoint3(Fixed::Mul16(v, _mm_set1_epi32(Fixed::FromInt16(s)))); } // integer scale
+        inline FixedPoint3 operator>> (const int s) const { return FixedPoint3(_mm_srai_epi32(v, s)); }
+        inline FixedPoint3 operator<< (const int s) const { return FixedPoint3(_mm_slli_epi32(v, s)); }
+
+        inline FixedPoint3& operator+= (const FixedPoint3 & p) { v = _mm_add_epi32(v, p.v); return *this; }
+        inline FixedPoint3& operator-= (const FixedPoint3 & p) { v = _mm_sub_epi32(v, p.v); return *this; }
+        inline FixedPoint3& operator*= (const FixedPoint3 & p) { v = Fixed::Mul16(v, p.v); return *this; }
+        // Assignments
+        inline void                             SetZero() { v = _mm_setzero_si128(); }
+        inline void                             Set(const int32_t x, const int32_t y, const int32_t z) { v = _mm_setr_epi32(x, y, z, 0); } // raw Q16.16
+        // Accessors
+        inline int32_t                          GetX() const { return i[0]; } // raw Q16.16
+        inline int32_t                          GetY() const { return i[1]; }
+        inline int32_t                          GetZ() const { return i[2]; }
+        // Functionality
+        inline FixedPoint3                      Scale(const int32_t s) const { return FixedPoint3(Fixed::Mul16(v, _mm_set1_epi32(s))); } // Q16.16 scalar
+        inline int32_t                          DotProduct(const FixedPoint3 & in) const { const FixedPoint3 p(Fixed::Mul16(v, in.v)); return p.i[0] + p.i[1] + p.i[2]; }
+        inline FixedPoint3                      CrossProduct(const FixedPoint3 & in) const
+        {
+            const __m128i a = Fixed::Mul16(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_epi32(in.v, _MM_SHUFFLE(3, 1, 0, 2)));
+            const __m128i b = Fixed::Mul16(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_epi32(in.v, _MM_SHUFFLE(3, 0, 2, 1)));
+            return FixedPoint3(_mm_sub_epi32(a, b));
+        }
+        uint64_t                                GetMagnitudeSq() const; // Q32.32, does not overflow
+        int32_t                                 GetMagnitude() const;
+        FixedPoint3                             Normal() const;
+        inline void                             Normalize() { *this = Normal(); }
+        inline void                             Min(const FixedPoint3 & in) { const __m128i lt = _mm_cmplt_epi32(in.v, v); v = _mm_or_si128(_mm_and_si128(lt, in.v), _mm_andnot_si128(lt, v)); }
+        inline void                             Max(const FixedPoint3 & in) { const __m128i gt = _mm_cmpgt_epi32(in.v, v); v = _mm_or_si128(_mm_and_si128(gt, in.v), _mm_andnot_si128(gt, v)); }
+    };
+    /******************************************************************************
+    *   FixedPoint3Wide
+    *       Q32.32, range +/-2^31 with 1/2^32 resolution
+    ******************************************************************************/
+    class alignas(16) FixedPoint3Wide
+    {
+        /* variables */
+    public:
+        union
+        {
+            int64_t     i[4]; // x, y, z, 0
+            __m128i     v[2];
+        };
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline FixedPoint3Wide() { SetZero(); }
+        inline FixedPoint3Wide(const FixedPoint3Wide & in) = default; // copy
+        inline explicit FixedPoint3Wide(const IntPoint3 & in) { Set(Fixed::FromInt32(in.i[0]), Fixed::FromInt32(in.i[1]), Fixed::FromInt32(in.i[2])); }
+        inline explicit FixedPoint3Wide(const FloatPoint3 & in) { const auto f = in.Get_XMFLOAT3(); Set(Fixed::FromFloat32(f.x), Fixed::FromFloat32(f.y), Fixed::FromFloat32(f.z)); }
+        inline explicit FixedPoint3Wide(const FixedPoint3 & in) { Set(Fixed::Q16ToQ32(in.i[0]), Fixed::Q16ToQ32(in.i[1]), Fixed::Q16ToQ32(in.i[2])); }
+        static inline FixedPoint3Wide           FromRaw(const int64_t x, const int64_t y, const int64_t z) { FixedPoint3Wide r; r.Set(x, y, z); return r; }
+        // Operators
+        inline FixedPoint3Wide& operator= (const FixedPoint3Wide & in) = default; // copy assignment
+        // Conversions
+        inline explicit operator bool() const { return (i[0] | i[1] | i[2]) != 0; } // non-zero
+        inline bool operator !() const { return (i[0] | i[1] | i[2]) == 0; } // empty
+        inline int64_t operator[](int idx) const { return i[idx]; }
+        inline FloatPoint3                      ToFloatPoint3() const { return FloatPoint3(Fixed::ToFloat32(i[0]), Fixed::ToFloat32(i[1]), Fixed::ToFloat32(i[2])); }
+        inline IntPoint3                        ToIntPoint3() const { return IntPoint3(static_cast<int>(i[0] >> 32), static_cast<int>(i[1] >> 32), static_cast<int>(i[2] >> 32)); } // floor
+        // Comparators
+        inline bool operator== (const FixedPoint3Wide & rhs) const { return i[0] == rhs.i[0] && i[1] == rhs.i[1] && i[2] == rhs.i[2]; }
+        inline bool operator!= (const FixedPoint3Wide & rhs) const { return !(*this == rhs); }
+        // Math Operators
+        inline FixedPoint3Wide operator- () const { FixedPoint3Wide r; r.v[0] = _mm_sub_epi64(r.v[0], v[0]); r.v[1] = _mm_sub_epi64(r.v[1], v[1]); return r; }
+        inline FixedPoint3Wide operator+ (const FixedPoint3Wide & p) const { FixedPoint3Wide r(*this); r += p; return r; }
+        inline FixedPoint3Wide operator- (const FixedPoint3Wide & p) const { FixedPoint3Wide r(*this); r -= p; return r; }
+        inline FixedPoint3Wide operator* (const FixedPoint3Wide & p) const { return FromRaw(Fixed::Mul32(i[0], p.i[0]), Fixed::Mul32(i[1], p.i[1]), Fixed::Mul32(i[2], p.i[2])); } // component wise
+        inline FixedPoint3Wide operator* (const int s) const // integer scale, multiplied in uint64_t so overflow wraps modulo 2^64 identically on every platform
+        {
+            const uint64_t u = static_cast<uint64_t>(static_cast<int64_t>(s));
+            return FromRaw(static_cast<int64_t>(static_cast<uint64_t>(i[0]) * u), static_cast<int64_t>(static_cast<uint64_t>(i[1]) * u), static_cast<int64_t>(static_cast<uint64_t>(i[2]) * u));
+        }
+
+        inline FixedPoint3Wide& operator+= (const FixedPoint3Wide & p) { v[0] = _mm_add_epi64(v[0], p.v[0]); v[1] = _mm_add_epi64(v[1], p.v[1]); return *this; }
+        inline FixedPoint3Wide& operator-= (const FixedPoint3Wide & p) { v[0] = _mm_sub_epi64(v[0], p.v[0]); v[1] = _mm_sub_epi64(v[1], p.v[1]); return *this; }
+        // Assignments
+        inline void                             SetZero() { v[0] = v[1] = _mm_setzero_si128(); }
+        inline void                             Set(const int64_t x, const int64_t y, const int64_t z) { i[0] = x; i[1] = y; i[2] = z; i[3] = 0; } // raw Q32.32
+        // Accessors
+        inline int64_t                          GetX() const { return i[0]; } // raw Q32.32
+        inline int64_t                          GetY() const { return i[1]; }
+        inline int64_t                          GetZ() const { return i[2]; }
+        // Functionality
+        inline FixedPoint3Wide                  Scale(const int64_t s) const { return FromRaw(Fixed::Mul32(i[0], s), Fixed::Mul32(i[1], s), Fixed::Mul32(i[2], s)); } // Q32.32 scalar
+        inline int64_t                          DotProduct(const FixedPoint3Wide & in) const { return Fixed::Mul32(i[0], in.i[0]) + Fixed::Mul32(i[1], in.i[1]) + Fixed::Mul32(i[2], in.i[2]); }
+        inline FixedPoint3Wide                  CrossProduct(const FixedPoint3Wide & in) const
+        {
+            return FromRaw(Fixed::Mul32(i[1], in.i[2]) - Fixed::Mul32(i[2], in.i[1]),
+                           Fixed::Mul32(i[2], in.i[0]) - Fixed::Mul32(i[0], in.i[2]),
+                           Fixed::Mul32(i[0], in.i[1]) - Fixed::Mul32(i[1], in.i[0]));
+        }
+        int64_t                                 GetMagnitude() const;
+        FixedPoint3Wide                         Normal() const;
+        inline void                             Normalize() { *this = Normal(); }
+    };
+    inline FixedPoint3::FixedPoint3(const FixedPoint3Wide & in) { Set(static_cast<int32_t>(in.i[0] >> 16), static_cast<int32_t>(in.i[1] >> 16), static_cast<int32_t>(in.i[2] >> 16)); } // floor
+    /******************************************************************************
+    *   FixedQuaternion
+    *       Q16.16, same multiply order as Quaternion (and XMQuaternionMultiply)
+    ******************************************************************************/
+    class alignas(16) FixedQuaternion
+    {
+        /* variables */
+    public:
+        union
+        {
+            int32_t     i[4]; // x, y, z, w
+            __m128i     v;
+        };
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline FixedQuaternion() { SetIdentity(); }
+        inline FixedQuaternion(const FixedQuaternion & in) = default; // copy
+        inline explicit FixedQuaternion(const __m128i vecIn) : v(vecIn) {}
+        inline explicit FixedQuaternion(const Quaternion & in) { Set(Fixed::FromFloat16(in.f[0]), Fixed::FromFloat16(in.f[1]), Fixed::FromFloat16(in.f[2]), Fixed::FromFloat16(in.f[3])); }
+        inline FixedQuaternion(const FixedPoint3 & unitAxis, const int32_t angle) { SetAxisAngle(unitAxis, angle); }
+        static inline FixedQuaternion           FromRaw(const int32_t x, const int32_t y, const int32_t z, const int32_t w) { FixedQuaternion r; r.Set(x, y, z, w); return r; }
+        // Operators
+        inline FixedQuaternion& operator= (const FixedQuaternion & in) = default; // copy assignment
+        // Conversions
+        inline Quaternion                       ToQuaternion() const { return Quaternion(DirectX::XMVectorSet(Fixed::ToFloat16(i[0]), Fixed::ToFloat16(i[1]), Fixed::ToFloat16(i[2]), Fixed::ToFloat16(i[3]))); }
+        // Comparators
+        inline bool operator== (const FixedQuaternion & rhs) const { return _mm_movemask_epi8(_mm_cmpeq_epi32(v, rhs.v)) == 0xFFFF; }
+        inline bool operator!= (const FixedQuaternion & rhs) const { return !(*this == rhs); }
+        // Math Operators
+        FixedQuaternion operator* (const FixedQuaternion & rhs) const;
+        inline FixedQuaternion& operator*= (const FixedQuaternion & rhs) { *this = *this * rhs; return *this; }
+        // Assignments
+        inline void                             SetIdentity() { v = _mm_setr_epi32(0, 0, 0, Fixed::One16); }
+        inline void                             Set(const int32_t x, const int32_t y, const int32_t z, const int32_t w) { v = _mm_setr_epi32(x, y, z, w); } // raw Q16.16
+        void                                    SetAxisAngle(const FixedPoint3 & unitAxis, const int32_t angle); // radians Q16.16
+        // Accessors
+        inline int32_t                          GetX() const { return i[0]; } // raw Q16.16
+        inline int32_t                          GetY() const { return i[1]; }
+        inline int32_t                          GetZ() const { return i[2]; }
+        inline int32_t                          GetW() const { return i[3]; }
+        inline FixedPoint3                      GetAxis() const { return FixedPoint3(_mm_and_si128(v, _mm_setr_epi32(-1, -1, -1, 0))); } // not normalized
+        // Functionality
+        inline FixedQuaternion                  Conjugate() const { return FixedQuaternion(_mm_sub_epi32(_mm_xor_si128(v, _mm_setr_epi32(-1, -1, -1, 0)), _mm_setr_epi32(-1, -1, -1, 0))); }
+        inline int32_t                          DotProduct(const FixedQuaternion & in) const { const FixedQuaternion p(Fixed::Mul16(v, in.v)); return p.i[0] + p.i[1] + p.i[2] + p.i[3]; }
+        FixedQuaternion                         Normal() const;
+        inline void                             Normalize() { *this = Normal(); }
+        FixedPoint3                             Rotate(const FixedPoint3 & vecIn) const; // as XMVector3Rotate
+    };
+
+    /******************************************************************************
+    *   Streams
+    ******************************************************************************/
+    std::ostream& operator<< (std::ostream& os, const FixedPoint3& in);
+    std::ostream& operator<< (std::ostream& os, const FixedPoint3Wide& in);
+    std::ostream& operator<< (std::ostream& os, const FixedQuaternion& in);
+
+    /******************************************************************************
+    *   json
+    *       raw integers so a round trip is exact
+    ******************************************************************************/
+    void to_json(json& j, const FixedPoint3& from);
+    void to_json(json& j, const FixedPoint3Wide& from);
+    void to_json(json& j, const FixedQuaternion& from);
+
+    void from_json(const json& j, FixedPoint3& to);
+    void from_json(const json& j, FixedPoint3Wide& to);
+    void from_json(const json& j, FixedQuaternion& to);
+}
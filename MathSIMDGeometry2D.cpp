@@ -0,0 +1,642 @@
+﻿#include "MathSIMDGeometry2D.h"
+#include "MathSIMDInstrument.h"
+#include <algorithm>
+#include <limits>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Streams
+******************************************************************************/
+std::ostream& King::operator<< (std::ostream& os, const King::Rect2D& in) { return os << "{ " << "min: " << in.GetMin() << " max: " << in.GetMax() << " }"; }
+std::ostream& King::operator<< (std::ostream& os, const King::Circle2D& in) { return os << "{ " << "center: " << in.GetCenter() << " radius: " << setw(9) << in.GetRadius() << " }"; }
+std::ostream& King::operator<< (std::ostream& os, const King::Segment2D& in) { return os << "{ " << "a: " << in.GetA() << " b: " << in.GetB() << " }"; }
+std::ostream& King::operator<< (std::ostream& os, const King::Polygon2D& in)
+{
+    os << "{ " << "vertices: " << in.GetVertexCount();
+    for (size_t i = 0; i < in.GetVertexCount(); ++i)
+        os << " " << in.GetVertex(i);
+    return os << " }";
+}
+
+/******************************************************************************
+*   json
+******************************************************************************/
+void King::to_json(json& j, const Rect2D& from) { j = json{ {"min", from.GetMin()}, {"max", from.GetMax()} }; }
+void King::to_json(json& j, const Circle2D& from) { j = json{ {"center", from.GetCenter()}, {"radius", from.GetRadius()} }; }
+void King::to_json(json& j, const Segment2D& from) { j = json{ {"a", from.GetA()}, {"b", from.GetB()} }; }
+void King::to_json(json& j, const Polygon2D& from)
+{
+    std::vector<FloatPoint2> vertices;
+    vertices.reserve(from.GetVertexCount());
+    for (size_t i = 0; i < from.GetVertexCount(); ++i)
+        vertices.push_back(from.GetVertex(i));
+    j = json{ {"vertices", vertices} };
+}
+void King::to_json(json& j, const Penetration2D& from) { j = json{ {"normal", { from.normal.x, from.normal.y }}, {"depth", from.depth}, {"overlap", from.overlap} }; }
+void King::from_json(const json& j, Rect2D& to) { FloatPoint2 mn, mx; j.at("min").get_to(mn); j.at("max").get_to(mx); to = Rect2D(mn, mx); }
+void King::from_json(const json& j, Circle2D& to) { FloatPoint2 c; j.at("center").get_to(c); to = Circle2D(c, j.at("radius").get<float>()); }
+void King::from_json(const json& j, Segment2D& to) { FloatPoint2 a, b; j.at("a").get_to(a); j.at("b").get_to(b); to = Segment2D(a, b); }
+void King::from_json(const json& j, Polygon2D& to)
+{
+    std::vector<FloatPoint2> vertices;
+    for (const auto& each : j.at("vertices"))
+    {
+        FloatPoint2 p;
+        each.get_to(p);
+        vertices.push_back(p);
+    }
+    to.Set(vertices.data(), vertices.size());
+}
+
+/******************************************************************************
+*   Helpers
+*       Shapes of one vector transpose four at a time, x's, y's, z's and w's
+******************************************************************************/
+namespace
+{
+    // rows past count are zero and must be masked by the caller
+    template<class T>
+    inline DirectX::XMMATRIX __vectorcall LoadTransposed4(const T* in, size_t index, size_t count)
+    {
+        DirectX::XMMATRIX m;
+        for (size_t j = 0; j < 4; ++j)
+            m.r[j] = (index + j < count) ? in[index + j].v : DirectX::XMVectorZero();
+        return DirectX::XMMatrixTranspose(m);
+    }
+
+    // comparison mask to bits, lanes at or past count cleared
+    inline int __vectorcall LaneBits(DirectX::FXMVECTOR mask, size_t index, size_t count)
+    {
+        int bits = _mm_movemask_ps(mask);
+        if (count - index < 4)
+            bits &= (1 << (count - index)) - 1;
+        return bits;
+    }
+
+    inline size_t AppendLanes(int bits, size_t index, std::vector<uint32_t>& indicesOut)
+    {
+        size_t found = 0;
+        for (int lane = 0; bits; ++lane, bits >>= 1)
+        {
+            if (bits & 1)
+            {
+                indicesOut.push_back(static_cast<uint32_t>(index + lane));
+                ++found;
+            }
+        }
+        return found;
+    }
+
+    inline float __vectorcall HorizontalMin(DirectX::FXMVECTOR v) { using namespace DirectX; const XMVECTOR m = XMVectorMin(v, XMVectorSwizzle<1, 0, 3, 2>(v)); return XMVectorGetX(XMVectorMin(m, XMVectorSwizzle<2, 3, 0, 1>(m))); }
+    inline float __vectorcall HorizontalMax(DirectX::FXMVECTOR v) { using namespace DirectX; const XMVECTOR m = XMVectorMax(v, XMVectorSwizzle<1, 0, 3, 2>(v)); return XMVectorGetX(XMVectorMax(m, XMVectorSwizzle<2, 3, 0, 1>(m))); }
+
+    inline DirectX::XMVECTOR LoadFloat4(const float* f) { return DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4*>(f)); }
+
+    // range of the polygon along an axis, 4 vertices per step, padding repeats vertex 0
+    inline void Project(const Polygon2D& polygon, const float nx, const float ny, float* minOut, float* maxOut)
+    {
+        using namespace DirectX;
+        const XMVECTOR vnx = XMVectorReplicate(nx);
+        const XMVECTOR vny = XMVectorReplicate(ny);
+        const float* x = polygon.GetX();
+        const float* y = polygon.GetY();
+        const size_t padded = (polygon.GetVertexCount() + 3) & ~size_t(3);
+        XMVECTOR lo = XMVectorReplicate(std::numeric_limits<float>::max());
+        XMVECTOR hi = XMVectorNegate(lo);
+        for (size_t i = 0; i < padded; i += 4)
+        {
+            const XMVECTOR d = XMVectorMultiplyAdd(LoadFloat4(x + i), vnx, XMVectorMultiply(LoadFloat4(y + i), vny));
+            lo = XMVectorMin(lo, d);
+            hi = XMVectorMax(hi, d);
+        }
+        *minOut = HorizontalMin(lo);
+        *maxOut = HorizontalMax(hi);
+    }
+
+    // least overlap over the edge normals of axes, false at the first separating axis
+    inline bool LeastOverlap(const Polygon2D& axes, const Polygon2D& a, const Polygon2D& b, float* depthInOut, float* nxOut, float* nyOut)
+    {
+        const float* x = axes.GetX();
+        const float* y = axes.GetY();
+        for (size_t e = 0; e < axes.GetVertexCount(); ++e)
+        {
+            const float ex = x[e + 1] - x[e];
+            const float ey = y[e + 1] - y[e];
+            const float length = std::sqrt(ex * ex + ey * ey);
+            if (length <= 0.0f)
+                continue;
+            const float nx = ey / length;
+            const float ny = -ex / length;
+            float minA, maxA, minB, maxB;
+            Project(a, nx, ny, &minA, &maxA);
+            Project(b, nx, ny, &minB, &maxB);
+            const float forward = maxA - minB; // push b along +n
+            const float backward = maxB - minA; // push b along -n
+            const float depth = std::min(forward, backward);
+            if (depth <= 0.0f)
+                return false;
+            if (depth < *depthInOut)
+            {
+                *depthInOut = depth;
+                const float sign = forward <= backward ? 1.0f : -1.0f;
+                *nxOut = nx * sign;
+                *nyOut = ny * sign;
+            }
+        }
+        return true;
+    }
+}
+
+/******************************************************************************
+*   Rect2D
+******************************************************************************/
+Rect2D King::Rect2D::Bounds(const FloatPoint2* points, size_t count)
+{
+    if (!count)
+        return Rect2D();
+    DirectX::XMVECTOR lo = points[0];
+    DirectX::XMVECTOR hi = points[0];
+    for (size_t i = 1; i < count; ++i)
+    {
+        lo = DirectX::XMVectorMin(lo, points[i]);
+        hi = DirectX::XMVectorMax(hi, points[i]);
+    }
+    return Rect2D(FloatPoint2(lo), FloatPoint2(hi));
+}
+
+void King::Rect2D::Intersects(const Rect2D* a, const Rect2D* b, uint8_t* overlapOut, size_t count)
+{
+    KING_MATH_COUNT("Rect2D::Intersects(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        overlapOut[i] = a[i].Intersects(b[i]) ? 1 : 0;
+}
+
+size_t King::Rect2D::Query(const Rect2D* rects, size_t count, const FloatPoint2 point, std::vector<uint32_t>& indicesOut)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Rect2D::Query(point)", count);
+    const XMVECTOR px = XMVectorSplatX(point);
+    const XMVECTOR py = XMVectorSplatY(point);
+    size_t found = 0;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX m = LoadTransposed4(rects, i, count);
+        const XMVECTOR inside = XMVectorAndInt(XMVectorAndInt(XMVectorLessOrEqual(m.r[0], px), XMVectorLessOrEqual(m.r[1], py)), XMVectorAndInt(XMVectorLess(px, m.r[2]), XMVectorLess(py, m.r[3])));
+        found += AppendLanes(LaneBits(inside, i, count), i, indicesOut);
+    }
+    return found;
+}
+
+size_t King::Rect2D::Query(const Rect2D* rects, size_t count, const Rect2D& query, std::vector<uint32_t>& indicesOut)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Rect2D::Query(rect)", count);
+    const XMVECTOR minX = XMVectorSplatX(query.v);
+    const XMVECTOR minY = XMVectorSplatY(query.v);
+    const XMVECTOR maxX = XMVectorSplatZ(query.v);
+    const XMVECTOR maxY = XMVectorSplatW(query.v);
+    size_t found = 0;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX m = LoadTransposed4(rects, i, count);
+        const XMVECTOR overlap = XMVectorAndInt(XMVectorAndInt(XMVectorLess(minX, m.r[2]), XMVectorLess(m.r[0], maxX)), XMVectorAndInt(XMVectorLess(minY, m.r[3]), XMVectorLess(m.r[1], maxY)));
+        found += AppendLanes(LaneBits(overlap, i, count), i, indicesOut);
+    }
+    return found;
+}
+
+/******************************************************************************
+*   Circle2D
+******************************************************************************/
+bool King::Circle2D::Overlap(const Circle2D& a, const Circle2D& b, Penetration2D* out)
+{
+    const float dx = DirectX::XMVectorGetX(b.v) - DirectX::XMVectorGetX(a.v);
+    const float dy = DirectX::XMVectorGetY(b.v) - DirectX::XMVectorGetY(a.v);
+    const float radii = a.GetRadius() + b.GetRadius();
+    const float distanceSq = dx * dx + dy * dy;
+    if (distanceSq >= radii * radii)
+    {
+        if (out)
+            *out = Penetration2D();
+        return false;
+    }
+    if (out)
+    {
+        const float distance = std::sqrt(distanceSq);
+        out->normal = distance > 0.0f ? DirectX::XMFLOAT2(dx / distance, dy / distance) : DirectX::XMFLOAT2(1.0f, 0.0f); // concentric pushes along +x
+        out->depth = radii - distance;
+        out->overlap = true;
+    }
+    return true;
+}
+
+void King::Circle2D::Overlap(const Circle2D* a, const Circle2D* b, Penetration2D* out, size_t count)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Circle2D::Overlap(batch)", count);
+    const XMVECTOR zero = XMVectorZero();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX ca = LoadTransposed4(a, i, count);
+        const XMMATRIX cb = LoadTransposed4(b, i, count);
+        const XMVECTOR dx = XMVectorSubtract(cb.r[0], ca.r[0]);
+        const XMVECTOR dy = XMVectorSubtract(cb.r[1], ca.r[1]);
+        const XMVECTOR radii = XMVectorAdd(ca.r[2], cb.r[2]);
+        const XMVECTOR distanceSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiply(dy, dy));
+        const XMVECTOR overlap = XMVectorLess(distanceSq, XMVectorMultiply(radii, radii));
+        const XMVECTOR distance = XMVectorSqrt(distanceSq);
+        const XMVECTOR apart = XMVectorLessOrEqual(distance, zero);
+        const XMVECTOR inverse = XMVectorReciprocal(XMVectorSelect(distance, XMVectorSplatOne(), apart));
+        XMFLOAT4 nx, ny, depth;
+        XMStoreFloat4(&nx, XMVectorAndInt(XMVectorSelect(XMVectorMultiply(dx, inverse), XMVectorSplatOne(), apart), overlap));
+        XMStoreFloat4(&ny, XMVectorAndInt(XMVectorSelect(XMVectorMultiply(dy, inverse), zero, apart), overlap));
+        XMStoreFloat4(&depth, XMVectorAndInt(XMVectorSubtract(radii, distance), overlap));
+        const int bits = _mm_movemask_ps(overlap);
+        const float* fx = &nx.x;
+        const float* fy = &ny.x;
+        const float* fd = &depth.x;
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+        {
+            out[i + j].normal = XMFLOAT2(fx[j], fy[j]);
+            out[i + j].depth = fd[j];
+            out[i + j].overlap = (bits >> j) & 1;
+        }
+    }
+}
+
+size_t King::Circle2D::Query(const Circle2D* circles, size_t count, const FloatPoint2 point, std::vector<uint32_t>& indicesOut)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Circle2D::Query(point)", count);
+    const XMVECTOR px = XMVectorSplatX(point);
+    const XMVECTOR py = XMVectorSplatY(point);
+    size_t found = 0;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX m = LoadTransposed4(circles, i, count);
+        const XMVECTOR dx = XMVectorSubtract(px, m.r[0]);
+        const XMVECTOR dy = XMVectorSubtract(py, m.r[1]);
+        const XMVECTOR inside = XMVectorLessOrEqual(XMVectorMultiplyAdd(dx, dx, XMVectorMultiply(dy, dy)), XMVectorMultiply(m.r[2], m.r[2]));
+        found += AppendLanes(LaneBits(inside, i, count), i, indicesOut);
+    }
+    return found;
+}
+
+/******************************************************************************
+*   Segment2D
+******************************************************************************/
+FloatPoint2 __vectorcall King::Segment2D::ClosestPoint(const FloatPoint2 point) const
+{
+    using namespace DirectX;
+    const XMVECTOR direction = XMVectorSubtract(XMVectorSwizzle<2, 3, 2, 3>(v), v);
+    const float lengthSq = XMVectorGetX(XMVector2Dot(direction, direction));
+    if (lengthSq <= 0.0f)
+        return GetA();
+    const float t = std::min(std::max(XMVectorGetX(XMVector2Dot(XMVectorSubtract(point, v), direction)) / lengthSq, 0.0f), 1.0f);
+    return FloatPoint2(XMVectorMultiplyAdd(direction, XMVectorReplicate(t), v));
+}
+
+bool King::Segment2D::Intersect(const Segment2D& in, float* tOut) const
+{
+    DirectX::XMFLOAT4 a, b;
+    DirectX::XMStoreFloat4(&a, v);
+    DirectX::XMStoreFloat4(&b, in.v);
+    const float rx = a.z - a.x, ry = a.w - a.y;
+    const float sx = b.z - b.x, sy = b.w - b.y;
+    const float qx = b.x - a.x, qy = b.y - a.y;
+    const float denominator = rx * sy - ry * sx;
+    if (denominator == 0.0f)
+        return false;
+    const float t = (qx * sy - qy * sx) / denominator;
+    const float u = (qx * ry - qy * rx) / denominator;
+    if (t < 0.0f || t > 1.0f || u < 0.0f || u > 1.0f)
+        return false;
+    if (tOut)
+        *tOut = t;
+    return true;
+}
+
+void King::Segment2D::Intersect(const Segment2D* a, const Segment2D* b, uint8_t* hitOut, float* tOut, size_t count)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Segment2D::Intersect(batch)", count);
+    const XMVECTOR zero = XMVectorZero();
+    const XMVECTOR one = XMVectorSplatOne();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX sa = LoadTransposed4(a, i, count);
+        const XMMATRIX sb = LoadTransposed4(b, i, count);
+        const XMVECTOR rx = XMVectorSubtract(sa.r[2], sa.r[0]);
+        const XMVECTOR ry = XMVectorSubtract(sa.r[3], sa.r[1]);
+        const XMVECTOR sx = XMVectorSubtract(sb.r[2], sb.r[0]);
+        const XMVECTOR sy = XMVectorSubtract(sb.r[3], sb.r[1]);
+        const XMVECTOR qx = XMVectorSubtract(sb.r[0], sa.r[0]);
+        const XMVECTOR qy = XMVectorSubtract(sb.r[1], sa.r[1]);
+        const XMVECTOR denominator = XMVectorNegativeMultiplySubtract(ry, sx, XMVectorMultiply(rx, sy));
+        const XMVECTOR parallel = XMVectorEqual(denominator, zero);
+        const XMVECTOR inverse = XMVectorReciprocal(XMVectorSelect(denominator, one, parallel));
+        const XMVECTOR t = XMVectorMultiply(XMVectorNegativeMultiplySubtract(qy, sx, XMVectorMultiply(qx, sy)), inverse);
+        const XMVECTOR u = XMVectorMultiply(XMVectorNegativeMultiplySubtract(qy, rx, XMVectorMultiply(qx, ry)), inverse);
+        const XMVECTOR within = XMVectorAndInt(XMVectorAndInt(XMVectorGreaterOrEqual(t, zero), XMVectorLessOrEqual(t, one)), XMVectorAndInt(XMVectorGreaterOrEqual(u, zero), XMVectorLessOrEqual(u, one)));
+        const int bits = LaneBits(XMVectorAndInt(within, XMVectorNotEqual(denominator, zero)), i, count);
+        XMFLOAT4 ft;
+        XMStoreFloat4(&ft, t);
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+        {
+            hitOut[i + j] = (bits >> j) & 1;
+            if (tOut)
+                tOut[i + j] = (&ft.x)[j];
+        }
+    }
+}
+
+void King::Segment2D::Distance(const Segment2D* segments, size_t count, const FloatPoint2 point, float* distancesOut)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Segment2D::Distance(batch)", count);
+    const XMVECTOR px = XMVectorSplatX(point);
+    const XMVECTOR py = XMVectorSplatY(point);
+    const XMVECTOR zero = XMVectorZero();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const XMMATRIX s = LoadTransposed4(segments, i, count);
+        const XMVECTOR rx = XMVectorSubtract(s.r[2], s.r[0]);
+        const XMVECTOR ry = XMVectorSubtract(s.r[3], s.r[1]);
+        const XMVECTOR qx = XMVectorSubtract(px, s.r[0]);
+        const XMVECTOR qy = XMVectorSubtract(py, s.r[1]);
+        const XMVECTOR lengthSq = XMVectorMultiplyAdd(rx, rx, XMVectorMultiply(ry, ry));
+        const XMVECTOR degenerate = XMVectorLessOrEqual(lengthSq, zero);
+        const XMVECTOR t = XMVectorSelect(XMVectorSaturate(XMVectorDivide(XMVectorMultiplyAdd(qx, rx, XMVectorMultiply(qy, ry)), XMVectorSelect(lengthSq, XMVectorSplatOne(), degenerate))), zero, degenerate);
+        const XMVECTOR dx = XMVectorNegativeMultiplySubtract(rx, t, qx);
+        const XMVECTOR dy = XMVectorNegativeMultiplySubtract(ry, t, qy);
+        XMFLOAT4 d;
+        XMStoreFloat4(&d, XMVectorSqrt(XMVectorMultiplyAdd(dx, dx, XMVectorMultiply(dy, dy))));
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+            distancesOut[i + j] = (&d.x)[j];
+    }
+}
+
+/******************************************************************************
+*   Polygon2D
+******************************************************************************/
+King::Polygon2D::Polygon2D(const Rect2D& rect)
+{
+    const FloatPoint2 mn = rect.GetMin();
+    const FloatPoint2 mx = rect.GetMax();
+    const float xs[4] = { mn.GetX(), mx.GetX(), mx.GetX(), mn.GetX() };
+    const float ys[4] = { mn.GetY(), mn.GetY(), mx.GetY(), mx.GetY() };
+    Set(xs, ys, 4);
+}
+
+void King::Polygon2D::Set(const float* xs, const float* ys, size_t count)
+{
+    vertexCount = count;
+    if (!count)
+    {
+        x.clear();
+        y.clear();
+        return;
+    }
+    const size_t padded = GetPaddedCount();
+    x.assign(padded + 1, xs[0]);
+    y.assign(padded + 1, ys[0]);
+    std::copy(xs, xs + count, x.begin());
+    std::copy(ys, ys + count, y.begin());
+}
+
+void King::Polygon2D::Set(const FloatPoint2* points, size_t count)
+{
+    std::vector<float> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xs[i] = points[i].GetX();
+        ys[i] = points[i].GetY();
+    }
+    Set(xs.data(), ys.data(), count);
+}
+
+void King::Polygon2D::Reverse()
+{
+    if (vertexCount < 2)
+        return;
+    std::vector<float> xs(x.rbegin() + (x.size() - vertexCount), x.rend());
+    std::vector<float> ys(y.rbegin() + (y.size() - vertexCount), y.rend());
+    Set(xs.data(), ys.data(), vertexCount);
+}
+
+float King::Polygon2D::GetSignedArea() const
+{
+    using namespace DirectX;
+    XMVECTOR sum = XMVectorZero();
+    for (size_t i = 0; i < GetPaddedCount(); i += 4)
+        sum = XMVectorAdd(sum, XMVectorNegativeMultiplySubtract(LoadFloat4(&x[i + 1]), LoadFloat4(&y[i]), XMVectorMultiply(LoadFloat4(&x[i]), LoadFloat4(&y[i + 1]))));
+    return 0.5f * XMVectorGetX(SumComponentsFixedOrder(sum));
+}
+
+FloatPoint2 King::Polygon2D::GetCentroid() const
+{
+    using namespace DirectX;
+    if (!vertexCount)
+        return FloatPoint2();
+    XMVECTOR area = XMVectorZero();
+    XMVECTOR cx = XMVectorZero();
+    XMVECTOR cy = XMVectorZero();
+    for (size_t i = 0; i < GetPaddedCount(); i += 4)
+    {
+        const XMVECTOR xi = LoadFloat4(&x[i]), xj = LoadFloat4(&x[i + 1]);
+        const XMVECTOR yi = LoadFloat4(&y[i]), yj = LoadFloat4(&y[i + 1]);
+        const XMVECTOR cross = XMVectorNegativeMultiplySubtract(xj, yi, XMVectorMultiply(xi, yj));
+        area = XMVectorAdd(area, cross);
+        cx = XMVectorMultiplyAdd(XMVectorAdd(xi, xj), cross, cx);
+        cy = XMVectorMultiplyAdd(XMVectorAdd(yi, yj), cross, cy);
+    }
+    const float twiceArea = XMVectorGetX(SumComponentsFixedOrder(area));
+    if (twiceArea == 0.0f)
+    {
+        // degenerate, mean of the vertices
+        float sx = 0.0f, sy = 0.0f;
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            sx += x[i];
+            sy += y[i];
+        }
+        return FloatPoint2(sx / vertexCount, sy / vertexCount);
+    }
+    const float scale = 1.0f / (3.0f * twiceArea);
+    return FloatPoint2(XMVectorGetX(SumComponentsFixedOrder(cx)) * scale, XMVectorGetX(SumComponentsFixedOrder(cy)) * scale);
+}
+
+Rect2D King::Polygon2D::GetBounds() const
+{
+    using namespace DirectX;
+    if (!vertexCount)
+        return Rect2D();
+    XMVECTOR loX = XMVectorReplicate(x[0]), hiX = loX;
+    XMVECTOR loY = XMVectorReplicate(y[0]), hiY = loY;
+    for (size_t i = 0; i < GetPaddedCount(); i += 4)
+    {
+        const XMVECTOR xi = LoadFloat4(&x[i]);
+        const XMVECTOR yi = LoadFloat4(&y[i]);
+        loX = XMVectorMin(loX, xi);
+        hiX = XMVectorMax(hiX, xi);
+        loY = XMVectorMin(loY, yi);
+        hiY = XMVectorMax(hiY, yi);
+    }
+    return Rect2D(HorizontalMin(loX), HorizontalMin(loY), HorizontalMax(hiX), HorizontalMax(hiY));
+}
+
+bool King::Polygon2D::IsConvex() const
+{
+    if (vertexCount < 3)
+        return false;
+    float sign = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const size_t j = i + 1;
+        const size_t k = (i + 2) % vertexCount;
+        const float cross = (x[j] - x[i]) * (y[k] - y[j]) - (y[j] - y[i]) * (x[k] - x[j]);
+        if (cross == 0.0f)
+            continue; // collinear
+        if (sign == 0.0f)
+            sign = cross;
+        else if ((cross > 0.0f) != (sign > 0.0f))
+            return false;
+    }
+    return sign != 0.0f;
+}
+
+bool __vectorcall King::Polygon2D::Contains(const FloatPoint2 point) const
+{
+    using namespace DirectX;
+    if (vertexCount < 3)
+        return false;
+    const XMVECTOR px = XMVectorSplatX(point);
+    const XMVECTOR py = XMVectorSplatY(point);
+    XMVECTOR odd = XMVectorZero();
+    // padding edges run from vertex 0 to itself and never straddle
+    for (size_t i = 0; i < GetPaddedCount(); i += 4)
+    {
+        const XMVECTOR xi = LoadFloat4(&x[i]), xj = LoadFloat4(&x[i + 1]);
+        const XMVECTOR yi = LoadFloat4(&y[i]), yj = LoadFloat4(&y[i + 1]);
+        const XMVECTOR straddle = XMVectorXorInt(XMVectorGreater(yi, py), XMVectorGreater(yj, py));
+        const XMVECTOR crossingX = XMVectorMultiplyAdd(XMVectorSubtract(py, yi), XMVectorDivide(XMVectorSubtract(xj, xi), XMVectorSubtract(yj, yi)), xi);
+        odd = XMVectorXorInt(odd, XMVectorAndInt(straddle, XMVectorLess(px, crossingX)));
+    }
+    const int bits = _mm_movemask_ps(odd);
+    return (((bits) ^ (bits >> 1) ^ (bits >> 2) ^ (bits >> 3)) & 1) != 0;
+}
+
+void King::Polygon2D::Contains(const FloatPoint2* points, size_t count, uint8_t* insideOut) const
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Polygon2D::Contains(batch)", count);
+    if (vertexCount < 3)
+    {
+        std::fill(insideOut, insideOut + count, uint8_t(0));
+        return;
+    }
+    // x step per unit y of each edge, horizontal edges never straddle so their infinity is masked
+    std::vector<float> slope(GetPaddedCount());
+    for (size_t e = 0; e < GetPaddedCount(); e += 4)
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&slope[e]), XMVectorDivide(XMVectorSubtract(LoadFloat4(&x[e + 1]), LoadFloat4(&x[e])), XMVectorSubtract(LoadFloat4(&y[e + 1]), LoadFloat4(&y[e]))));
+    for (size_t i = 0; i < count; i += 4)
+    {
+        XMMATRIX m;
+        for (size_t j = 0; j < 4; ++j)
+            m.r[j] = (i + j < count) ? points[i + j].v : XMVectorZero();
+        m = XMMatrixTranspose(m);
+        const XMVECTOR px = m.r[0];
+        const XMVECTOR py = m.r[1];
+        XMVECTOR odd = XMVectorZero();
+        for (size_t e = 0; e < vertexCount; ++e)
+        {
+            const XMVECTOR yi = XMVectorReplicate(y[e]);
+            const XMVECTOR straddle = XMVectorXorInt(XMVectorGreater(yi, py), XMVectorGreater(XMVectorReplicate(y[e + 1]), py));
+            const XMVECTOR crossingX = XMVectorMultiplyAdd(XMVectorSubtract(py, yi), XMVectorReplicate(slope[e]), XMVectorReplicate(x[e]));
+            odd = XMVectorXorInt(odd, XMVectorAndInt(straddle, XMVectorLess(px, crossingX)));
+        }
+        const int bits = _mm_movemask_ps(odd);
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+            insideOut[i + j] = (bits >> j) & 1;
+    }
+}
+
+Polygon2D King::Polygon2D::Clip(const Polygon2D& convexClipper) const
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Polygon2D::Clip", vertexCount);
+    if (!vertexCount || convexClipper.GetVertexCount() < 3)
+        return Polygon2D();
+    const float orientation = convexClipper.GetSignedArea() < 0.0f ? -1.0f : 1.0f;
+    std::vector<float> inX(x.begin(), x.begin() + vertexCount), inY(y.begin(), y.begin() + vertexCount);
+    std::vector<float> outX, outY, side;
+    const float* cx = convexClipper.GetX();
+    const float* cy = convexClipper.GetY();
+    for (size_t e = 0; e < convexClipper.GetVertexCount() && !inX.empty(); ++e)
+    {
+        const size_t n = inX.size();
+        const size_t padded = (n + 3) & ~size_t(3);
+        inX.resize(padded, inX[0]);
+        inY.resize(padded, inY[0]);
+        side.resize(padded);
+        // signed distance of every vertex to the clip edge, inside is positive, 4 vertices per step
+        const XMVECTOR ex = XMVectorReplicate((cx[e + 1] - cx[e]) * orientation);
+        const XMVECTOR ey = XMVectorReplicate((cy[e + 1] - cy[e]) * orientation);
+        const XMVECTOR ox = XMVectorReplicate(cx[e]);
+        const XMVECTOR oy = XMVectorReplicate(cy[e]);
+        for (size_t i = 0; i < padded; i += 4)
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&side[i]), XMVectorNegativeMultiplySubtract(ey, XMVectorSubtract(LoadFloat4(&inX[i]), ox), XMVectorMultiply(ex, XMVectorSubtract(LoadFloat4(&inY[i]), oy))));
+        outX.clear();
+        outY.clear();
+        for (size_t i = 0, previous = n - 1; i < n; previous = i++)
+        {
+            const bool inside = side[i] >= 0.0f;
+            const bool previousInside = side[previous] >= 0.0f;
+            if (inside != previousInside)
+            {
+                const float t = side[previous] / (side[previous] - side[i]);
+                outX.push_back(inX[previous] + (inX[i] - inX[previous]) * t);
+                outY.push_back(inY[previous] + (inY[i] - inY[previous]) * t);
+            }
+            if (inside)
+            {
+                outX.push_back(inX[i]);
+                outY.push_back(inY[i]);
+            }
+        }
+        std::swap(inX, outX);
+        std::swap(inY, outY);
+    }
+    Polygon2D clipped;
+    clipped.Set(inX.data(), inY.data(), inX.size());
+    return clipped;
+}
+
+bool King::Polygon2D::Overlap(const Polygon2D& convexA, const Polygon2D& convexB, Penetration2D* out)
+{
+    KING_MATH_COUNT("Polygon2D::Overlap", convexA.GetVertexCount() + convexB.GetVertexCount());
+    float depth = std::numeric_limits<float>::max();
+    float nx = 0.0f, ny = 0.0f;
+    if (convexA.GetVertexCount() < 3 || convexB.GetVertexCount() < 3 || !LeastOverlap(convexA, convexA, convexB, &depth, &nx, &ny) || !LeastOverlap(convexB, convexA, convexB, &depth, &nx, &ny))
+    {
+        if (out)
+            *out = Penetration2D();
+        return false;
+    }
+    if (out)
+    {
+        out->normal = DirectX::XMFLOAT2(nx, ny);
+        out->depth = depth;
+        out->overlap = true;
+    }
+    return true;
+}
+
+void King::Polygon2D::Overlap(const Polygon2D* convexA, const Polygon2D* convexB, Penetration2D* out, size_t count)
+{
+    KING_MATH_COUNT("Polygon2D::Overlap(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        Overlap(convexA[i], convexB[i], &out[i]);
+}
@@ -0,0 +1,239 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDGeometry2D
+
+Description:    2D primitives on FloatPoint2 for UI hit testing and 2D physics:
+                Rect2D, Circle2D, Segment2D and Polygon2D.  Rects, circles and
+                segments are one XMVECTOR each so arrays of them transpose four at
+                a time for the batch tests; polygons keep their vertices as
+                separate x and y arrays so edges are tested four at a time.
+
+                    std::vector<uint32_t> hits;
+                    King::Rect2D::Query(widgets.data(), widgets.size(), cursor, hits);
+
+                    King::Penetration2D contact;
+                    if (King::Polygon2D::Overlap(boxA, boxB, &contact))
+                        positionB += float2(contact.normal) * contact.depth;
+
+                Rects are half open, [min, max), so neighboring UI rects sharing
+                an edge neither overlap nor both contain a point on the edge.
+                Polygon clipping and SAT expect convex polygons, point in polygon
+                (even-odd) accepts any simple or self intersecting polygon.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <initializer_list>
+
+namespace King {
+
+    /******************************************************************************
+    *   Penetration2D
+    *       Result of an overlap test between two shapes
+    ******************************************************************************/
+    struct Penetration2D
+    {
+        DirectX::XMFLOAT2                       normal = { 0.0f, 0.0f }; // unit axis of least overlap, from a toward b
+        float                                   depth = 0.0f;           // move b by normal * depth to separate, 0 when apart
+        bool                                    overlap = false;        // touching shapes are apart
+    };
+
+    /******************************************************************************
+    *   Rect2D
+    *       min x, min y, max x, max y in one vector, half open [min, max)
+    ******************************************************************************/
+    class alignas(16) Rect2D
+    {
+        /* variables */
+    public:
+        DirectX::XMVECTOR                       v;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline Rect2D() noexcept { v = DirectX::XMVectorZero(); }
+        inline Rect2D(const float minX, const float minY, const float maxX, const float maxY) { v = DirectX::XMVectorSet(minX, minY, maxX, maxY); }
+        inline Rect2D(const FloatPoint2 minIn, const FloatPoint2 maxIn) { v = DirectX::XMVectorPermute<0, 1, 4, 5>(minIn, maxIn); }
+        inline Rect2D(const IntPoint2 minIn, const IntPoint2 maxIn) { v = DirectX::XMVectorSet(static_cast<float>(minIn.GetX()), static_cast<float>(minIn.GetY()), static_cast<float>(maxIn.GetX()), static_cast<float>(maxIn.GetY())); } // pixel rect, max is one past the last pixel
+        inline explicit Rect2D(const DirectX::XMVECTOR & vecIn) { v = vecIn; }
+        // Comparators
+        inline bool operator== (const Rect2D& rhs) const { return DirectX::XMVector4Equal(v, rhs.v); }
+        inline bool operator!= (const Rect2D& rhs) const { return DirectX::XMVector4NotEqual(v, rhs.v); }
+        // Accessors
+        inline FloatPoint2                      GetMin() const { return FloatPoint2(v); }
+        inline FloatPoint2                      GetMax() const { return FloatPoint2(DirectX::XMVectorSwizzle<2, 3, 2, 3>(v)); }
+        inline FloatPoint2                      GetSize() const { return FloatPoint2(DirectX::XMVectorSubtract(DirectX::XMVectorSwizzle<2, 3, 2, 3>(v), v)); }
+        inline FloatPoint2                      GetCenter() const { return FloatPoint2(DirectX::XMVectorScale(DirectX::XMVectorAdd(DirectX::XMVectorSwizzle<2, 3, 2, 3>(v), v), 0.5f)); }
+        inline float                            GetWidth() const { return DirectX::XMVectorGetZ(v) - DirectX::XMVectorGetX(v); }
+        inline float                            GetHeight() const { return DirectX::XMVectorGetW(v) - DirectX::XMVectorGetY(v); }
+        inline float                            GetArea() const { return IsEmpty() ? 0.0f : GetWidth() * GetHeight(); }
+        // Tests
+        inline bool                             IsEmpty() const { return !DirectX::XMVector2Less(v, DirectX::XMVectorSwizzle<2, 3, 2, 3>(v)); }
+        inline bool __vectorcall                Contains(const FloatPoint2 point) const { return DirectX::XMVector2LessOrEqual(v, point) && DirectX::XMVector2Less(point, DirectX::XMVectorSwizzle<2, 3, 2, 3>(v)); }
+        inline bool                             Contains(const Rect2D& in) const { return DirectX::XMVector2LessOrEqual(v, in.v) && DirectX::XMVector2LessOrEqual(DirectX::XMVectorSwizzle<2, 3, 2, 3>(in.v), DirectX::XMVectorSwizzle<2, 3, 2, 3>(v)); }
+        inline bool                             Intersects(const Rect2D& in) const { return DirectX::XMVector4Less(DirectX::XMVectorPermute<4, 5, 0, 1>(v, in.v), DirectX::XMVectorPermute<2, 3, 6, 7>(v, in.v)); } // in.min < max and min < in.max
+        // Functionality
+        inline Rect2D                           Intersection(const Rect2D& in) const { return Rect2D(DirectX::XMVectorSelect(DirectX::XMVectorMin(v, in.v), DirectX::XMVectorMax(v, in.v), DirectX::g_XMSelect1100)); } // empty when apart
+        inline Rect2D                           Union(const Rect2D& in) const { return Rect2D(DirectX::XMVectorSelect(DirectX::XMVectorMax(v, in.v), DirectX::XMVectorMin(v, in.v), DirectX::g_XMSelect1100)); }
+        inline Rect2D                           Inflate(const float amount) const { return Rect2D(DirectX::XMVectorAdd(v, DirectX::XMVectorSet(-amount, -amount, amount, amount))); }
+        inline FloatPoint2 __vectorcall         ClosestPoint(const FloatPoint2 point) const { return FloatPoint2(DirectX::XMVectorClamp(point, v, DirectX::XMVectorSwizzle<2, 3, 2, 3>(v))); }
+        // Statics
+        static inline Rect2D __vectorcall       FromPositionSize(const FloatPoint2 position, const FloatPoint2 size) { return Rect2D(position, position + size); }
+        static Rect2D                           Bounds(const FloatPoint2* points, size_t count); // smallest rect holding the points, max is inclusive
+        static void                             Intersects(const Rect2D* a, const Rect2D* b, uint8_t* overlapOut, size_t count); // batch, 1 or 0 per pair
+        static size_t                           Query(const Rect2D* rects, size_t count, const FloatPoint2 point, std::vector<uint32_t>& indicesOut); // batch, 4 wide, appends rects containing point
+        static size_t                           Query(const Rect2D* rects, size_t count, const Rect2D& query, std::vector<uint32_t>& indicesOut); // batch, 4 wide, appends rects overlapping query
+    };
+
+    /******************************************************************************
+    *   Circle2D
+    *       center x, center y, radius in one vector
+    ******************************************************************************/
+    class alignas(16) Circle2D
+    {
+        /* variables */
+    public:
+        DirectX::XMVECTOR                       v;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline Circle2D() noexcept { v = DirectX::XMVectorZero(); }
+        inline Circle2D(const float x, const float y, const float radius) { v = DirectX::XMVectorSet(x, y, radius, 0.0f); }
+        inline Circle2D(const FloatPoint2 center, const float radius) { v = DirectX::XMVectorSetZ(DirectX::XMVectorSelect(DirectX::XMVectorZero(), center, DirectX::g_XMSelect1100), radius); }
+        inline explicit Circle2D(const DirectX::XMVECTOR & vecIn) { v = vecIn; }
+        // Accessors
+        inline FloatPoint2                      GetCenter() const { return FloatPoint2(v); }
+        inline float                            GetRadius() const { return DirectX::XMVectorGetZ(v); }
+        inline Rect2D                           GetBounds() const { auto r = DirectX::XMVectorSplatZ(v); auto c = DirectX::XMVectorSwizzle<0, 1, 0, 1>(v); return Rect2D(DirectX::XMVectorAdd(c, DirectX::XMVectorSelect(DirectX::XMVectorNegate(r), r, DirectX::g_XMSelect0011))); }
+        // Assignments
+        inline void __vectorcall                SetCenter(const FloatPoint2 center) { v = DirectX::XMVectorSelect(v, center, DirectX::g_XMSelect1100); }
+        inline void                             SetRadius(const float radius) { v = DirectX::XMVectorSetZ(v, radius); }
+        // Tests
+        inline bool __vectorcall                Contains(const FloatPoint2 point) const { auto d = DirectX::XMVectorSubtract(point, v); return DirectX::XMVectorGetX(DirectX::XMVector2Dot(d, d)) <= GetRadius() * GetRadius(); }
+        inline bool                             Intersects(const Circle2D& in) const { auto d = DirectX::XMVectorSubtract(in.v, v); const float r = GetRadius() + in.GetRadius(); return DirectX::XMVectorGetX(DirectX::XMVector2Dot(d, d)) < r * r; }
+        inline bool                             Intersects(const Rect2D& in) const { return Contains(in.ClosestPoint(GetCenter())) && !in.IsEmpty(); }
+        // Statics
+        static bool                             Overlap(const Circle2D& a, const Circle2D& b, Penetration2D* out = nullptr);
+        static void                             Overlap(const Circle2D* a, const Circle2D* b, Penetration2D* out, size_t count); // batch, 4 wide
+        static size_t                           Query(const Circle2D* circles, size_t count, const FloatPoint2 point, std::vector<uint32_t>& indicesOut); // batch, 4 wide, appends circles containing point
+    };
+
+    /******************************************************************************
+    *   Segment2D
+    *       a x, a y, b x, b y in one vector
+    ******************************************************************************/
+    class alignas(16) Segment2D
+    {
+        /* variables */
+    public:
+        DirectX::XMVECTOR                       v;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline Segment2D() noexcept { v = DirectX::XMVectorZero(); }
+        inline Segment2D(const float ax, const float ay, const float bx, const float by) { v = DirectX::XMVectorSet(ax, ay, bx, by); }
+        inline Segment2D(const FloatPoint2 a, const FloatPoint2 b) { v = DirectX::XMVectorPermute<0, 1, 4, 5>(a, b); }
+        inline explicit Segment2D(const DirectX::XMVECTOR & vecIn) { v = vecIn; }
+        // Accessors
+        inline FloatPoint2                      GetA() const { return FloatPoint2(v); }
+        inline FloatPoint2                      GetB() const { return FloatPoint2(DirectX::XMVectorSwizzle<2, 3, 2, 3>(v)); }
+        inline FloatPoint2                      GetDirection() const { return FloatPoint2(DirectX::XMVectorSubtract(DirectX::XMVectorSwizzle<2, 3, 2, 3>(v), v)); } // b - a, not normalized
+        inline float                            GetLength() const { return DirectX::XMVectorGetX(DirectX::XMVector2Length(GetDirection())); }
+        inline Rect2D                           GetBounds() const { auto swapped = DirectX::XMVectorSwizzle<2, 3, 0, 1>(v); return Rect2D(DirectX::XMVectorSelect(DirectX::XMVectorMax(v, swapped), DirectX::XMVectorMin(v, swapped), DirectX::g_XMSelect1100)); } // max is inclusive
+        // Functionality
+        FloatPoint2 __vectorcall                ClosestPoint(const FloatPoint2 point) const;
+        inline float __vectorcall               Distance(const FloatPoint2 point) const { return DirectX::XMVectorGetX(DirectX::XMVector2Length(DirectX::XMVectorSubtract(point, ClosestPoint(point)))); }
+        bool                                    Intersect(const Segment2D& in, float* tOut = nullptr) const; // tOut is along this segment, parallel and collinear segments do not hit
+        // Statics
+        static void                             Intersect(const Segment2D* a, const Segment2D* b, uint8_t* hitOut, float* tOut, size_t count); // batch, 4 wide, tOut may be null
+        static void                             Distance(const Segment2D* segments, size_t count, const FloatPoint2 point, float* distancesOut); // batch, 4 wide
+    };
+
+    /******************************************************************************
+    *   Polygon2D
+    *       Vertices kept as x and y arrays, closed with copies of the first
+    *       vertex up to a multiple of 4 so edges load four at a time
+    ******************************************************************************/
+    class Polygon2D
+    {
+        /* variables */
+    private:
+        std::vector<float>                      x;
+        std::vector<float>                      y;
+        size_t                                  vertexCount = 0;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        Polygon2D() = default;
+        Polygon2D(const FloatPoint2* points, size_t count) { Set(points, count); }
+        explicit Polygon2D(const std::vector<FloatPoint2>& points) { Set(points.data(), points.size()); }
+        Polygon2D(std::initializer_list<FloatPoint2> points) { Set(points.begin(), points.size()); }
+        explicit Polygon2D(const Rect2D& rect); // counterclockwise with +y up
+        // Accessors
+        inline size_t                           GetVertexCount() const { return vertexCount; }
+        inline FloatPoint2                      GetVertex(size_t i) const { assert(i < vertexCount); return FloatPoint2(x[i], y[i]); }
+        inline const float*                     GetX() const { return x.data(); }
+        inline const float*                     GetY() const { return y.data(); }
+        float                                   GetSignedArea() const; // positive when counterclockwise with +y up
+        inline float                            GetArea() const { return std::abs(GetSignedArea()); }
+        FloatPoint2                             GetCentroid() const;
+        Rect2D                                  GetBounds() const; // max is inclusive
+        // Assignments
+        void                                    Set(const FloatPoint2* points, size_t count);
+        void                                    Set(const float* xs, const float* ys, size_t count);
+        void                                    Reverse();
+        // Tests
+        bool                                    IsConvex() const;
+        bool __vectorcall                       Contains(const FloatPoint2 point) const; // even-odd, 4 edges per step
+        // Functionality
+        void                                    Contains(const FloatPoint2* points, size_t count, uint8_t* insideOut) const; // batch, 4 points per step, 1 or 0 per point
+        Polygon2D                               Clip(const Polygon2D& convexClipper) const; // Sutherland-Hodgman, this may be concave
+        inline Polygon2D                        Clip(const Rect2D& rect) const { return Clip(Polygon2D(rect)); }
+        // Statics
+        static bool                             Overlap(const Polygon2D& convexA, const Polygon2D& convexB, Penetration2D* out = nullptr); // separating axis test
+        static void                             Overlap(const Polygon2D* convexA, const Polygon2D* convexB, Penetration2D* out, size_t count); // batch
+    private:
+        size_t                                  GetPaddedCount() const { return (vertexCount + 3) & ~size_t(3); }
+    };
+
+    std::ostream& operator<< (std::ostream& os, const Rect2D& in);
+    std::ostream& operator<< (std::ostream& os, const Circle2D& in);
+    std::ostream& operator<< (std::ostream& os, const Segment2D& in);
+    std::ostream& operator<< (std::ostream& os, const Polygon2D& in);
+
+    void to_json(json& j, const Rect2D& from);
+    void to_json(json& j, const Circle2D& from);
+    void to_json(json& j, const Segment2D& from);
+    void to_json(json& j, const Polygon2D& from);
+    void to_json(json& j, const Penetration2D& from);
+    void from_json(const json& j, Rect2D& to);
+    void from_json(const json& j, Circle2D& to);
+    void from_json(const json& j, Segment2D& to);
+    void from_json(const json& j, Polygon2D& to);
+}
@@ -0,0 +1,52 @@
+﻿#include "MathSIMDHashMap.h"
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    // bits 0..20 of v to every third bit
+    inline uint64_t Spread3(uint64_t v)
+    {
+        v &= 0x1FFFFF;
+        v = (v | v << 32) & 0x1F00000000FFFFull;
+        v = (v | v << 16) & 0x1F0000FF0000FFull;
+        v = (v | v << 8) & 0x100F00F00F00F00Full;
+        v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+        v = (v | v << 2) & 0x1249249249249249ull;
+        return v;
+    }
+
+    // splitmix64 finalizer
+    inline uint64_t Mix(uint64_t h)
+    {
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        return h ^ (h >> 31);
+    }
+}
+
+/******************************************************************************
+*   Hashing
+******************************************************************************/
+uint64_t King::MortonCode(const int32_t x, const int32_t y, const int32_t z)
+{
+    constexpr uint32_t bias = 1u << 20;
+    return Spread3(static_cast<uint32_t>(x) + bias) | Spread3(static_cast<uint32_t>(y) + bias) << 1 | Spread3(static_cast<uint32_t>(z) + bias) << 2;
+}
+
+uint64_t King::HashIntPoint3(const int32_t x, const int32_t y, const int32_t z)
+{
+    // the 11 high bits of each coordinate above the Morton code, zero for keys within +-2^20
+    const uint64_t high = uint64_t((static_cast<uint32_t>(x) + (1u << 20)) >> 21) | uint64_t((static_cast<uint32_t>(y) + (1u << 20)) >> 21) << 11 | uint64_t((static_cast<uint32_t>(z) + (1u << 20)) >> 21) << 22;
+    return Mix(MortonCode(x, y, z) ^ (high << 31 | high >> 33));
+}
+
+void King::HashIntPoint3(const IntPoint3* keysIn, uint64_t* hashesOut, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        hashesOut[i] = HashIntPoint3(keysIn[i].GetX(), keysIn[i].GetY(), keysIn[i].GetZ());
+}
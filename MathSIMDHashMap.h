@@ -0,0 +1,384 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDHashMap
+
+Description:    Sparse voxel storage keyed by IntPoint3.  IntPoint3HashMap is an
+                open addressing table in groups of 16 slots with one control
+                byte per slot (empty, deleted or 7 bits of the hash); one SSE2
+                compare matches a whole group, so most lookups touch a single
+                control line and a single slot.  The hash interleaves the low 21
+                bits of x, y and z (Morton order) and mixes in the high bits.
+
+                    King::IntPoint3HashMap<uint16_t> terrain;
+                    terrain[King::IntPoint3(4, -2, 17)] = material;
+                    terrain.InsertOrAssign(editedVoxels.data(), materials.data(), editedVoxels.size());
+                    terrain.Find(queries.data(), found.data(), hit.data(), queries.size());
+                    terrain.ForEach([](const King::IntPoint3& voxel, uint16_t& material) { ... });
+
+                Bulk insert, find and erase hash a block of keys first and
+                prefetch their groups before probing, hiding the cache misses of
+                one key behind the others.  ForEach walks the slots in memory
+                order.  Values are default constructed in every slot, so keep T
+                small; pointers and references to values are invalidated when
+                the table grows.  IntPoint3Hash and IntPoint3Equal make IntPoint3
+                usable as a key of the standard containers as well.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include "MathSIMDInstrument.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   Hashing
+    ******************************************************************************/
+    uint64_t                                    MortonCode(const int32_t x, const int32_t y, const int32_t z); // low 21 bits of each, biased to unsigned, x in bit 0
+    inline uint64_t                             MortonCode(const IntPoint3& p) { return MortonCode(p.GetX(), p.GetY(), p.GetZ()); }
+    uint64_t                                    HashIntPoint3(const int32_t x, const int32_t y, const int32_t z); // Morton code with the high bits folded in, mixed
+    inline uint64_t                             HashIntPoint3(const IntPoint3& p) { return HashIntPoint3(p.GetX(), p.GetY(), p.GetZ()); }
+    void                                        HashIntPoint3(const IntPoint3* keysIn, uint64_t* hashesOut, size_t count); // batch
+
+    struct IntPoint3Hash
+    {
+        inline size_t                           operator()(const IntPoint3& p) const { return static_cast<size_t>(HashIntPoint3(p)); }
+    };
+    struct IntPoint3Equal
+    {
+        inline bool                             operator()(const IntPoint3& a, const IntPoint3& b) const { return a.GetX() == b.GetX() && a.GetY() == b.GetY() && a.GetZ() == b.GetZ(); }
+    };
+
+    /******************************************************************************
+    *   IntPoint3HashMap
+    ******************************************************************************/
+    template<class T>
+    class IntPoint3HashMap
+    {
+        static constexpr int8_t                 Empty = -128;
+        static constexpr int8_t                 Deleted = -2;
+        static constexpr size_t                 GroupSize = 16;
+        static constexpr size_t                 Block = 16; // keys hashed and prefetched ahead by the bulk operations
+
+        struct Slot
+        {
+            int32_t                             x, y, z;
+            T                                   value;
+        };
+
+        /* variables */
+    private:
+        std::vector<int8_t>                     control;    // per slot: Empty, Deleted or the low 7 bits of the hash
+        std::vector<Slot>                       slots;
+        size_t                                  count = 0;
+        size_t                                  growthLeft = 0; // empty slots that may still be filled before 7/8 load
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        explicit IntPoint3HashMap(const size_t capacity = 0) { Reserve(capacity); }
+        // Functionality
+        inline T*                               Find(const IntPoint3& key) { const size_t s = FindSlot(key.GetX(), key.GetY(), key.GetZ(), HashIntPoint3(key)); return s == NotFound ? nullptr : &slots[s].value; }
+        inline const T*                         Find(const IntPoint3& key) const { const size_t s = FindSlot(key.GetX(), key.GetY(), key.GetZ(), HashIntPoint3(key)); return s == NotFound ? nullptr : &slots[s].value; }
+        inline bool                             Contains(const IntPoint3& key) const { return Find(key) != nullptr; }
+        std::pair<T*, bool>                     Insert(const IntPoint3& key, const T& value) // the existing value is kept, second is true when inserted
+        {
+            bool inserted;
+            T* v = Emplace(key.GetX(), key.GetY(), key.GetZ(), HashIntPoint3(key), inserted);
+            if (inserted)
+                *v = value;
+            return { v, inserted };
+        }
+        inline T&                               operator[](const IntPoint3& key) { bool inserted; return *Emplace(key.GetX(), key.GetY(), key.GetZ(), HashIntPoint3(key), inserted); }
+        bool                                    Erase(const IntPoint3& key) { return EraseSlot(FindSlot(key.GetX(), key.GetY(), key.GetZ(), HashIntPoint3(key))); }
+        // bulk, keys hashed a block at a time with their groups prefetched
+        size_t                                  InsertOrAssign(const IntPoint3* keys, const T* values, size_t n); // existing values are overwritten, returns the newly inserted
+        size_t                                  Find(const IntPoint3* keys, T* valuesOut, uint8_t* foundOut, size_t n) const; // valuesOut may be null, returns the found
+        size_t                                  Erase(const IntPoint3* keys, size_t n); // returns the erased
+        void                                    Clear();
+        void                                    Reserve(const size_t n); // room for n keys without growing
+        template<class Function>
+        void                                    ForEach(Function&& function); // function(const IntPoint3& key, T& value) in slot order
+        template<class Function>
+        void                                    ForEach(Function&& function) const; // function(const IntPoint3& key, const T& value) in slot order
+        size_t                                  GetKeys(std::vector<IntPoint3>& keysOut) const; // appends, slot order
+        // Accessors
+        inline size_t                           GetCount() const { return count; }
+        inline size_t                           GetCapacity() const { return slots.size(); }
+        inline bool                             IsEmpty() const { return count == 0; }
+
+    private:
+        static constexpr size_t                 NotFound = ~size_t(0);
+        inline size_t                           GroupMask() const { return slots.size() / GroupSize - 1; }
+        static inline int8_t                    Fingerprint(const uint64_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+        static inline size_t                    FirstGroup(const uint64_t hash) { return static_cast<size_t>(hash >> 7); }
+        inline int                              Match(const size_t group, const int8_t value) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&control[group * GroupSize])), _mm_set1_epi8(value))); }
+        inline int                              MatchFree(const size_t group) const { return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&control[group * GroupSize]))); } // empty or deleted, sign bit set
+        inline void                             Prefetch(const uint64_t hash) const
+        {
+            if (slots.empty())
+                return;
+            const size_t group = FirstGroup(hash) & GroupMask();
+            _mm_prefetch(reinterpret_cast<const char*>(&control[group * GroupSize]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(&slots[group * GroupSize]), _MM_HINT_T0);
+        }
+        size_t                                  FindSlot(const int32_t x, const int32_t y, const int32_t z, const uint64_t hash) const;
+        T*                                      Emplace(const int32_t x, const int32_t y, const int32_t z, const uint64_t hash, bool& inserted);
+        bool                                    EraseSlot(const size_t s);
+        void                                    Rehash(const size_t capacity);
+    };
+
+    /******************************************************************************
+    *   IntPoint3HashMap definitions
+    ******************************************************************************/
+    template<class T>
+    size_t IntPoint3HashMap<T>::FindSlot(const int32_t x, const int32_t y, const int32_t z, const uint64_t hash) const
+    {
+        if (count == 0)
+            return NotFound;
+        // groups visited in triangular steps, every group once for a power of two group count
+        const size_t mask = GroupMask();
+        size_t group = FirstGroup(hash) & mask;
+        for (size_t step = 1; step <= mask + 1; ++step)
+        {
+            for (int bits = Match(group, Fingerprint(hash)); bits; bits &= bits - 1)
+            {
+                int lane = 0;
+                while (!((bits >> lane) & 1))
+                    ++lane;
+                const size_t s = group * GroupSize + lane;
+                if (slots[s].x == x && slots[s].y == y && slots[s].z == z)
+                    return s;
+            }
+            if (Match(group, Empty))
+                return NotFound;
+            group = (group + step) & mask;
+        }
+        return NotFound;
+    }
+
+    template<class T>
+    T* IntPoint3HashMap<T>::Emplace(const int32_t x, const int32_t y, const int32_t z, const uint64_t hash, bool& inserted)
+    {
+        const size_t found = FindSlot(x, y, z, hash);
+        inserted = found == NotFound;
+        if (!inserted)
+            return &slots[found].value;
+        if (growthLeft == 0)
+            Rehash(count + 1 > slots.size() / 2 ? std::max<size_t>(GroupSize, slots.size() * 2) : slots.size());
+        const size_t mask = GroupMask();
+        size_t group = FirstGroup(hash) & mask;
+        for (size_t step = 1;; ++step)
+        {
+            if (const int bits = MatchFree(group))
+            {
+                int lane = 0;
+                while (!((bits >> lane) & 1))
+                    ++lane;
+                const size_t s = group * GroupSize + lane;
+                growthLeft -= control[s] == Empty;
+                control[s] = Fingerprint(hash);
+                slots[s].x = x;
+                slots[s].y = y;
+                slots[s].z = z;
+                slots[s].value = T();
+                ++count;
+                return &slots[s].value;
+            }
+            group = (group + step) & mask;
+        }
+    }
+
+    template<class T>
+    bool IntPoint3HashMap<T>::EraseSlot(const size_t s)
+    {
+        if (s == NotFound)
+            return false;
+        // a group still holding an empty slot was never full, no probe went past it and the slot may become empty
+        const size_t group = s / GroupSize;
+        if (Match(group, Empty))
+        {
+            control[s] = Empty;
+            ++growthLeft;
+        }
+        else
+            control[s] = Deleted;
+        slots[s].value = T();
+        --count;
+        return true;
+    }
+
+    template<class T>
+    void IntPoint3HashMap<T>::Rehash(const size_t capacity)
+    {
+        std::vector<int8_t> oldControl(capacity, Empty);
+        std::vector<Slot> oldSlots(capacity);
+        control.swap(oldControl);
+        slots.swap(oldSlots);
+        count = 0;
+        growthLeft = capacity - capacity / 8;
+        for (size_t s = 0; s < oldSlots.size(); ++s)
+        {
+            if (oldControl[s] >= 0)
+            {
+                const Slot& from = oldSlots[s];
+                bool inserted;
+                *Emplace(from.x, from.y, from.z, HashIntPoint3(from.x, from.y, from.z), inserted) = std::move(oldSlots[s].value);
+            }
+        }
+    }
+
+    template<class T>
+    void IntPoint3HashMap<T>::Reserve(const size_t n)
+    {
+        size_t capacity = GroupSize;
+        while (capacity - capacity / 8 < n)
+            capacity *= 2;
+        if (capacity > slots.size())
+            Rehash(capacity);
+    }
+
+    template<class T>
+    void IntPoint3HashMap<T>::Clear()
+    {
+        std::fill(control.begin(), control.end(), Empty);
+        for (auto& slot : slots)
+            slot.value = T();
+        count = 0;
+        growthLeft = slots.size() - slots.size() / 8;
+    }
+
+    template<class T>
+    size_t IntPoint3HashMap<T>::InsertOrAssign(const IntPoint3* keys, const T* values, size_t n)
+    {
+        KING_MATH_COUNT("IntPoint3HashMap::InsertOrAssign(batch)", n);
+        Reserve(count + n);
+        uint64_t hashes[Block];
+        size_t inserted = 0;
+        for (size_t i = 0; i < n; i += Block)
+        {
+            const size_t m = std::min(Block, n - i);
+            HashIntPoint3(keys + i, hashes, m);
+            for (size_t j = 0; j < m; ++j)
+                Prefetch(hashes[j]);
+            for (size_t j = 0; j < m; ++j)
+            {
+                bool added;
+                *Emplace(keys[i + j].GetX(), keys[i + j].GetY(), keys[i + j].GetZ(), hashes[j], added) = values[i + j];
+                inserted += added;
+            }
+        }
+        return inserted;
+    }
+
+    template<class T>
+    size_t IntPoint3HashMap<T>::Find(const IntPoint3* keys, T* valuesOut, uint8_t* foundOut, size_t n) const
+    {
+        KING_MATH_COUNT("IntPoint3HashMap::Find(batch)", n);
+        uint64_t hashes[Block];
+        size_t found = 0;
+        for (size_t i = 0; i < n; i += Block)
+        {
+            const size_t m = std::min(Block, n - i);
+            HashIntPoint3(keys + i, hashes, m);
+            for (size_t j = 0; j < m; ++j)
+                Prefetch(hashes[j]);
+            for (size_t j = 0; j < m; ++j)
+            {
+                const size_t s = FindSlot(keys[i + j].GetX(), keys[i + j].GetY(), keys[i + j].GetZ(), hashes[j]);
+                if (foundOut)
+                    foundOut[i + j] = s != NotFound;
+                if (s != NotFound)
+                {
+                    if (valuesOut)
+                        valuesOut[i + j] = slots[s].value;
+                    ++found;
+                }
+            }
+        }
+        return found;
+    }
+
+    template<class T>
+    size_t IntPoint3HashMap<T>::Erase(const IntPoint3* keys, size_t n)
+    {
+        KING_MATH_COUNT("IntPoint3HashMap::Erase(batch)", n);
+        uint64_t hashes[Block];
+        size_t erased = 0;
+        for (size_t i = 0; i < n; i += Block)
+        {
+            const size_t m = std::min(Block, n - i);
+            HashIntPoint3(keys + i, hashes, m);
+            for (size_t j = 0; j < m; ++j)
+                Prefetch(hashes[j]);
+            for (size_t j = 0; j < m; ++j)
+                erased += EraseSlot(FindSlot(keys[i + j].GetX(), keys[i + j].GetY(), keys[i + j].GetZ(), hashes[j]));
+        }
+        return erased;
+    }
+
+    template<class T>
+    template<class Function>
+    void IntPoint3HashMap<T>::ForEach(Function&& function)
+    {
+        for (size_t group = 0; group < slots.size() / GroupSize; ++group)
+        {
+            for (int bits = ~MatchFree(group) & 0xFFFF; bits; bits &= bits - 1)
+            {
+                int lane = 0;
+                while (!((bits >> lane) & 1))
+                    ++lane;
+                Slot& slot = slots[group * GroupSize + lane];
+                function(IntPoint3(slot.x, slot.y, slot.z), slot.value);
+            }
+        }
+    }
+
+    template<class T>
+    template<class Function>
+    void IntPoint3HashMap<T>::ForEach(Function&& function) const
+    {
+        for (size_t group = 0; group < slots.size() / GroupSize; ++group)
+        {
+            for (int bits = ~MatchFree(group) & 0xFFFF; bits; bits &= bits - 1)
+            {
+                int lane = 0;
+                while (!((bits >> lane) & 1))
+                    ++lane;
+                const Slot& slot = slots[group * GroupSize + lane];
+                function(IntPoint3(slot.x, slot.y, slot.z), slot.value);
+            }
+        }
+    }
+
+    template<class T>
+    size_t IntPoint3HashMap<T>::GetKeys(std::vector<IntPoint3>& keysOut) const
+    {
+        const size_t before = keysOut.size();
+        keysOut.reserve(before + count);
+        ForEach([&keysOut](const IntPoint3& key, const T&) { keysOut.push_back(key); });
+        return keysOut.size() - before;
+    }
+}
@@ -0,0 +1,86 @@
+﻿#include "MathSIMDInstrument.h"
+#include <algorithm>
+
+using namespace King;
+using namespace std;
+
+namespace
+{
+    // lock free push only list, counters are statics and live until exit
+    std::atomic<Instrument::Counter*> registryHead{ nullptr };
+
+    Instrument::CounterValues Snapshot(const Instrument::Counter& counter)
+    {
+        Instrument::CounterValues values;
+        values.name = counter.name;
+        values.calls = counter.calls.load(std::memory_order_relaxed);
+        values.elements = counter.elements.load(std::memory_order_relaxed);
+        values.cycles = counter.cycles.load(std::memory_order_relaxed);
+        return values;
+    }
+}
+
+King::Instrument::Counter::Counter(const char* nameIn) : name(nameIn)
+{
+    assert(nameIn);
+    Counter* head = registryHead.load(std::memory_order_relaxed);
+    do
+    {
+        next = head;
+    } while (!registryHead.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::vector<King::Instrument::CounterValues> King::Instrument::GetCounters()
+{
+    std::vector<CounterValues> counters;
+    for (const Counter* counter = registryHead.load(std::memory_order_acquire); counter; counter = counter->next)
+        counters.push_back(Snapshot(*counter));
+    std::stable_sort(counters.begin(), counters.end(), [](const CounterValues& a, const CounterValues& b) { return a.cycles > b.cycles; });
+    return counters;
+}
+
+bool King::Instrument::GetCounter(const std::string& name, CounterValues* valuesOut)
+{
+    assert(valuesOut);
+    for (const Counter* counter = registryHead.load(std::memory_order_acquire); counter; counter = counter->next)
+    {
+        if (name == counter->name)
+        {
+            *valuesOut = Snapshot(*counter);
+            return true;
+        }
+    }
+    return false;
+}
+
+void King::Instrument::Reset()
+{
+    for (Counter* counter = registryHead.load(std::memory_order_acquire); counter; counter = counter->next)
+    {
+        counter->calls.store(0, std::memory_order_relaxed);
+        counter->elements.store(0, std::memory_order_relaxed);
+        counter->cycles.store(0, std::memory_order_relaxed);
+    }
+}
+
+json King::Instrument::ToJson()
+{
+    json j;
+    j["enabled"] = IsEnabled();
+    j["counters"] = GetCounters();
+    return j;
+}
+
+void King::Instrument::DumpToJson(std::ostream& os) { os << std::setw(4) << ToJson() << std::endl; }
+
+bool King::Instrument::IsEnabled()
+{
+#if defined(KING_MATH_INSTRUMENT)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void King::Instrument::to_json(json& j, const CounterValues& from) { j = json{ {"name", from.name}, {"calls", from.calls}, {"elements", from.elements}, {"cycles", from.cycles}, {"cyclesPerElement", from.CyclesPerElement()} }; }
+void King::Instrument::from_json(const json& j, CounterValues& to) { j.at("name").get_to(to.name); j.at("calls").get_to(to.calls); j.at("elements").get_to(to.elements); j.at("cycles").get_to(to.cycles); }
@@ -0,0 +1,137 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDInstrument
+
+Description:    Optional counters for the hot math paths.  Define
+                KING_MATH_INSTRUMENT when building MathSIMD and each batch kernel
+                and major scalar method counts its calls, the elements it
+                processed and the cycles (rdtsc) spent inside.  Counters register
+                themselves on first use so the registry only lists paths that ran.
+                Without the define the macro is empty and there is no cost.
+
+                    auto counters = King::Instrument::GetCounters();
+                    King::Instrument::DumpToJson(std::cout);
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <atomic>
+#include <string>
+#include <chrono>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace King {
+
+    namespace Instrument
+    {
+        // time stamp counter, steady clock ticks where there is none
+        inline uint64_t ReadCycles()
+        {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        /******************************************************************************
+        *   Counter
+        *       One per instrumented path, a function local static that links itself
+        *       into the registry when first constructed
+        ******************************************************************************/
+        class Counter
+        {
+            /* variables */
+        public:
+            const char* const           name;
+            std::atomic<uint64_t>       calls{ 0 };
+            std::atomic<uint64_t>       elements{ 0 };
+            std::atomic<uint64_t>       cycles{ 0 };
+            Counter*                    next = nullptr;
+
+            /* methods */
+        public:
+            explicit Counter(const char* nameIn);
+            Counter(const Counter&) = delete;
+            Counter& operator= (const Counter&) = delete;
+
+            inline void                 Add(const uint64_t elementsIn, const uint64_t cyclesIn)
+            {
+                calls.fetch_add(1, std::memory_order_relaxed);
+                elements.fetch_add(elementsIn, std::memory_order_relaxed);
+                cycles.fetch_add(cyclesIn, std::memory_order_relaxed);
+            }
+        };
+        /******************************************************************************
+        *   Scope
+        *       Adds the cycles from construction to destruction to its counter
+        ******************************************************************************/
+        class Scope
+        {
+        public:
+            inline Scope(Counter& counterIn, const uint64_t elementsIn) : counter(counterIn), elements(elementsIn), start(ReadCycles()) {}
+            inline ~Scope() { counter.Add(elements, ReadCycles() - start); }
+            Scope(const Scope&) = delete;
+            Scope& operator= (const Scope&) = delete;
+        private:
+            Counter&                    counter;
+            const uint64_t              elements;
+            const uint64_t              start;
+        };
+
+        // snapshot of a counter
+        struct CounterValues
+        {
+            std::string                 name;
+            uint64_t                    calls = 0;
+            uint64_t                    elements = 0;
+            uint64_t                    cycles = 0;
+            inline double               CyclesPerElement() const { return elements ? static_cast<double>(cycles) / static_cast<double>(elements) : 0.0; }
+        };
+
+        // registry
+        std::vector<CounterValues>      GetCounters(); // most cycles first
+        bool                            GetCounter(const std::string& name, CounterValues* valuesOut);
+        void                            Reset(); // zero every counter, registrations are kept
+        json                            ToJson();
+        void                            DumpToJson(std::ostream& os);
+        bool                            IsEnabled();
+
+        void                            to_json(json& j, const CounterValues& from);
+        void                            from_json(const json& j, CounterValues& to);
+    }
+}
+
+// place at the top of an instrumented function, elements is the count of items the call processes
+#if defined(KING_MATH_INSTRUMENT)
+#define KING_MATH_COUNT(name, elements) static King::Instrument::Counter kingMathCounter(name); King::Instrument::Scope kingMathScope(kingMathCounter, static_cast<uint64_t>(elements))
+#else
+#define KING_MATH_COUNT(name, elements)
+#endif
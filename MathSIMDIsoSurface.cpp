@@ -0,0 +1,308 @@
+﻿#include "MathSIMDIsoSurface.h"
+#include "MathSIMDInstrument.h"
+#include "MathSIMDHashMap.h"
+#include "MathSIMDParallel.h"
+#include <algorithm>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    // corner c of a cell is at offset (c & 1, (c >> 1) & 1, (c >> 2) & 1); edge e runs along axis e / 4 from the corner
+    // with the other two axes' bits taken from e % 4, lower axis first
+    struct CaseTable
+    {
+        int8_t                                  triangles[256][37]; // edge triples, -1 terminated
+        uint8_t                                 edgeCorner[12];     // corner the edge starts from
+        uint8_t                                 edgeAxis[12];
+
+        CaseTable()
+        {
+            for (int e = 0; e < 12; ++e)
+            {
+                const int axis = e / 4;
+                const int o1 = (axis + 1) % 3 < (axis + 2) % 3 ? (axis + 1) % 3 : (axis + 2) % 3;
+                const int o2 = 3 - axis - o1;
+                edgeAxis[e] = static_cast<uint8_t>(axis);
+                edgeCorner[e] = static_cast<uint8_t>(((e & 1) << o1) | (((e >> 1) & 1) << o2));
+            }
+            for (int c = 0; c < 256; ++c)
+                Build(c);
+        }
+
+        static int EdgeId(const int c0, const int c1)
+        {
+            const int axis = (c0 ^ c1) == 1 ? 0 : (c0 ^ c1) == 2 ? 1 : 2;
+            const int start = c0 & ~(1 << axis);
+            const int o1 = (axis + 1) % 3 < (axis + 2) % 3 ? (axis + 1) % 3 : (axis + 2) % 3;
+            const int o2 = 3 - axis - o1;
+            return axis * 4 + (((start >> o1) & 1) | (((start >> o2) & 1) << 1));
+        }
+
+        // bit 2 * axis + side for the two cell faces holding edge e
+        int FaceMask(const int e) const
+        {
+            const int axis = edgeAxis[e];
+            int mask = 0;
+            for (int other = 0; other < 3; ++other)
+            {
+                if (other != axis)
+                    mask |= 1 << (2 * other + ((edgeCorner[e] >> other) & 1));
+            }
+            return mask;
+        }
+
+        void Build(const int inside)
+        {
+            // on each face, corners counter clockwise seen from outside, link the crossing leaving the inside corners to
+            // the next crossing; every crossing edge ends up with one successor and one predecessor, forming loops
+            int next[12];
+            std::fill_n(next, 12, -1);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                for (int side = 0; side < 2; ++side)
+                {
+                    const int u = side ? (axis + 1) % 3 : (axis + 2) % 3;
+                    const int v = side ? (axis + 2) % 3 : (axis + 1) % 3;
+                    const int uv[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+                    int corner[4];
+                    for (int k = 0; k < 4; ++k)
+                        corner[k] = (side << axis) | (uv[k][0] << u) | (uv[k][1] << v);
+                    int crossing[4], leaving[4], n = 0;
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        const bool a = (inside >> corner[k]) & 1;
+                        const bool b = (inside >> corner[(k + 1) % 4]) & 1;
+                        if (a != b)
+                        {
+                            crossing[n] = EdgeId(corner[k], corner[(k + 1) % 4]);
+                            leaving[n++] = a;
+                        }
+                    }
+                    for (int k = 0; k < n; ++k)
+                    {
+                        if (leaving[k])
+                            next[crossing[k]] = crossing[(k + 1) % n];
+                    }
+                }
+            }
+            // fan each loop, reversed so the normal points out of the inside corners
+            int count = 0;
+            bool used[12] = {};
+            for (int start = 0; start < 12; ++start)
+            {
+                if (next[start] < 0 || used[start])
+                    continue;
+                int loop[12], length = 0;
+                for (int e = start; !used[e]; e = next[e])
+                {
+                    used[e] = true;
+                    loop[length++] = e;
+                }
+                // fan from a crossing whose diagonals never lie in a cell face, the neighbour cell would share them
+                int origin = 0;
+                for (int s = 0; s < length; ++s)
+                {
+                    bool inFace = false;
+                    for (int k = 2; k + 1 < length && !inFace; ++k)
+                        inFace = (FaceMask(loop[s]) & FaceMask(loop[(s + k) % length])) != 0;
+                    if (!inFace)
+                    {
+                        origin = s;
+                        break;
+                    }
+                }
+                for (int k = 1; k + 1 < length; ++k)
+                {
+                    triangles[inside][count++] = static_cast<int8_t>(loop[origin]);
+                    triangles[inside][count++] = static_cast<int8_t>(loop[(origin + k + 1) % length]);
+                    triangles[inside][count++] = static_cast<int8_t>(loop[(origin + k) % length]);
+                }
+            }
+            triangles[inside][count] = -1;
+        }
+    };
+
+    const CaseTable& GetCaseTable()
+    {
+        static const CaseTable table;
+        return table;
+    }
+
+    struct BlockOutput
+    {
+        IntPoint3HashMap<uint32_t>              edges;      // IntPoint3(3 * x + axis, y, z) of the starting point to the local vertex
+        std::vector<FloatPoint3>                vertices;
+        std::vector<FloatPoint3>                normals;
+        std::vector<uint32_t>                   indices;    // global after the vertex offsets are known
+        uint32_t                                firstVertex = 0;
+    };
+}
+
+/******************************************************************************
+*   MarchingCubes
+******************************************************************************/
+King::MarchingCubes::MarchingCubes(const int32_t blockSizeIn, const size_t threadsIn) :
+    blockSize(std::max(1, blockSizeIn))
+{
+    SetThreadCount(threadsIn);
+}
+
+void King::MarchingCubes::SetThreadCount(const size_t threadsIn)
+{
+    threads = threadsIn ? threadsIn : std::max<size_t>(1, SystemInfo::GetLogicalProcessorCount());
+}
+
+size_t King::MarchingCubes::Extract(const float* values, const IntPoint3 dimensions, const FloatPoint3 origin, const float spacing, const float isoValue,
+    std::vector<FloatPoint3>& verticesOut, std::vector<uint32_t>& indicesOut, std::vector<FloatPoint3>* normalsOut) const
+{
+    using namespace DirectX;
+    const int32_t nx = dimensions.GetX();
+    const int32_t ny = dimensions.GetY();
+    const int32_t nz = dimensions.GetZ();
+    if (nx < 2 || ny < 2 || nz < 2)
+        return 0;
+    KING_MATH_COUNT("MarchingCubes::Extract", size_t(nx - 1) * (ny - 1) * (nz - 1));
+    const CaseTable& table = GetCaseTable();
+    const size_t plane = size_t(nx) * ny;
+    const size_t points = plane * nz;
+    auto Index = [nx, plane](int32_t x, int32_t y, int32_t z) { return size_t(z) * plane + size_t(y) * nx + x; };
+
+    // inside flags, 4 points per compare
+    std::vector<uint8_t> inside(points + 3);
+    {
+        const XMVECTOR iso = XMVectorReplicate(isoValue);
+        size_t i = 0;
+        for (; i + 4 <= points; i += 4)
+        {
+            const int bits = _mm_movemask_ps(XMVectorLess(_mm_loadu_ps(values + i), iso));
+            inside[i] = bits & 1;
+            inside[i + 1] = (bits >> 1) & 1;
+            inside[i + 2] = (bits >> 2) & 1;
+            inside[i + 3] = (bits >> 3) & 1;
+        }
+        for (; i < points; ++i)
+            inside[i] = values[i] < isoValue;
+    }
+
+    // blocks of cells; a block owns the edges starting at its points, the last block per axis also the last points
+    const int32_t bx = (nx - 2) / blockSize + 1;
+    const int32_t by = (ny - 2) / blockSize + 1;
+    const int32_t bz = (nz - 2) / blockSize + 1;
+    std::vector<BlockOutput> blocks(size_t(bx) * by * bz);
+    auto BlockOf = [&](int32_t x, int32_t y, int32_t z) { return (size_t(std::min(z / blockSize, bz - 1)) * by + std::min(y / blockSize, by - 1)) * bx + std::min(x / blockSize, bx - 1); };
+    auto Gradient = [&](int32_t x, int32_t y, int32_t z)
+    {
+        const int32_t p[3] = { x, y, z };
+        const int32_t n[3] = { nx, ny, nz };
+        float g[3];
+        for (int a = 0; a < 3; ++a)
+        {
+            int32_t lo[3] = { x, y, z }, hi[3] = { x, y, z };
+            lo[a] = std::max(0, p[a] - 1);
+            hi[a] = std::min(n[a] - 1, p[a] + 1);
+            g[a] = (values[Index(hi[0], hi[1], hi[2])] - values[Index(lo[0], lo[1], lo[2])]) / float(std::max(1, hi[a] - lo[a]));
+        }
+        return XMVectorSet(g[0], g[1], g[2], 0.0f);
+    };
+    const bool wantNormals = normalsOut != nullptr;
+
+    ParallelItems(blocks.size(), threads, [&](size_t b)
+    {
+        BlockOutput& out = blocks[b];
+        const int32_t x0 = static_cast<int32_t>(b % bx) * blockSize;
+        const int32_t y0 = static_cast<int32_t>((b / bx) % by) * blockSize;
+        const int32_t z0 = static_cast<int32_t>(b / (size_t(bx) * by)) * blockSize;
+        const int32_t x1 = x0 / blockSize == bx - 1 ? nx : x0 + blockSize;
+        const int32_t y1 = y0 / blockSize == by - 1 ? ny : y0 + blockSize;
+        const int32_t z1 = z0 / blockSize == bz - 1 ? nz : z0 + blockSize;
+        for (int32_t z = z0; z < z1; ++z)
+        {
+            for (int32_t y = y0; y < y1; ++y)
+            {
+                for (int32_t x = x0; x < x1; ++x)
+                {
+                    const size_t p = Index(x, y, z);
+                    const int32_t q[3] = { x + 1, y + 1, z + 1 };
+                    const int32_t n[3] = { nx, ny, nz };
+                    const size_t step[3] = { 1, size_t(nx), plane };
+                    for (int a = 0; a < 3; ++a)
+                    {
+                        if (q[a] >= n[a] || inside[p] == inside[p + step[a]])
+                            continue;
+                        const float v0 = values[p];
+                        const float v1 = values[p + step[a]];
+                        const float t = (isoValue - v0) / (v1 - v0);
+                        XMVECTOR position = XMVectorSet(float(x), float(y), float(z), 0.0f);
+                        position = XMVectorAdd(position, XMVectorScale(a == 0 ? g_XMIdentityR0 : a == 1 ? g_XMIdentityR1 : g_XMIdentityR2, t));
+                        out.edges[IntPoint3(3 * x + a, y, z)] = static_cast<uint32_t>(out.vertices.size());
+                        out.vertices.emplace_back(XMVectorMultiplyAdd(position, XMVectorReplicate(spacing), origin));
+                        if (wantNormals)
+                        {
+                            const int32_t e[3] = { x + (a == 0), y + (a == 1), z + (a == 2) };
+                            const XMVECTOR g = XMVectorLerp(Gradient(x, y, z), Gradient(e[0], e[1], e[2]), t);
+                            out.normals.emplace_back(XMVector3Normalize(g));
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    uint32_t first = static_cast<uint32_t>(verticesOut.size());
+    for (auto& block : blocks)
+    {
+        block.firstVertex = first;
+        first += static_cast<uint32_t>(block.vertices.size());
+    }
+
+    // triangles of the cells, corners looked up in the block owning their edge
+    ParallelItems(blocks.size(), threads, [&](size_t b)
+    {
+        BlockOutput& out = blocks[b];
+        const int32_t x0 = static_cast<int32_t>(b % bx) * blockSize;
+        const int32_t y0 = static_cast<int32_t>((b / bx) % by) * blockSize;
+        const int32_t z0 = static_cast<int32_t>(b / (size_t(bx) * by)) * blockSize;
+        const int32_t x1 = std::min(nx - 1, x0 + blockSize);
+        const int32_t y1 = std::min(ny - 1, y0 + blockSize);
+        const int32_t z1 = std::min(nz - 1, z0 + blockSize);
+        for (int32_t z = z0; z < z1; ++z)
+        {
+            for (int32_t y = y0; y < y1; ++y)
+            {
+                for (int32_t x = x0; x < x1; ++x)
+                {
+                    const size_t p = Index(x, y, z);
+                    const int cube = inside[p] | inside[p + 1] << 1 | inside[p + nx] << 2 | inside[p + nx + 1] << 3
+                        | inside[p + plane] << 4 | inside[p + plane + 1] << 5 | inside[p + plane + nx] << 6 | inside[p + plane + nx + 1] << 7;
+                    if (cube == 0 || cube == 255)
+                        continue;
+                    for (const int8_t* e = table.triangles[cube]; *e >= 0; ++e)
+                    {
+                        const int c = table.edgeCorner[*e];
+                        const int32_t ex = x + (c & 1), ey = y + ((c >> 1) & 1), ez = z + ((c >> 2) & 1);
+                        const BlockOutput& owner = blocks[BlockOf(ex, ey, ez)];
+                        const uint32_t* local = owner.edges.Find(IntPoint3(3 * ex + table.edgeAxis[*e], ey, ez));
+                        assert(local);
+                        out.indices.push_back(owner.firstVertex + *local);
+                    }
+                }
+            }
+        }
+    });
+
+    size_t triangles = 0;
+    for (auto& block : blocks)
+    {
+        verticesOut.insert(verticesOut.end(), block.vertices.begin(), block.vertices.end());
+        if (normalsOut)
+            normalsOut->insert(normalsOut->end(), block.normals.begin(), block.normals.end());
+        indicesOut.insert(indicesOut.end(), block.indices.begin(), block.indices.end());
+        triangles += block.indices.size() / 3;
+    }
+    return triangles;
+}
@@ -0,0 +1,79 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDIsoSurface
+
+Description:    Marching cubes isosurface extraction from scalar fields sampled on
+                IntPoint3 grids, for meshes regenerated after every terrain edit.
+                Grid points are classified against the iso value four per compare,
+                then blocks of cells run on worker threads: each block places the
+                vertices of the crossing edges it owns, keyed by edge in an
+                IntPoint3HashMap, and the triangles look their corners up in the
+                owning block, so every vertex is shared across cells and blocks.
+
+                    King::MarchingCubes mc;
+                    std::vector<King::FloatPoint3> vertices, normals;
+                    std::vector<uint32_t> indices;
+                    mc.Extract(sdf.GetData(), sdf.GetDimensions(), sdf.GetOrigin() + sdf.GetVoxelSize() * 0.5f, sdf.GetVoxelSize(), 0.0f, vertices, indices, &normals);
+
+                Values below the iso value are inside; triangles wind counter
+                clockwise seen from outside and normals point toward increasing
+                values.  The case table is built once from the cube faces: each
+                face pairs its crossings so the inside corners of an ambiguous
+                face connect, the same choice in both cells sharing it, so the
+                surface has no cracks.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   MarchingCubes
+    ******************************************************************************/
+    class MarchingCubes
+    {
+        /* variables */
+    private:
+        int32_t                                 blockSize;
+        size_t                                  threads;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        explicit MarchingCubes(const int32_t blockSizeIn = 32, const size_t threadsIn = 0); // cells per block edge, 0 threads is one per logical processor
+        // Functionality
+        // values x fastest at origin + (x, y, z) * spacing; appends to the outputs and returns the triangles added
+        size_t                                  Extract(const float* values, const IntPoint3 dimensions, const FloatPoint3 origin, const float spacing, const float isoValue,
+                                                    std::vector<FloatPoint3>& verticesOut, std::vector<uint32_t>& indicesOut, std::vector<FloatPoint3>* normalsOut = nullptr) const;
+        // Accessors
+        inline int32_t                          GetBlockSize() const { return blockSize; }
+        inline size_t                           GetThreadCount() const { return threads; }
+        // Assignments
+        inline void                             SetBlockSize(const int32_t blockSizeIn) { blockSize = std::max(1, blockSizeIn); }
+        void                                    SetThreadCount(const size_t threadsIn);
+    };
+}
@@ -0,0 +1,450 @@
+﻿#include "MathSIMDNuma.h"
+#include "MathSIMDInstrument.h"
+#include <numeric>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <exception>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Memory
+******************************************************************************/
+size_t King::Numa::GetPageSize()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void* King::Numa::Reserve(const size_t bytes)
+{
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_READWRITE);
+#else
+    void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return address == MAP_FAILED ? nullptr : address;
+#endif
+}
+
+bool King::Numa::Commit(void* address, const size_t bytes, const int node)
+{
+    assert(address);
+    // node indexes the topology, the OS numbers nodes by their ids which may be sparse
+    const auto& ids = SystemInfo::GetTopology().numaNodeIds;
+    const long id = node >= 0 && static_cast<size_t>(node) < ids.size() ? static_cast<long>(ids[node]) : node;
+#if defined(_WIN32)
+    if (id >= 0 && VirtualAllocExNuma(GetCurrentProcess(), address, bytes, MEM_COMMIT, PAGE_READWRITE, static_cast<DWORD>(id)))
+        return true;
+    return VirtualAlloc(address, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+#if defined(__linux__) && defined(SYS_mbind)
+    // mbind without libnuma; the mapping is already usable so a refused binding leaves first touch placement
+    if (id >= 0)
+    {
+        const long MPOL_BIND_MODE = 2;
+        unsigned long mask[16] = {};
+        if (static_cast<size_t>(id) < sizeof(mask) * 8)
+        {
+            mask[id / (sizeof(unsigned long) * 8)] |= 1ul << (id % (sizeof(unsigned long) * 8));
+            syscall(SYS_mbind, address, bytes, MPOL_BIND_MODE, mask, sizeof(mask) * 8, 0u);
+        }
+    }
+#else
+    (void)bytes; (void)id;
+#endif
+    return true;
+#endif
+}
+
+void King::Numa::Release(void* address, const size_t bytes)
+{
+    if (!address)
+        return;
+#if defined(_WIN32)
+    (void)bytes;
+    VirtualFree(address, 0, MEM_RELEASE);
+#else
+    munmap(address, bytes);
+#endif
+}
+
+/******************************************************************************
+*   Placement
+******************************************************************************/
+bool King::Numa::PinCurrentThread(const unsigned node)
+{
+    const auto& topology = SystemInfo::GetTopology();
+    if (node >= topology.numaNodeProcessors.size() || topology.numaNodeProcessors[node].empty())
+        return false;
+    const auto& processors = topology.numaNodeProcessors[node];
+#if defined(_WIN32)
+    // a node lives in one processor group
+    GROUP_AFFINITY affinity = {};
+    affinity.Group = static_cast<WORD>(processors.front() / 64);
+    for (const unsigned processor : processors)
+        if (processor / 64 == affinity.Group)
+            affinity.Mask |= KAFFINITY(1) << (processor % 64);
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const unsigned processor : processors)
+        if (processor < CPU_SETSIZE)
+            CPU_SET(processor, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+std::vector<size_t> King::Numa::Partition(const size_t count, const size_t elementSize)
+{
+    assert(elementSize);
+    const auto& topology = SystemInfo::GetTopology();
+    const size_t nodes = std::max<size_t>(1, topology.numaNodeProcessors.size());
+    // smallest element count that is a whole number of pages and of 4 wide batches
+    const size_t page = GetPageSize();
+    size_t granule = page / std::gcd(page, elementSize);
+    granule = granule / std::gcd(granule, size_t(4)) * 4;
+
+    size_t totalProcessors = 0;
+    for (size_t node = 0; node < nodes; ++node)
+        totalProcessors += node < topology.numaNodeProcessors.size() ? topology.numaNodeProcessors[node].size() : 1;
+    totalProcessors = std::max<size_t>(1, totalProcessors);
+
+    std::vector<size_t> partitions(nodes + 1, 0);
+    size_t processors = 0;
+    for (size_t node = 0; node + 1 < nodes; ++node)
+    {
+        processors += topology.numaNodeProcessors[node].size();
+        const double share = static_cast<double>(count) * processors / totalProcessors;
+        const size_t boundary = static_cast<size_t>(share / granule + 0.5) * granule;
+        partitions[node + 1] = std::min(count, std::max(partitions[node], boundary));
+    }
+    partitions[nodes] = count;
+    return partitions;
+}
+
+/******************************************************************************
+*   Pool
+******************************************************************************/
+namespace
+{
+    // ranges of one Dispatch, the caller waits for remaining to reach zero
+    struct Batch
+    {
+        std::mutex                              mutex;
+        std::condition_variable                 done;
+        size_t                                  remaining = 0;
+        std::exception_ptr                      error;
+    };
+    struct Job
+    {
+        Numa::Task                              task;
+        void*                                   context;
+        size_t                                  begin;
+        size_t                                  end;
+        Batch*                                  batch;
+    };
+    thread_local bool                           isPoolWorker = false;
+
+    class NodePool
+    {
+        struct Node
+        {
+            std::mutex                          mutex;
+            std::condition_variable             ready;
+            std::deque<Job>                     jobs;
+            std::vector<std::thread>            threads;
+        };
+        std::vector<std::unique_ptr<Node>>      nodes;
+        std::atomic<bool>                       stopping{ false }; // read by the workers of every node under their own node's mutex
+
+        void Work(Node& node)
+        {
+            isPoolWorker = true;
+            for (;;)
+            {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(node.mutex);
+                    node.ready.wait(lock, [this, &node]() { return stopping.load() || !node.jobs.empty(); });
+                    if (node.jobs.empty())
+                        return;
+                    job = node.jobs.front();
+                    node.jobs.pop_front();
+                }
+                std::exception_ptr error;
+                try
+                {
+                    job.task(job.context, job.begin, job.end);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(job.batch->mutex);
+                if (error && !job.batch->error)
+                    job.batch->error = error;
+                if (--job.batch->remaining == 0)
+                    job.batch->done.notify_one();
+            }
+        }
+
+    public:
+        NodePool()
+        {
+            const auto& topology = SystemInfo::GetTopology();
+            const size_t count = std::max<size_t>(1, topology.numaNodeProcessors.size());
+            const bool pin = count > 1;
+            for (size_t n = 0; n < count; ++n)
+            {
+                nodes.emplace_back(new Node);
+                size_t workers = n < topology.numaNodeProcessors.size() ? topology.numaNodeProcessors[n].size() : 0;
+                if (workers == 0)
+                    workers = std::max<size_t>(1, count == 1 ? std::thread::hardware_concurrency() : 1);
+                Node& node = *nodes.back();
+                for (size_t w = 0; w < workers; ++w)
+                    node.threads.emplace_back([this, &node, n, pin]()
+                    {
+                        if (pin)
+                            Numa::PinCurrentThread(static_cast<unsigned>(n));
+                        Work(node);
+                    });
+            }
+        }
+        ~NodePool()
+        {
+            stopping = true;
+            // taking each node's mutex orders the store before that node's workers test the predicate again
+            for (auto& node : nodes)
+            {
+                std::lock_guard<std::mutex> lock(node->mutex);
+            }
+            for (auto& node : nodes)
+            {
+                node->ready.notify_all();
+                for (auto& thread : node->threads)
+                    thread.join();
+            }
+        }
+        NodePool(const NodePool&) = delete;
+        NodePool& operator= (const NodePool&) = delete;
+
+        static NodePool& Get() { static NodePool pool; return pool; }
+        inline size_t GetNodeCount() const { return nodes.size(); }
+        inline unsigned GetWorkerCount(const unsigned node) const { return node < nodes.size() ? static_cast<unsigned>(nodes[node]->threads.size()) : 0; }
+        // queues the ranges of each node on that node, waits for all of them
+        void Run(const std::vector<std::vector<Job>>& jobsPerNode, Batch& batch)
+        {
+            for (size_t n = 0; n < jobsPerNode.size(); ++n)
+            {
+                if (jobsPerNode[n].empty())
+                    continue;
+                Node& node = *nodes[n % nodes.size()];
+                {
+                    std::lock_guard<std::mutex> lock(node.mutex);
+                    node.jobs.insert(node.jobs.end(), jobsPerNode[n].begin(), jobsPerNode[n].end());
+                }
+                if (jobsPerNode[n].size() == 1)
+                    node.ready.notify_one();
+                else
+                    node.ready.notify_all();
+            }
+            std::unique_lock<std::mutex> lock(batch.mutex);
+            batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+        }
+    };
+}
+
+void King::Numa::Dispatch(const std::vector<size_t>& partitions, Task task, void* context, const size_t minimumPerThread)
+{
+    assert(partitions.size() >= 2);
+    assert(task);
+    const unsigned nodes = static_cast<unsigned>(partitions.size() - 1);
+    const size_t count = partitions.back();
+    if (count == 0)
+        return;
+    // small single node work and work started from a pool worker, whose node may have no idle thread left, run inline
+    if (isPoolWorker || (nodes == 1 && (count <= minimumPerThread || SystemInfo::GetTopology().logicalProcessors == 1)))
+    {
+        task(context, 0, count);
+        return;
+    }
+    auto& pool = NodePool::Get();
+    Batch batch;
+    std::vector<std::vector<Job>> jobsPerNode(nodes);
+    for (unsigned node = 0; node < nodes; ++node)
+    {
+        const size_t begin = partitions[node];
+        const size_t length = partitions[node + 1] - begin;
+        if (length == 0)
+            continue;
+        const size_t workers = std::max<size_t>(1, std::min<size_t>(pool.GetWorkerCount(node % pool.GetNodeCount()), length / std::max<size_t>(1, minimumPerThread)));
+        const size_t chunk = ((length + workers - 1) / workers + 3) & ~size_t(3);
+        for (size_t b = begin; b < begin + length; b += chunk)
+            jobsPerNode[node].push_back({ task, context, b, std::min(b + chunk, begin + length), &batch });
+        batch.remaining += jobsPerNode[node].size();
+    }
+    pool.Run(jobsPerNode, batch);
+    if (batch.error)
+        std::rethrow_exception(batch.error);
+}
+
+unsigned King::Numa::GetWorkerCount(const unsigned node)
+{
+    return NodePool::Get().GetWorkerCount(node);
+}
+
+/******************************************************************************
+*   Kernels
+******************************************************************************/
+namespace
+{
+    // elements [i, i + 4) of each plane as rows, lanes at or past end are zero
+    inline DirectX::XMMATRIX LoadPlanes(const float* const* planes, const size_t planeCount, const size_t i, const size_t end)
+    {
+        using namespace DirectX;
+        XMMATRIX m(XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero());
+        for (size_t k = 0; k < planeCount; ++k)
+        {
+            if (i + 4 <= end)
+                m.r[k] = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(planes[k] + i));
+            else
+            {
+                XMFLOAT4A lanes(0.0f, 0.0f, 0.0f, 0.0f);
+                for (size_t j = 0; i + j < end; ++j)
+                    (&lanes.x)[j] = planes[k][i + j];
+                m.r[k] = XMLoadFloat4A(&lanes);
+            }
+        }
+        return m;
+    }
+    inline void __vectorcall StorePlanes(float* const* planes, const size_t planeCount, const size_t i, const size_t end, DirectX::FXMMATRIX m)
+    {
+        using namespace DirectX;
+        for (size_t k = 0; k < planeCount; ++k)
+        {
+            if (i + 4 <= end)
+                XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(planes[k] + i), m.r[k]);
+            else
+            {
+                XMFLOAT4A lanes;
+                XMStoreFloat4A(&lanes, m.r[k]);
+                for (size_t j = 0; i + j < end; ++j)
+                    planes[k][i + j] = (&lanes.x)[j];
+            }
+        }
+    }
+    template<size_t Planes>
+    inline void GetPlanes(const NumaPlanes<Planes>& in, const float* (&out)[Planes]) { for (size_t k = 0; k < Planes; ++k) out[k] = in.GetPlane(k); }
+    template<size_t Planes>
+    inline void GetPlanes(NumaPlanes<Planes>& in, float* (&out)[Planes]) { for (size_t k = 0; k < Planes; ++k) out[k] = in.GetPlane(k); }
+}
+
+void King::Numa::Transform(const NumaFloat3Planes& pointsIn, const DirectX::XMMATRIX& m, NumaFloat3Planes& pointsOut)
+{
+    assert(pointsIn.GetPartitions() == pointsOut.GetPartitions());
+    KING_MATH_COUNT("Numa::Transform", pointsIn.GetCount());
+    const float* in[3];
+    float* out[3];
+    GetPlanes(pointsIn, in);
+    GetPlanes(pointsOut, out);
+    DirectX::XMFLOAT4X4 matrix;
+    DirectX::XMStoreFloat4x4(&matrix, m);
+    pointsIn.ParallelFor([&in, &out, &matrix](size_t begin, size_t end)
+    {
+        using namespace DirectX;
+        XMVECTOR r[4][4]; // r[row][column] splatted
+        for (size_t row = 0; row < 4; ++row)
+            for (size_t column = 0; column < 4; ++column)
+                r[row][column] = XMVectorReplicate(matrix.m[row][column]);
+        for (size_t i = begin; i < end; i += 4)
+        {
+            const XMMATRIX p = LoadPlanes(in, 3, i, end);
+            // same order of operations as XMVector3TransformCoord, ((z * r2 + r3) + y * r1) + x * r0 then divide by w
+            XMVECTOR t[4];
+            for (size_t column = 0; column < 4; ++column)
+                t[column] = XMVectorMultiplyAdd(p.r[0], r[0][column], XMVectorMultiplyAdd(p.r[1], r[1][column], XMVectorMultiplyAdd(p.r[2], r[2][column], r[3][column])));
+            StorePlanes(out, 3, i, end, XMMATRIX(XMVectorDivide(t[0], t[3]), XMVectorDivide(t[1], t[3]), XMVectorDivide(t[2], t[3]), XMVectorZero()));
+        }
+    });
+}
+
+void King::Numa::Rotate(const NumaFloat3Planes& vectorsIn, const Quaternion& q, NumaFloat3Planes& vectorsOut)
+{
+    assert(vectorsIn.GetPartitions() == vectorsOut.GetPartitions());
+    KING_MATH_COUNT("Numa::Rotate", vectorsIn.GetCount());
+    const float* in[3];
+    float* out[3];
+    GetPlanes(vectorsIn, in);
+    GetPlanes(vectorsOut, out);
+    DirectX::XMFLOAT4A rotation;
+    DirectX::XMStoreFloat4A(&rotation, q.GetVecConst());
+    vectorsIn.ParallelFor([&in, &out, rotation](size_t begin, size_t end)
+    {
+        using namespace DirectX;
+        const XMVECTOR qx = XMVectorReplicate(rotation.x), qy = XMVectorReplicate(rotation.y), qz = XMVectorReplicate(rotation.z), qw = XMVectorReplicate(rotation.w);
+        const XMVECTOR two = XMVectorReplicate(2.0f);
+        for (size_t i = begin; i < end; i += 4)
+        {
+            const XMMATRIX v = LoadPlanes(in, 3, i, end);
+            // v + w t + u x t with t = 2 (u x v), u the vector part of q; the rotation XMVector3Rotate applies
+            const XMVECTOR tx = XMVectorMultiply(two, XMVectorNegativeMultiplySubtract(qz, v.r[1], XMVectorMultiply(qy, v.r[2])));
+            const XMVECTOR ty = XMVectorMultiply(two, XMVectorNegativeMultiplySubtract(qx, v.r[2], XMVectorMultiply(qz, v.r[0])));
+            const XMVECTOR tz = XMVectorMultiply(two, XMVectorNegativeMultiplySubtract(qy, v.r[0], XMVectorMultiply(qx, v.r[1])));
+            XMMATRIX r;
+            r.r[0] = XMVectorAdd(XMVectorMultiplyAdd(qw, tx, v.r[0]), XMVectorNegativeMultiplySubtract(qz, ty, XMVectorMultiply(qy, tz)));
+            r.r[1] = XMVectorAdd(XMVectorMultiplyAdd(qw, ty, v.r[1]), XMVectorNegativeMultiplySubtract(qx, tz, XMVectorMultiply(qz, tx)));
+            r.r[2] = XMVectorAdd(XMVectorMultiplyAdd(qw, tz, v.r[2]), XMVectorNegativeMultiplySubtract(qy, tx, XMVectorMultiply(qx, ty)));
+            r.r[3] = XMVectorZero();
+            StorePlanes(out, 3, i, end, r);
+        }
+    });
+}
+
+void King::Numa::Multiply(const NumaQuaternionPlanes& quaternionsIn, const Quaternion& q, NumaQuaternionPlanes& quaternionsOut)
+{
+    assert(quaternionsIn.GetPartitions() == quaternionsOut.GetPartitions());
+    KING_MATH_COUNT("Numa::Multiply", quaternionsIn.GetCount());
+    const float* in[4];
+    float* out[4];
+    GetPlanes(quaternionsIn, in);
+    GetPlanes(quaternionsOut, out);
+    DirectX::XMFLOAT4A rotation;
+    DirectX::XMStoreFloat4A(&rotation, q.GetVecConst());
+    quaternionsIn.ParallelFor([&in, &out, rotation](size_t begin, size_t end)
+    {
+        using namespace DirectX;
+        const XMVECTOR ax = XMVectorReplicate(rotation.x), ay = XMVectorReplicate(rotation.y), az = XMVectorReplicate(rotation.z), aw = XMVectorReplicate(rotation.w);
+        for (size_t i = begin; i < end; i += 4)
+        {
+            const XMMATRIX b = LoadPlanes(in, 4, i, end);
+            const XMVECTOR &bx = b.r[0], &by = b.r[1], &bz = b.r[2], &bw = b.r[3];
+            // XMQuaternionMultiply(in, q), in followed by q
+            XMMATRIX r;
+            r.r[0] = XMVectorMultiplyAdd(aw, bx, XMVectorMultiplyAdd(ax, bw, XMVectorNegativeMultiplySubtract(az, by, XMVectorMultiply(ay, bz))));
+            r.r[1] = XMVectorMultiplyAdd(aw, by, XMVectorMultiplyAdd(ay, bw, XMVectorNegativeMultiplySubtract(ax, bz, XMVectorMultiply(az, bx))));
+            r.r[2] = XMVectorMultiplyAdd(aw, bz, XMVectorMultiplyAdd(az, bw, XMVectorNegativeMultiplySubtract(ay, bx, XMVectorMultiply(ax, by))));
+            r.r[3] = XMVectorNegativeMultiplySubtract(az, bz, XMVectorNegativeMultiplySubtract(ay, by, XMVectorNegativeMultiplySubtract(ax, bx, XMVectorMultiply(aw, bw))));
+            StorePlanes(out, 4, i, end, r);
+        }
+    });
+}
@@ -0,0 +1,254 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDNuma
+
+Description:    NUMA placement for large King arrays.  NumaArray splits its
+                elements into one contiguous partition per node, sized by the
+                node's processor count and cut on page boundaries, and places
+                each partition on its node either by binding the pages (mbind,
+                VirtualAllocExNuma) or by first touch from threads pinned to the
+                node.  ParallelFor runs a kernel with every thread pinned to the
+                node that holds the elements it works on, so arrays allocated
+                with the same count keep input and output local.  The threads
+                are a persistent pool started on first use.  NumaPlanes keeps
+                float3 and quat arrays as x, y, z, w planes for the bulk
+                kernels, which transform 4 elements per XMVECTOR.
+
+                    King::NumaFloat3Planes points(source.data(), n), moved(n);
+                    King::Numa::Transform(points, world, moved);
+                    King::NumaArray<King::float3> normals(n);
+                    normals.ParallelFor([&](size_t begin, size_t end)
+                        { quat::ShortestArc(&normals[begin], &up[begin], &arcs[begin], end - begin); });
+
+                On a single node machine the array is one partition and the
+                kernels run on every core without pinning.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace King {
+
+    namespace Numa
+    {
+        enum class Placement { FirstTouch, Bind };
+
+        size_t                                  GetPageSize();
+        // page aligned address space, pages are not touched
+        void*                                   Reserve(const size_t bytes);
+        // makes the range usable, false when it could not be; node >= 0 (a topology index, mapped to the OS node id) binds
+        // the pages to the node and where the OS refuses the binding the pages follow first touch
+        bool                                    Commit(void* address, const size_t bytes, const int node = -1);
+        void                                    Release(void* address, const size_t bytes);
+        // restricts the calling thread to the processors of the node, false when the OS refused
+        bool                                    PinCurrentThread(const unsigned node);
+        // element index where each node's partition begins, plus count at the end; weighted by processors per node
+        std::vector<size_t>                     Partition(const size_t count, const size_t elementSize);
+
+        // the persistent pool behind ParallelFor, one worker per processor of each node pinned to it, started on first
+        // use; task(context, begin, end) runs on the workers of the node owning [begin, end) and Dispatch returns
+        // when every range is done, rethrowing the first exception.  Calls from a pool worker run inline.
+        typedef void                            (*Task)(void* context, size_t begin, size_t end);
+        void                                    Dispatch(const std::vector<size_t>& partitions, Task task, void* context, const size_t minimumPerThread);
+        unsigned                                GetWorkerCount(const unsigned node);
+
+        // function(begin, end) on pool threads pinned to the node owning [begin, end); ranges are multiples of 4
+        // elements except the last so batch kernels run full lanes
+        template<class Function>
+        inline void                             ParallelFor(const std::vector<size_t>& partitions, Function&& function, const size_t minimumPerThread = 4096)
+        {
+            using F = std::remove_reference_t<Function>;
+            Dispatch(partitions, [](void* context, size_t begin, size_t end) { (*static_cast<F*>(context))(begin, end); },
+                const_cast<void*>(static_cast<const void*>(std::addressof(function))), minimumPerThread);
+        }
+    }
+
+    /******************************************************************************
+    *   NumaArray
+    *       Fixed size array with one partition per NUMA node, elements are
+    *       constructed in parallel by threads on the owning node
+    ******************************************************************************/
+    template<class T>
+    class NumaArray
+    {
+        /* variables */
+    private:
+        T*                                      elements = nullptr;
+        size_t                                  count = 0;
+        size_t                                  bytes = 0;
+        Numa::Placement                         placement = Numa::Placement::FirstTouch;
+        std::vector<size_t>                     partitions{ 0, 0 };
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        NumaArray() = default;
+        explicit NumaArray(const size_t countIn, const Numa::Placement placementIn = Numa::Placement::FirstTouch, const T& value = T()) { Allocate(countIn, placementIn, value); }
+        NumaArray(const NumaArray&) = delete;
+        NumaArray(NumaArray&& in) noexcept { *this = std::move(in); }
+        ~NumaArray() { Clear(); }
+        // Operators
+        NumaArray& operator= (const NumaArray&) = delete;
+        NumaArray& operator= (NumaArray&& in) noexcept
+        {
+            if (this != &in)
+            {
+                Clear();
+                std::swap(elements, in.elements); std::swap(count, in.count); std::swap(bytes, in.bytes);
+                std::swap(placement, in.placement); std::swap(partitions, in.partitions);
+            }
+            return *this;
+        }
+        inline T&                               operator[] (const size_t i) { assert(i < count); return elements[i]; }
+        inline const T&                         operator[] (const size_t i) const { assert(i < count); return elements[i]; }
+        // Functionality
+        void                                    Allocate(const size_t countIn, const Numa::Placement placementIn = Numa::Placement::FirstTouch, const T& value = T())
+        {
+            Clear();
+            if (countIn == 0)
+                return;
+            const size_t page = Numa::GetPageSize();
+            bytes = (countIn * sizeof(T) + page - 1) / page * page;
+            void* address = Numa::Reserve(bytes);
+            if (!address)
+                throw std::bad_alloc();
+            partitions = Numa::Partition(countIn, sizeof(T));
+            placement = placementIn;
+            const unsigned nodes = static_cast<unsigned>(partitions.size() - 1);
+            for (unsigned node = 0; node < nodes; ++node)
+            {
+                // partitions end on page boundaries so each range commits whole pages
+                const size_t begin = partitions[node] * sizeof(T);
+                const size_t end = node + 1 == nodes ? bytes : partitions[node + 1] * sizeof(T);
+                if (end > begin && !Numa::Commit(static_cast<char*>(address) + begin, end - begin, placement == Numa::Placement::Bind && nodes > 1 ? static_cast<int>(node) : -1))
+                {
+                    Numa::Release(address, bytes);
+                    throw std::bad_alloc();
+                }
+            }
+            elements = static_cast<T*>(address);
+            count = countIn;
+            // first touch, the pinned thread that constructs an element faults its page in on its node
+            ParallelFor([this, &value](size_t begin, size_t end) { for (size_t i = begin; i < end; ++i) new (&elements[i]) T(value); });
+        }
+        void                                    Clear()
+        {
+            if (!elements)
+                return;
+            if (!std::is_trivially_destructible<T>::value)
+                ParallelFor([this](size_t begin, size_t end) { for (size_t i = begin; i < end; ++i) elements[i].~T(); });
+            Numa::Release(elements, bytes);
+            elements = nullptr;
+            count = bytes = 0;
+            partitions.assign({ 0, 0 });
+        }
+        // function(begin, end) with each thread on the node holding its elements
+        template<class Function>
+        inline void                             ParallelFor(Function&& function, const size_t minimumPerThread = 4096) const { Numa::ParallelFor(partitions, std::forward<Function>(function), minimumPerThread); }
+        // Accessors
+        inline T*                               GetData() { return elements; }
+        inline const T*                         GetData() const { return elements; }
+        inline size_t                           GetCount() const { return count; }
+        inline Numa::Placement                  GetPlacement() const { return placement; }
+        inline unsigned                         GetNodeCount() const { return static_cast<unsigned>(partitions.size() - 1); }
+        inline size_t                           GetPartitionBegin(const unsigned node) const { assert(node < GetNodeCount()); return partitions[node]; }
+        inline size_t                           GetPartitionEnd(const unsigned node) const { assert(node < GetNodeCount()); return partitions[node + 1]; }
+        inline const std::vector<size_t>&       GetPartitions() const { return partitions; }
+        inline T*                               begin() { return elements; }
+        inline T*                               end() { return elements + count; }
+        inline const T*                         begin() const { return elements; }
+        inline const T*                         end() const { return elements + count; }
+    };
+
+    /******************************************************************************
+    *   NumaPlanes
+    *       Structure of arrays with one NumaArray<float> per component, x, y,
+    *       z then w; the planes share one partitioning so every component of
+    *       an element lives on the same node, and the kernels load 4 elements
+    *       per XMVECTOR
+    ******************************************************************************/
+    template<size_t Planes>
+    class NumaPlanes
+    {
+        static_assert(Planes >= 1 && Planes <= 4, "one plane per component, x to w");
+        /* variables */
+    private:
+        NumaArray<float>                        planes[Planes];
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        NumaPlanes() = default;
+        explicit NumaPlanes(const size_t countIn, const Numa::Placement placementIn = Numa::Placement::FirstTouch) { Allocate(countIn, placementIn); }
+        template<class T>
+        NumaPlanes(const T* in, const size_t countIn, const Numa::Placement placementIn = Numa::Placement::FirstTouch) { Allocate(countIn, placementIn); Load(in); }
+        // Functionality
+        void                                    Allocate(const size_t countIn, const Numa::Placement placementIn = Numa::Placement::FirstTouch) { for (auto& plane : planes) plane.Allocate(countIn, placementIn, 0.0f); }
+        void                                    Clear() { for (auto& plane : planes) plane.Clear(); }
+        // scatter GetCount() elements of an array of float3, float4 or quat, each node writes its own partition
+        template<class T>
+        void                                    Load(const T* in)
+        {
+            ParallelFor([this, in](size_t begin, size_t end)
+            {
+                DirectX::XMFLOAT4A f;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    DirectX::XMStoreFloat4A(&f, in[i].GetVecConst());
+                    for (size_t k = 0; k < Planes; ++k)
+                        planes[k].GetData()[i] = (&f.x)[k];
+                }
+            });
+        }
+        // gather into an array of GetCount() float3, float4 or quat
+        template<class T>
+        void                                    Store(T* out) const { ParallelFor([this, out](size_t begin, size_t end) { for (size_t i = begin; i < end; ++i) out[i] = T(Get(i)); }); }
+        template<class Function>
+        inline void                             ParallelFor(Function&& function, const size_t minimumPerThread = 4096) const { planes[0].ParallelFor(std::forward<Function>(function), minimumPerThread); }
+        // Accessors
+        inline DirectX::XMVECTOR                Get(const size_t i) const { DirectX::XMFLOAT4A f(0.0f, 0.0f, 0.0f, 0.0f); for (size_t k = 0; k < Planes; ++k) (&f.x)[k] = planes[k][i]; return DirectX::XMLoadFloat4A(&f); } // components past the planes are zero
+        inline float*                           GetPlane(const size_t k) { assert(k < Planes); return planes[k].GetData(); }
+        inline const float*                     GetPlane(const size_t k) const { assert(k < Planes); return planes[k].GetData(); }
+        inline size_t                           GetCount() const { return planes[0].GetCount(); }
+        inline unsigned                         GetNodeCount() const { return planes[0].GetNodeCount(); }
+        inline const std::vector<size_t>&       GetPartitions() const { return planes[0].GetPartitions(); }
+        // Assignments
+        inline void __vectorcall                Set(const size_t i, DirectX::FXMVECTOR v) { DirectX::XMFLOAT4A f; DirectX::XMStoreFloat4A(&f, v); for (size_t k = 0; k < Planes; ++k) planes[k][i] = (&f.x)[k]; }
+    };
+    typedef NumaPlanes<3>                       NumaFloat3Planes;
+    typedef NumaPlanes<4>                       NumaQuaternionPlanes;
+
+    namespace Numa
+    {
+        // bulk kernels, 4 elements per XMVECTOR; in and out need the same count so their partitions match; in and out may alias
+        void                                    Transform(const NumaFloat3Planes& pointsIn, const DirectX::XMMATRIX& m, NumaFloat3Planes& pointsOut); // with translation, as XMVector3TransformCoord
+        void                                    Rotate(const NumaFloat3Planes& vectorsIn, const Quaternion& q, NumaFloat3Planes& vectorsOut);
+        void                                    Multiply(const NumaQuaternionPlanes& quaternionsIn, const Quaternion& q, NumaQuaternionPlanes& quaternionsOut); // each in * q
+    }
+}
@@ -0,0 +1,299 @@
+﻿#include "MathSIMDOcclusion.h"
+#include "MathSIMDInstrument.h"
+#include <algorithm>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    // lane n selected when bit n of the span mask is set
+    const DirectX::XMVECTORU32 LaneMask[16] =
+    {
+        { { 0u, 0u, 0u, 0u } }, { { ~0u, 0u, 0u, 0u } }, { { 0u, ~0u, 0u, 0u } }, { { ~0u, ~0u, 0u, 0u } },
+        { { 0u, 0u, ~0u, 0u } }, { { ~0u, 0u, ~0u, 0u } }, { { 0u, ~0u, ~0u, 0u } }, { { ~0u, ~0u, ~0u, 0u } },
+        { { 0u, 0u, 0u, ~0u } }, { { ~0u, 0u, 0u, ~0u } }, { { 0u, ~0u, 0u, ~0u } }, { { ~0u, ~0u, 0u, ~0u } },
+        { { 0u, 0u, ~0u, ~0u } }, { { ~0u, 0u, ~0u, ~0u } }, { { 0u, ~0u, ~0u, ~0u } }, { { ~0u, ~0u, ~0u, ~0u } },
+    };
+
+    inline int32_t PaddedStride(const int32_t width) { return ((width + 3) & ~3) + 8; } // room for the 2 x 2 reduction to read 8 past the row
+
+    // clip space (x, y, z, w) to pixels in x and y and depth z / w in z
+    inline DirectX::XMVECTOR __vectorcall Project(DirectX::FXMVECTOR clip, DirectX::FXMVECTOR scale, DirectX::FXMVECTOR offset)
+    {
+        using namespace DirectX;
+        return XMVectorMultiplyAdd(XMVectorDivide(clip, XMVectorSplatW(clip)), scale, offset);
+    }
+
+    // Sutherland-Hodgman against the near plane z >= 0, returns 0, 3 or 4 vertices
+    int ClipNear(const DirectX::XMVECTOR in[3], DirectX::XMVECTOR out[4])
+    {
+        using namespace DirectX;
+        int n = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const XMVECTOR a = in[k];
+            const XMVECTOR b = in[(k + 1) % 3];
+            const float za = XMVectorGetZ(a);
+            const float zb = XMVectorGetZ(b);
+            if (za >= 0.0f)
+                out[n++] = a;
+            if ((za >= 0.0f) != (zb >= 0.0f))
+                out[n++] = XMVectorLerp(a, b, za / (za - zb));
+        }
+        return n;
+    }
+
+    inline DirectX::XMVECTOR __vectorcall HorizontalMin(DirectX::FXMVECTOR v)
+    {
+        using namespace DirectX;
+        const XMVECTOR m = XMVectorMin(v, XMVectorSwizzle<2, 3, 0, 1>(v));
+        return XMVectorMin(m, XMVectorSwizzle<1, 0, 3, 2>(m));
+    }
+
+    inline DirectX::XMVECTOR __vectorcall HorizontalMax(DirectX::FXMVECTOR v)
+    {
+        using namespace DirectX;
+        const XMVECTOR m = XMVectorMax(v, XMVectorSwizzle<2, 3, 0, 1>(v));
+        return XMVectorMax(m, XMVectorSwizzle<1, 0, 3, 2>(m));
+    }
+}
+
+/******************************************************************************
+*   OcclusionBuffer
+******************************************************************************/
+King::OcclusionBuffer::OcclusionBuffer(const int32_t width, const int32_t height, const size_t threads) :
+    viewProjection(DirectX::XMMatrixIdentity()),
+    rasterizer(std::max(1, width), std::max(1, height), 32, threads)
+{
+    int32_t w = rasterizer.GetWidth();
+    int32_t h = rasterizer.GetHeight();
+    for (;;)
+    {
+        levelSizes.emplace_back(w, h);
+        strides.push_back(PaddedStride(w));
+        levels.emplace_back(size_t(strides.back()) * h, 0.0f);
+        if (w == 1 && h == 1)
+            break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    Clear();
+}
+
+void King::OcclusionBuffer::Clear()
+{
+    const int32_t width = GetWidth();
+    for (int32_t y = 0; y < GetHeight(); ++y)
+        std::fill_n(levels[0].begin() + size_t(y) * strides[0], width, 1.0f);
+    hierarchyDirty = true;
+}
+
+void King::OcclusionBuffer::AddOccluders(const FloatPoint3* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount, const DirectX::XMMATRIX& world)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("OcclusionBuffer::AddOccluders", triangleCount);
+    assert(vertices || vertexCount == 0);
+    if (triangleCount == 0)
+        return;
+
+    // clip space, 4 vertices per step with the transposed matrix columns splatted
+    const XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(world, viewProjection));
+    const XMVECTOR scale = XMVectorSet(0.5f * GetWidth(), -0.5f * GetHeight(), 1.0f, 1.0f);
+    const XMVECTOR offset = XMVectorSet(0.5f * GetWidth(), 0.5f * GetHeight(), 0.0f, 0.0f);
+    std::vector<FloatPoint4> clip(vertexCount);
+    for (size_t i = 0; i < vertexCount; i += 4)
+    {
+        XMMATRIX soa;
+        for (size_t j = 0; j < 4; ++j)
+            soa.r[j] = (i + j < vertexCount) ? vertices[i + j].GetVecConst() : g_XMIdentityR3.v;
+        soa = XMMatrixTranspose(soa);
+        XMMATRIX out;
+        for (int c = 0; c < 4; ++c)
+        {
+            XMVECTOR value = XMVectorMultiplyAdd(soa.r[0], XMVectorSplatX(columns.r[c]), XMVectorSplatW(columns.r[c]));
+            value = XMVectorMultiplyAdd(soa.r[1], XMVectorSplatY(columns.r[c]), value);
+            out.r[c] = XMVectorMultiplyAdd(soa.r[2], XMVectorSplatZ(columns.r[c]), value);
+        }
+        out = XMMatrixTranspose(out);
+        for (size_t j = 0; j < 4 && i + j < vertexCount; ++j)
+            clip[i + j] = out.r[j];
+    }
+
+    // vertices in front of the near plane project as they are, triangles crossing it are clipped into new vertices
+    std::vector<FloatPoint2> positions(vertexCount);
+    std::vector<FloatPoint4> depths(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        if (clip[i].GetW() > 0.0f)
+        {
+            const XMVECTOR p = Project(clip[i].GetVecConst(), scale, offset);
+            positions[i] = p;
+            depths[i] = XMVectorSplatZ(p);
+        }
+    }
+    std::vector<uint32_t> triangles;
+    triangles.reserve(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        uint32_t index[3];
+        XMVECTOR corner[3];
+        int inFront = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            index[k] = indices ? indices[3 * t + k] : static_cast<uint32_t>(3 * t + k);
+            assert(index[k] < vertexCount);
+            corner[k] = clip[index[k]].GetVecConst();
+            inFront += XMVectorGetZ(corner[k]) >= 0.0f && XMVectorGetW(corner[k]) > 0.0f;
+        }
+        if (inFront == 3)
+        {
+            triangles.insert(triangles.end(), index, index + 3);
+            continue;
+        }
+        XMVECTOR polygon[4];
+        const int n = ClipNear(corner, polygon);
+        if (n < 3)
+            continue;
+        const uint32_t first = static_cast<uint32_t>(positions.size());
+        for (int k = 0; k < n; ++k)
+        {
+            if (!(XMVectorGetW(polygon[k]) > 0.0f))
+                break;
+            const XMVECTOR p = Project(polygon[k], scale, offset);
+            positions.emplace_back(p);
+            depths.emplace_back(XMVectorSplatZ(p));
+        }
+        if (positions.size() - first != size_t(n))
+        {
+            positions.resize(first);
+            depths.resize(first);
+            continue;
+        }
+        for (int k = 2; k < n; ++k)
+            triangles.insert(triangles.end(), { first, first + k - 1, first + k });
+    }
+
+    // nearest depth per pixel, spans never cross a tile so the writes do not race
+    float* depth = levels[0].data();
+    const int32_t stride = strides[0];
+    rasterizer.Rasterize(positions.data(), depths.data(), triangles.data(), triangles.size() / 3, [depth, stride](const RasterSpan4& span)
+    {
+        float* row = depth + size_t(span.y) * stride + span.x;
+        const XMVECTOR old = _mm_loadu_ps(row);
+        _mm_storeu_ps(row, XMVectorSelect(old, XMVectorMin(old, span.attributes.r[0]), LaneMask[span.mask]));
+    });
+    hierarchyDirty = true;
+}
+
+void King::OcclusionBuffer::BuildHierarchy()
+{
+    using namespace DirectX;
+    for (size_t level = 1; level < levels.size(); ++level)
+    {
+        const float* source = levels[level - 1].data();
+        const int32_t sourceStride = strides[level - 1];
+        const int32_t sourceHeight = levelSizes[level - 1].GetY();
+        float* target = levels[level].data();
+        const IntPoint2 size = levelSizes[level];
+        for (int32_t y = 0; y < size.GetY(); ++y)
+        {
+            const float* row0 = source + size_t(2 * y) * sourceStride;
+            const float* row1 = source + size_t(std::min(2 * y + 1, sourceHeight - 1)) * sourceStride;
+            float* out = target + size_t(y) * strides[level];
+            // the zero padding past each row never raises a max, depths are not negative
+            for (int32_t x = 0; x < size.GetX(); x += 4)
+            {
+                const XMVECTOR left = XMVectorMax(_mm_loadu_ps(row0 + 2 * x), _mm_loadu_ps(row1 + 2 * x));
+                const XMVECTOR right = XMVectorMax(_mm_loadu_ps(row0 + 2 * x + 4), _mm_loadu_ps(row1 + 2 * x + 4));
+                const XMVECTOR even = _mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0));
+                const XMVECTOR odd = _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm_storeu_ps(out + x, XMVectorMax(even, odd));
+            }
+        }
+    }
+    hierarchyDirty = false;
+}
+
+bool __vectorcall King::OcclusionBuffer::IsVisible(const FloatPoint3 boxMin, const FloatPoint3 boxMax) const
+{
+    using namespace DirectX;
+    assert(!hierarchyDirty);
+
+    // the 8 corners as two groups of 4, x and y alternate across lanes and z is shared by the group
+    const XMMATRIX columns = XMMatrixTranspose(viewProjection);
+    const XMVECTOR lo = boxMin;
+    const XMVECTOR hi = boxMax;
+    const XMVECTOR x = XMVectorSelect(XMVectorSplatX(lo), XMVectorSplatX(hi), XMVectorSelectControl(0, 1, 0, 1));
+    const XMVECTOR y = XMVectorSelect(XMVectorSplatY(lo), XMVectorSplatY(hi), g_XMSelect0011);
+    XMVECTOR clip[2][4];
+    for (int c = 0; c < 4; ++c)
+    {
+        XMVECTOR value = XMVectorMultiplyAdd(x, XMVectorSplatX(columns.r[c]), XMVectorSplatW(columns.r[c]));
+        value = XMVectorMultiplyAdd(y, XMVectorSplatY(columns.r[c]), value);
+        clip[0][c] = XMVectorMultiplyAdd(XMVectorSplatZ(lo), XMVectorSplatZ(columns.r[c]), value);
+        clip[1][c] = XMVectorMultiplyAdd(XMVectorSplatZ(hi), XMVectorSplatZ(columns.r[c]), value);
+    }
+    const XMVECTOR zero = XMVectorZero();
+    const XMVECTOR crossesNear = XMVectorOrInt(
+        XMVectorOrInt(XMVectorLessOrEqual(clip[0][3], zero), XMVectorLess(clip[0][2], zero)),
+        XMVectorOrInt(XMVectorLessOrEqual(clip[1][3], zero), XMVectorLess(clip[1][2], zero)));
+    if (_mm_movemask_ps(crossesNear))
+        return true;
+
+    XMVECTOR minimum[3], maximum[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        const XMVECTOR a = XMVectorDivide(clip[0][c], clip[0][3]);
+        const XMVECTOR b = XMVectorDivide(clip[1][c], clip[1][3]);
+        minimum[c] = HorizontalMin(XMVectorMin(a, b));
+        maximum[c] = HorizontalMax(XMVectorMax(a, b));
+    }
+    const float width = static_cast<float>(GetWidth());
+    const float height = static_cast<float>(GetHeight());
+    const float left = (XMVectorGetX(minimum[0]) * 0.5f + 0.5f) * width;
+    const float right = (XMVectorGetX(maximum[0]) * 0.5f + 0.5f) * width;
+    const float top = (0.5f - XMVectorGetX(maximum[1]) * 0.5f) * height;
+    const float bottom = (0.5f - XMVectorGetX(minimum[1]) * 0.5f) * height;
+
+    // every pixel the box touches, clamped to the viewport
+    const int32_t x0 = static_cast<int32_t>(std::max(0.0f, std::floor(left)));
+    const int32_t y0 = static_cast<int32_t>(std::max(0.0f, std::floor(top)));
+    const int32_t x1 = static_cast<int32_t>(std::min(width, std::max(std::floor(left) + 1.0f, std::ceil(right))));
+    const int32_t y1 = static_cast<int32_t>(std::min(height, std::max(std::floor(top) + 1.0f, std::ceil(bottom))));
+    if (x0 >= x1 || y0 >= y1)
+        return true;
+
+    size_t level = 0;
+    while (level + 1 < levels.size() && (((x1 - 1) >> level) - (x0 >> level) >= 8 || ((y1 - 1) >> level) - (y0 >> level) >= 8))
+        ++level;
+    const int32_t cx0 = x0 >> level;
+    const int32_t cx1 = ((x1 - 1) >> level) + 1;
+    const int32_t cy0 = y0 >> level;
+    const int32_t cy1 = ((y1 - 1) >> level) + 1;
+    const XMVECTOR nearest = minimum[2];
+    const float* cells = levels[level].data();
+    for (int32_t cy = cy0; cy < cy1; ++cy)
+    {
+        const float* row = cells + size_t(cy) * strides[level];
+        for (int32_t cx = cx0; cx < cx1; cx += 4)
+        {
+            int behind = _mm_movemask_ps(XMVectorGreaterOrEqual(_mm_loadu_ps(row + cx), nearest));
+            if (cx1 - cx < 4)
+                behind &= (1 << (cx1 - cx)) - 1;
+            if (behind)
+                return true;
+        }
+    }
+    return false;
+}
+
+void King::OcclusionBuffer::IsVisible(const FloatPoint3* boxMinsIn, const FloatPoint3* boxMaxsIn, size_t count, uint8_t* visibleOut) const
+{
+    KING_MATH_COUNT("OcclusionBuffer::IsVisible(batch)", count);
+    for (size_t i = 0; i < count; ++i)
+        visibleOut[i] = IsVisible(boxMinsIn[i], boxMaxsIn[i]) ? 1 : 0;
+}
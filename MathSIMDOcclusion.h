@@ -0,0 +1,97 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDOcclusion
+
+Description:    Software occlusion culling for servers without GPUs.  Occluder
+                meshes are transformed to clip space four vertices at a time,
+                clipped at the near plane and drawn by the tiled Rasterizer into
+                a low resolution depth buffer keeping the nearest depth.  A max
+                depth hierarchy is then built over it and occludee boxes are
+                tested against the coarsest level that keeps the test within
+                8 x 8 cells, four cells per compare.
+
+                    King::OcclusionBuffer occlusion(256, 128);
+                    occlusion.SetViewProjection(view * projection);
+                    occlusion.Clear();
+                    for (auto& occluder : occluders)
+                        occlusion.AddOccluders(occluder.vertices, occluder.vertexCount, occluder.indices, occluder.triangleCount, occluder.world);
+                    occlusion.BuildHierarchy();
+                    occlusion.IsVisible(boxMins, boxMaxs, count, visible); // after frustum culling
+
+                Depth is the DirectX convention, z / w from 0 at the near plane
+                to 1 at the far plane, row major matrices multiplying row vectors.
+                A box crossing the near plane or lying outside the viewport is
+                reported visible; frustum culling is left to the caller.
+                Occluders cover a pixel only when its center is inside, so they
+                shrink slightly and never hide what is visible at pixel centers.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include "MathSIMDRasterizer.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   OcclusionBuffer
+    ******************************************************************************/
+    class alignas(16) OcclusionBuffer
+    {
+        /* variables */
+    private:
+        DirectX::XMMATRIX                       viewProjection;
+        Rasterizer                              rasterizer;
+        std::vector<std::vector<float>>         levels;         // level 0 is the depth buffer, each next level the max of 2 x 2 cells
+        std::vector<IntPoint2>                  levelSizes;
+        std::vector<int32_t>                    strides;        // floats per row, padded with zeros past the width
+        bool                                    hierarchyDirty = true;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        OcclusionBuffer(const int32_t width, const int32_t height, const size_t threads = 0); // 0 threads is one per logical processor
+        // Functionality
+        void                                    Clear(); // depth to the far plane
+        // occluder triangles in object space, indices of 3 per triangle or null for sequential vertices
+        void                                    AddOccluders(const FloatPoint3* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount, const DirectX::XMMATRIX& world = DirectX::XMMatrixIdentity());
+        void                                    BuildHierarchy(); // after the last occluders and before the tests
+        bool __vectorcall                       IsVisible(const FloatPoint3 boxMin, const FloatPoint3 boxMax) const; // world space box
+        void                                    IsVisible(const FloatPoint3* boxMinsIn, const FloatPoint3* boxMaxsIn, size_t count, uint8_t* visibleOut) const; // batch, 1 visible and 0 occluded
+        // Accessors
+        inline int32_t                          GetWidth() const { return levelSizes[0].GetX(); }
+        inline int32_t                          GetHeight() const { return levelSizes[0].GetY(); }
+        inline const DirectX::XMMATRIX&         GetViewProjection() const { return viewProjection; }
+        inline size_t                           GetLevelCount() const { return levels.size(); }
+        inline IntPoint2                        GetLevelSize(const size_t level) const { return levelSizes[level]; }
+        inline int32_t                          GetLevelStride(const size_t level) const { return strides[level]; }
+        inline const float*                     GetLevel(const size_t level) const { return levels[level].data(); }
+        inline float                            GetDepth(const int32_t x, const int32_t y) const { return levels[0][size_t(y) * strides[0] + x]; }
+        inline const Rasterizer&                GetRasterizer() const { return rasterizer; }
+        // Assignments
+        inline void                             SetViewProjection(const DirectX::XMMATRIX& m) { viewProjection = m; }
+        inline void                             SetThreadCount(const size_t threads) { rasterizer.SetThreadCount(threads); }
+    };
+}
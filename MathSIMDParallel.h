@@ -0,0 +1,83 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDParallel
+
+Description:    Internal helper shared by the module translation units that
+                split work into independent items (voxel bricks, isosurface
+                blocks, raster tiles).  ParallelItems runs function(item) for
+                every item on up to the given number of threads, the calling
+                thread included, each taking the next unclaimed item so uneven
+                items balance themselves.  The first exception stops the
+                remaining items and is rethrown on the calling thread.
+
+                    King::ParallelItems(tiles.size(), threads, [&](size_t tile) { ... });
+
+                Not part of the public interface, include it from .cpp files
+                only.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace King {
+
+    // function(item) for item in [0, count) on up to threads workers taking the next item, first exception rethrown
+    template<class Function>
+    void ParallelItems(const size_t count, const size_t threads, Function&& function)
+    {
+        std::atomic<size_t> next(0);
+        std::exception_ptr failure;
+        std::mutex failureLock;
+        auto worker = [&]()
+        {
+            try
+            {
+                for (size_t item = next++; item < count; item = next++)
+                    function(item);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureLock);
+                if (!failure)
+                    failure = std::current_exception();
+                next = count;
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t i = 1; i < std::min(threads, count); ++i)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool)
+            thread.join();
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+}
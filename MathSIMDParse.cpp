@@ -0,0 +1,158 @@
+﻿#include "MathSIMDParse.h"
+#include "MathSIMDInstrument.h"
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace King;
+using namespace std;
+
+namespace
+{
+    inline unsigned CountTrailingZeros(const unsigned mask)
+    {
+        assert(mask);
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+    inline unsigned PopCount(unsigned mask)
+    {
+#if defined(_MSC_VER)
+        return __popcnt(mask);
+#else
+        return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+    }
+    // space and \t \n \v \f \r
+    inline bool IsSpace(const char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    // calls emit(values) for every components numbers
+    template<size_t Components, class Emit>
+    ParseResult ParseValues(const char* text, const size_t length, Emit&& emit)
+    {
+        KING_MATH_COUNT("Parse", length);
+        ParseResult result;
+        float values[Components];
+        size_t filled = 0;
+        size_t newlines = 0;
+        size_t position = 0;
+        size_t tokenStart = 0;
+        auto fail = [&](const size_t offset)
+        {
+            result.ok = false;
+            result.errorOffset = offset;
+            result.errorLine = newlines + 1;
+            size_t lineStart = offset;
+            while (lineStart > 0 && text[lineStart - 1] != '\n')
+                --lineStart;
+            result.errorColumn = offset - lineStart + 1;
+        };
+        for (;;)
+        {
+            position = SkipWhitespace(text, position, length, &newlines);
+            if (position >= length)
+                break;
+            if (text[position] == '#')
+            {
+                const void* end = memchr(text + position, '\n', length - position);
+                position = end ? static_cast<size_t>(static_cast<const char*>(end) - text) : length;
+                continue;
+            }
+            // from_chars takes no leading '+', a '-' after one would be accepted as a second sign so "+-1" is rejected
+            tokenStart = position;
+            const bool plus = text[position] == '+';
+            const char* first = text + position + (plus ? 1 : 0);
+            float value;
+            const auto parsed = std::from_chars(first, text + length, value);
+            if ((plus && first < text + length && *first == '-') || parsed.ec != std::errc() || parsed.ptr == first || (parsed.ptr < text + length && !IsSpace(*parsed.ptr) && *parsed.ptr != '#'))
+            {
+                fail(tokenStart);
+                return result;
+            }
+            position = static_cast<size_t>(parsed.ptr - text);
+            ++result.values;
+            values[filled++] = value;
+            if (filled == Components)
+            {
+                emit(values);
+                ++result.elements;
+                filled = 0;
+            }
+        }
+        if (filled)
+            fail(length); // partial vector at the end
+        return result;
+    }
+
+    template<class T>
+    std::istream& ReadVectors(std::istream& is, std::vector<T>& out)
+    {
+        const std::string text((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        if (!Parse(text.data(), text.size(), out))
+            is.setstate(std::ios::failbit);
+        return is;
+    }
+}
+
+size_t King::SkipWhitespace(const char* text, size_t position, const size_t length, size_t* newlinesInOut)
+{
+    assert(text && newlinesInOut);
+    size_t newlines = 0;
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i carriage = _mm_set1_epi8('\r');
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (position + 16 <= length)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+        // \t..\r is the range c == max(c, \t) and c == min(c, \r)
+        const __m128i control = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(c, tab), c), _mm_cmpeq_epi8(_mm_min_epu8(c, carriage), c));
+        const unsigned blank = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(c, space))));
+        const unsigned lines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(c, newline)));
+        if (blank != 0xFFFF)
+        {
+            const unsigned skip = CountTrailingZeros(~blank & 0xFFFF);
+            newlines += PopCount(lines & ((1u << skip) - 1u));
+            *newlinesInOut += newlines;
+            return position + skip;
+        }
+        newlines += PopCount(lines);
+        position += 16;
+    }
+    for (; position < length && IsSpace(text[position]); ++position)
+        newlines += text[position] == '\n';
+    *newlinesInOut += newlines;
+    return position;
+}
+
+ParseResult King::Parse(const char* text, const size_t length, std::vector<float>& out)
+{
+    return ParseValues<1>(text, length, [&out](const float* v) { out.push_back(v[0]); });
+}
+
+ParseResult King::Parse(const char* text, const size_t length, std::vector<float2>& out)
+{
+    return ParseValues<2>(text, length, [&out](const float* v) { out.emplace_back(v[0], v[1]); });
+}
+
+ParseResult King::Parse(const char* text, const size_t length, std::vector<float3>& out)
+{
+    return ParseValues<3>(text, length, [&out](const float* v) { out.emplace_back(v[0], v[1], v[2]); });
+}
+
+ParseResult King::Parse(const char* text, const size_t length, std::vector<float4>& out)
+{
+    return ParseValues<4>(text, length, [&out](const float* v) { out.emplace_back(v[0], v[1], v[2], v[3]); });
+}
+
+std::istream& King::operator>> (std::istream& is, std::vector<float2>& out) { return ReadVectors(is, out); }
+std::istream& King::operator>> (std::istream& is, std::vector<float3>& out) { return ReadVectors(is, out); }
+std::istream& King::operator>> (std::istream& is, std::vector<float4>& out) { return ReadVectors(is, out); }
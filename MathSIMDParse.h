@@ -0,0 +1,71 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDParse
+
+Description:    Bulk parsing of whitespace separated numbers ("x y z" lines as
+                in OBJ like text assets) into float2, float3 and float4 arrays.
+                Runs of spaces, tabs and newlines are skipped 16 bytes at a time
+                with SSE2 and each number is read with std::from_chars, so there
+                is no locale, no stream state and no allocation per value.  A
+                '#' starts a comment to the end of the line.  Parsing stops at
+                the first bad token and reports its byte offset, line and column.
+
+                    std::vector<King::float3> points;
+                    auto result = King::Parse(text.data(), text.size(), points);
+                    if (!result)
+                        std::cerr << "line " << result.errorLine << ": not a number\n";
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    struct ParseResult
+    {
+        size_t                                  values = 0;             // numbers read
+        size_t                                  elements = 0;           // vectors appended
+        bool                                    ok = true;
+        size_t                                  errorOffset = 0;        // byte of the bad token, or the end for a partial vector
+        size_t                                  errorLine = 0;          // 1 based
+        size_t                                  errorColumn = 0;        // 1 based
+
+        inline explicit operator bool() const { return ok; }
+    };
+
+    // append to out; on error the complete vectors before the bad token are kept
+    ParseResult                                 Parse(const char* text, const size_t length, std::vector<float>& out);
+    ParseResult                                 Parse(const char* text, const size_t length, std::vector<float2>& out);
+    ParseResult                                 Parse(const char* text, const size_t length, std::vector<float3>& out);
+    ParseResult                                 Parse(const char* text, const size_t length, std::vector<float4>& out);
+    // first byte at or after position that is not whitespace, counting the newlines passed
+    size_t                                      SkipWhitespace(const char* text, size_t position, const size_t length, size_t* newlinesInOut);
+
+    // read the rest of the stream, failbit is set at the first bad token
+    std::istream&                               operator>> (std::istream& is, std::vector<float2>& out);
+    std::istream&                               operator>> (std::istream& is, std::vector<float3>& out);
+    std::istream&                               operator>> (std::istream& is, std::vector<float4>& out);
+}
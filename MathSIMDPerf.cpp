@@ -0,0 +1,169 @@
+﻿#include "MathSIMDPerf.h"
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   PerfCounters
+******************************************************************************/
+#if defined(__linux__)
+namespace
+{
+    int OpenCounter(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0)); // this thread, any cpu
+    }
+}
+
+King::PerfCounters::PerfCounters()
+{
+    fd[Cycles] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fd[Instructions] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fd[L1DMisses] = OpenCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    fd[LLCMisses] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fd[BranchMisses] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+}
+
+King::PerfCounters::~PerfCounters()
+{
+    for (int e = 0; e < EventCount; ++e)
+        if (fd[e] >= 0) close(fd[e]);
+}
+
+void King::PerfCounters::Start()
+{
+    for (int e = 0; e < EventCount; ++e)
+    {
+        if (fd[e] < 0) continue;
+        ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void King::PerfCounters::Stop()
+{
+    for (int e = 0; e < EventCount; ++e)
+        if (fd[e] >= 0) ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    for (int e = 0; e < EventCount; ++e)
+    {
+        value[e] = 0;
+        uint64_t data[3]; // value, time enabled, time running
+        if (fd[e] < 0 || read(fd[e], data, sizeof(data)) != sizeof(data))
+            continue;
+        value[e] = (data[2] && data[2] < data[1]) ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+    }
+}
+#else
+King::PerfCounters::PerfCounters() { for (int e = 0; e < EventCount; ++e) fd[e] = -1; }
+King::PerfCounters::~PerfCounters() {}
+void King::PerfCounters::Start() {}
+void King::PerfCounters::Stop() {}
+#endif
+
+const char* King::PerfCounters::GetName(Event e)
+{
+    static const char* names[EventCount] = { "cycles", "instructions", "L1DMisses", "LLCMisses", "branchMisses" };
+    return e < EventCount ? names[e] : "";
+}
+
+/******************************************************************************
+*   PerfHarness
+******************************************************************************/
+const PerfResult& King::PerfHarness::Record(const std::string& name, size_t elements, size_t bytes, int repetitions, double seconds, uint64_t tscCycles)
+{
+    PerfResult r;
+    r.name = name;
+    r.elements = elements;
+    r.bytes = bytes;
+    r.repetitions = repetitions;
+    r.hardwareCounters = counters.IsAvailable();
+    r.seconds = seconds / repetitions;
+    for (int e = 0; e < PerfCounters::EventCount; ++e)
+        r.counters[e] = counters.Get(static_cast<PerfCounters::Event>(e)) / repetitions;
+    if (!r.hardwareCounters)
+        r.counters[PerfCounters::Cycles] = tscCycles / repetitions; // reference cycles, not core cycles
+
+    const double cycles = static_cast<double>(r.counters[PerfCounters::Cycles]);
+    r.ipc = (r.hardwareCounters && cycles > 0.0) ? r.counters[PerfCounters::Instructions] / cycles : 0.0;
+    r.cyclesPerElement = elements ? cycles / elements : 0.0;
+    r.bytesPerCycle = cycles > 0.0 ? bytes / cycles : 0.0;
+    r.bandwidth = r.seconds > 0.0 ? bytes / r.seconds : 0.0;
+    r.peakBandwidth = peakBandwidth;
+    r.bandwidthUtilization = peakBandwidth > 0.0 ? r.bandwidth / peakBandwidth : 0.0;
+    // DRAM traffic is the last level misses when counted, otherwise the bytes asked for, and a working set that
+    // fits the last level cache or more than the peak means the caches served the kernel
+    const auto& caches = SystemInfo::GetTopology().caches;
+    const size_t lastLevelCache = caches.empty() ? 0 : caches.back().size;
+    if (r.hardwareCounters && counters.IsAvailable(PerfCounters::LLCMisses))
+    {
+        const double dramBandwidth = r.seconds > 0.0 ? r.counters[PerfCounters::LLCMisses] * SystemInfo::GetCacheLineSize() / r.seconds : 0.0;
+        r.memoryBound = peakBandwidth > 0.0 && dramBandwidth >= memoryBoundUtilization * peakBandwidth;
+    }
+    else
+        r.memoryBound = bytes > lastLevelCache && r.bandwidthUtilization >= memoryBoundUtilization && r.bandwidthUtilization <= 1.25;
+    results.push_back(r);
+    return results.back();
+}
+
+void King::PerfHarness::Report(std::ostream& os) const
+{
+    const std::streamsize precision = os.precision();
+    os << "Peak memory bandwidth: " << std::setprecision(3) << peakBandwidth / 1.0e9 << " GB/s" << (HasHardwareCounters() ? "" : " (hardware counters unavailable, rdtsc cycles)") << "\n";
+    os.precision(precision);
+    for (const auto& r : results)
+        os << r << "\n";
+}
+
+json King::PerfHarness::ToJson() const
+{
+    json j;
+    j["peakBandwidth"] = peakBandwidth;
+    j["hardwareCounters"] = HasHardwareCounters();
+    j["results"] = results;
+    return j;
+}
+
+std::ostream& King::operator<< (std::ostream& os, const PerfResult& in)
+{
+    // the caller's formatting is restored on return
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os << std::left << setw(32) << in.name << std::right << std::fixed << std::setprecision(2)
+        << " cycles/element: " << setw(9) << in.cyclesPerElement
+        << " IPC: " << setw(5) << in.ipc
+        << " bytes/cycle: " << setw(6) << in.bytesPerCycle
+        << " GB/s: " << setw(7) << in.bandwidth / 1.0e9
+        << " of peak: " << setw(5) << in.bandwidthUtilization * 100.0 << "%"
+        << " L1D miss: " << setw(9) << in.counters[PerfCounters::L1DMisses]
+        << " LLC miss: " << setw(9) << in.counters[PerfCounters::LLCMisses]
+        << " branch miss: " << setw(7) << in.counters[PerfCounters::BranchMisses]
+        << (in.memoryBound ? "  memory bound" : "  compute bound");
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+}
+
+void King::to_json(json& j, const PerfResult& from)
+{
+    j = json{ {"name", from.name}, {"elements", from.elements}, {"bytes", from.bytes}, {"repetitions", from.repetitions}, {"hardwareCounters", from.hardwareCounters}, {"seconds", from.seconds},
+        {"ipc", from.ipc}, {"cyclesPerElement", from.cyclesPerElement}, {"bytesPerCycle", from.bytesPerCycle}, {"bandwidth", from.bandwidth}, {"peakBandwidth", from.peakBandwidth},
+        {"bandwidthUtilization", from.bandwidthUtilization}, {"memoryBound", from.memoryBound} };
+    for (int e = 0; e < PerfCounters::EventCount; ++e)
+        j[PerfCounters::GetName(static_cast<PerfCounters::Event>(e))] = from.counters[e];
+}
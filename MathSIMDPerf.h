@@ -0,0 +1,154 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDPerf
+
+Description:    Benchmark harness reading the hardware performance counters
+                around King kernels.  On Linux perf_event_open counts cycles,
+                instructions, L1 data and last level cache misses and branch
+                misses for the calling thread; IPC, bytes per cycle and achieved
+                bandwidth are reported against the peak memory bandwidth from
+                SystemInfo to show whether a kernel is compute or memory bound
+                before time is spent tuning it.
+
+                    King::PerfHarness perf;
+                    perf.Run("ShortestArc", n, n * (2 * sizeof(float3) + sizeof(quat)),
+                        [&]() { quat::ShortestArc(from.data(), to.data(), out.data(), n); });
+                    perf.Report(std::cout);
+
+                Counters need /proc/sys/kernel/perf_event_paranoid of 2 or less.
+                Without them (or off Linux) only rdtsc cycles and time are kept.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include "MathSIMDInstrument.h"
+#include <string>
+#include <chrono>
+
+namespace King {
+
+    /******************************************************************************
+    *   PerfCounters
+    *       Hardware counters of the calling thread, user space only
+    ******************************************************************************/
+    class PerfCounters
+    {
+    public:
+        enum Event { Cycles, Instructions, L1DMisses, LLCMisses, BranchMisses, EventCount };
+
+        /* variables */
+    private:
+        int                                     fd[EventCount];
+        uint64_t                                value[EventCount] = {};
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator= (const PerfCounters&) = delete;
+        ~PerfCounters();
+        // Functionality
+        void                                    Start();
+        void                                    Stop(); // values are scaled when the kernel multiplexed the counters
+        // Accessors
+        inline bool                             IsAvailable(Event e) const { return fd[e] >= 0; }
+        inline bool                             IsAvailable() const { return IsAvailable(Cycles) && IsAvailable(Instructions); }
+        inline uint64_t                         Get(Event e) const { return value[e]; }
+        static const char*                      GetName(Event e);
+    };
+    /******************************************************************************
+    *   PerfResult
+    ******************************************************************************/
+    struct PerfResult
+    {
+        std::string                             name;
+        size_t                                  elements = 0;           // per repetition
+        size_t                                  bytes = 0;              // per repetition, read plus written
+        int                                     repetitions = 0;
+        bool                                    hardwareCounters = false;
+        double                                  seconds = 0.0;          // per repetition
+        uint64_t                                counters[PerfCounters::EventCount] = {}; // per repetition
+        // derived
+        double                                  ipc = 0.0;
+        double                                  cyclesPerElement = 0.0;
+        double                                  bytesPerCycle = 0.0;
+        double                                  bandwidth = 0.0;        // bytes per second achieved
+        double                                  peakBandwidth = 0.0;    // bytes per second from SystemInfo
+        double                                  bandwidthUtilization = 0.0; // achieved / peak
+        bool                                    memoryBound = false;
+    };
+    /******************************************************************************
+    *   PerfHarness
+    *       Runs a kernel once to warm caches and code, then measures the mean of
+    *       the repetitions
+    ******************************************************************************/
+    class PerfHarness
+    {
+        /* variables */
+    private:
+        PerfCounters                            counters;
+        double                                  peakBandwidth;
+        double                                  memoryBoundUtilization = 0.6; // of peak bandwidth
+        std::vector<PerfResult>                 results;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        explicit PerfHarness(const double peakBandwidthIn = SystemInfo::GetMemoryBandwidth()) : peakBandwidth(peakBandwidthIn) {}
+        // Functionality
+        template<class Kernel>
+        const PerfResult&                       Run(const std::string& name, size_t elements, size_t bytes, Kernel&& kernel, int repetitions = 10)
+        {
+            assert(repetitions > 0);
+            kernel(); // warm up
+            const auto begin = std::chrono::steady_clock::now();
+            const uint64_t tsc = Instrument::ReadCycles();
+            counters.Start();
+            for (int r = 0; r < repetitions; ++r)
+                kernel();
+            counters.Stop();
+            const uint64_t tscCycles = Instrument::ReadCycles() - tsc;
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            return Record(name, elements, bytes, repetitions, seconds, tscCycles);
+        }
+        void                                    Report(std::ostream& os) const;
+        json                                    ToJson() const;
+        inline void                             Clear() { results.clear(); }
+        // Assignments
+        inline void                             SetPeakBandwidth(const double bytesPerSecond) { peakBandwidth = bytesPerSecond; }
+        inline void                             SetMemoryBoundUtilization(const double fractionOfPeak) { memoryBoundUtilization = fractionOfPeak; }
+        // Accessors
+        inline const std::vector<PerfResult>&   GetResults() const { return results; }
+        inline double                           GetPeakBandwidth() const { return peakBandwidth; }
+        inline bool                             HasHardwareCounters() const { return counters.IsAvailable(); }
+    private:
+        const PerfResult&                       Record(const std::string& name, size_t elements, size_t bytes, int repetitions, double seconds, uint64_t tscCycles);
+    };
+
+    std::ostream& operator<< (std::ostream& os, const PerfResult& in);
+    void to_json(json& j, const PerfResult& from);
+}
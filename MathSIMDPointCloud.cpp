@@ -0,0 +1,462 @@
+﻿#include "MathSIMDPointCloud.h"
+#include "MathSIMDInstrument.h"
+#include <cstring>
+#include <sstream>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace King;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+    size_t PageSize()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    size_t PlyTypeSize(const std::string& type)
+    {
+        if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") return 1;
+        if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") return 2;
+        if (type == "int" || type == "uint" || type == "int32" || type == "uint32" || type == "float" || type == "float32") return 4;
+        if (type == "double" || type == "float64") return 8;
+        return 0;
+    }
+
+    inline float ReadCoordinate(const uint8_t* p, const bool isDouble)
+    {
+        if (isDouble)
+        {
+            double d;
+            memcpy(&d, p, sizeof(d));
+            return static_cast<float>(d);
+        }
+        float f;
+        memcpy(&f, p, sizeof(f));
+        return f;
+    }
+}
+
+/******************************************************************************
+*   MappedFile
+******************************************************************************/
+bool King::MappedFile::Open(const std::string& fileName)
+{
+    Close();
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+    HANDLE view = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* address = view ? MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!address)
+    {
+        if (view)
+            CloseHandle(view);
+        CloseHandle(handle);
+        return false;
+    }
+    file = handle;
+    mapping = view;
+    size = static_cast<size_t>(fileSize.QuadPart);
+    data = static_cast<const uint8_t*>(address);
+#else
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (address == MAP_FAILED)
+        return false;
+    madvise(address, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+    size = static_cast<size_t>(status.st_size);
+    data = static_cast<const uint8_t*>(address);
+#endif
+    return true;
+}
+
+void King::MappedFile::Close()
+{
+    if (!data)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+    file = mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+void King::MappedFile::Prefetch(const size_t offset, const size_t bytes) const
+{
+    if (!data || offset >= size)
+        return;
+    const size_t page = PageSize();
+    const size_t begin = offset / page * page;
+    const size_t end = std::min(size, offset + bytes);
+#if defined(_WIN32)
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t*>(data + begin);
+    range.NumberOfBytes = end - begin;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    madvise(const_cast<uint8_t*>(data + begin), end - begin, MADV_WILLNEED);
+#endif
+}
+
+void King::MappedFile::Discard(const size_t offset, const size_t bytes) const
+{
+    if (!data)
+        return;
+    // whole pages inside the range only, the neighbours may still be needed
+    const size_t page = PageSize();
+    const size_t begin = (offset + page - 1) / page * page;
+    const size_t end = std::min(size, offset + bytes) / page * page;
+    if (end <= begin)
+        return;
+#if defined(_WIN32)
+    VirtualUnlock(const_cast<uint8_t*>(data + begin), end - begin); // unlocked pages leave the working set
+#else
+    madvise(const_cast<uint8_t*>(data + begin), end - begin, MADV_DONTNEED);
+#endif
+}
+
+/******************************************************************************
+*   PointCloudReader
+******************************************************************************/
+bool King::PointCloudReader::Open(const std::string& fileName, const Format formatIn, const size_t pointsPerBlock)
+{
+    Close();
+    if (!file.Open(fileName))
+        return false;
+
+    format = formatIn;
+    if (format == Format::Auto)
+    {
+        const std::string extension = fileName.size() >= 5 ? fileName.substr(fileName.size() - 5) : std::string();
+        if (file.GetSize() >= 4 && memcmp(file.GetData(), "ply", 3) == 0 && (file.GetData()[3] == '\n' || file.GetData()[3] == '\r'))
+            format = Format::PLY;
+        else if (extension == ".xyzw" || extension == ".XYZW")
+            format = Format::XYZW;
+        else
+            format = Format::XYZ;
+    }
+    headerBytes = 0;
+    isDouble = false;
+    offsets[0] = 0; offsets[1] = 4; offsets[2] = 8;
+    if (format == Format::PLY)
+    {
+        if (!ParsePlyHeader())
+        {
+            file.Close();
+            return false;
+        }
+    }
+    else
+    {
+        stride = format == Format::XYZW ? 16 : 12;
+        count = file.GetSize() / stride;
+    }
+
+    chunk = (std::max<size_t>(4, pointsPerBlock) + 3) & ~size_t(3);
+    const size_t components = format == Format::XYZW ? 4 : 3;
+    for (int b = 0; b < 2; ++b)
+    {
+        storage[b].reset(static_cast<float*>(::operator new(components * chunk * sizeof(float), std::align_val_t{ 16 })));
+        float* base = storage[b].get();
+        blocks[b].x = base;
+        blocks[b].y = base + chunk;
+        blocks[b].z = base + 2 * chunk;
+        blocks[b].w = components == 4 ? base + 3 * chunk : nullptr;
+        blocks[b].count = blocks[b].first = 0;
+    }
+    worker = std::thread(&PointCloudReader::Work, this);
+    Rewind();
+    return true;
+}
+
+void King::PointCloudReader::Close()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        worker.join();
+    }
+    stop = false;
+    requested = filling = -1;
+    ready[0] = ready[1] = false;
+    storage[0].reset();
+    storage[1].reset();
+    blocks[0] = blocks[1] = PointBlock();
+    file.Close();
+    count = 0;
+}
+
+const King::PointBlock* King::PointCloudReader::Next()
+{
+    if (filling < 0)
+        return nullptr;
+    const int current = filling;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this, current]() { return ready[current]; });
+    }
+    const PointBlock& block = blocks[current];
+    const size_t nextFirst = block.first + block.count;
+    // double buffer: the block handed out last time is refilled while the caller works on this one
+    if (nextFirst < count)
+    {
+        Request(1 - current, nextFirst);
+        filling = 1 - current;
+    }
+    else
+        filling = -1;
+    return block.count ? &block : nullptr;
+}
+
+void King::PointCloudReader::Rewind()
+{
+    if (!worker.joinable())
+        return;
+    if (filling >= 0)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const int pending = filling;
+        condition.wait(lock, [this, pending]() { return ready[pending]; });
+    }
+    filling = -1;
+    if (count)
+    {
+        Request(0, 0);
+        filling = 0;
+    }
+}
+
+bool King::PointCloudReader::ParsePlyHeader()
+{
+    // header lines up to end_header, vertex data must be binary_little_endian with fixed size elements before it
+    const char* text = reinterpret_cast<const char*>(file.GetData());
+    const size_t limit = std::min<size_t>(file.GetSize(), 1 << 16);
+    size_t position = 0;
+    bool little = false, inVertex = false, vertexDone = false, found[3] = {};
+    size_t before = 0, vertexSize = 0, elementSize = 0, elementCount = 0;
+    bool elementHasList = false;
+    count = 0;
+    while (position < limit)
+    {
+        const char* end = static_cast<const char*>(memchr(text + position, '\n', limit - position));
+        if (!end)
+            return false;
+        std::string line(text + position, end);
+        position = static_cast<size_t>(end - text) + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        if (keyword == "format")
+        {
+            std::string encoding;
+            words >> encoding;
+            little = encoding == "binary_little_endian";
+        }
+        else if (keyword == "element" || keyword == "end_header")
+        {
+            // close the element before this one
+            if (inVertex)
+            {
+                vertexSize = elementSize;
+                inVertex = false;
+                vertexDone = true;
+            }
+            else if (!vertexDone && elementCount)
+            {
+                if (elementHasList)
+                    return false;
+                before += elementSize * elementCount;
+            }
+            if (keyword == "end_header")
+                break;
+            std::string name;
+            words >> name >> elementCount;
+            elementSize = 0;
+            elementHasList = false;
+            if (name == "vertex")
+            {
+                inVertex = true;
+                count = elementCount;
+            }
+        }
+        else if (keyword == "property")
+        {
+            std::string type, name;
+            words >> type;
+            if (type == "list")
+            {
+                elementHasList = true;
+                if (inVertex)
+                    return false;
+                continue;
+            }
+            words >> name;
+            const size_t bytes = PlyTypeSize(type);
+            if (bytes == 0)
+                return false;
+            if (inVertex)
+            {
+                const int axis = name == "x" ? 0 : name == "y" ? 1 : name == "z" ? 2 : -1;
+                if (axis >= 0)
+                {
+                    if (bytes != 4 && bytes != 8)
+                        return false;
+                    if (axis > 0 && (bytes == 8) != isDouble)
+                        return false; // x, y and z share one type
+                    isDouble = bytes == 8;
+                    offsets[axis] = elementSize;
+                    found[axis] = true;
+                }
+            }
+            elementSize += bytes;
+        }
+    }
+    if (!little || !vertexDone || !found[0] || !found[1] || !found[2] || vertexSize == 0)
+        return false;
+    headerBytes = position + before;
+    stride = vertexSize;
+    if (headerBytes > file.GetSize())
+        return false;
+    count = std::min(count, (file.GetSize() - headerBytes) / stride);
+    return true;
+}
+
+void King::PointCloudReader::Request(const int block, const size_t first)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[block] = false;
+        requested = block;
+        requestedFirst = first;
+    }
+    condition.notify_all();
+}
+
+void King::PointCloudReader::Work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        condition.wait(lock, [this]() { return stop || requested >= 0; });
+        if (stop)
+            return;
+        const int block = requested;
+        const size_t first = requestedFirst;
+        requested = -1;
+        lock.unlock();
+        Convert(blocks[block], first);
+        lock.lock();
+        ready[block] = true;
+        condition.notify_all();
+    }
+}
+
+void King::PointCloudReader::Convert(PointBlock& block, const size_t first)
+{
+    const size_t n = std::min(chunk, count - first);
+    KING_MATH_COUNT("PointCloudReader::Convert", n);
+    const size_t sourceOffset = headerBytes + first * stride;
+    const uint8_t* source = file.GetData() + sourceOffset;
+    file.Prefetch(sourceOffset + n * stride, chunk * stride); // the block after this one
+    block.first = first;
+    block.count = n;
+
+    size_t i = 0;
+    const bool packed = !isDouble && offsets[0] == 0 && offsets[1] == 4 && offsets[2] == 8;
+    if (packed && stride == 12)
+    {
+        // 4 points in 3 vectors: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+        for (; i + 4 <= n; i += 4)
+        {
+            const uint8_t* p = source + i * 12;
+            _mm_prefetch(reinterpret_cast<const char*>(p) + 768, _MM_HINT_NTA);
+            const XMVECTOR a = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p));
+            const XMVECTOR b = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p + 16));
+            const XMVECTOR c = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p + 32));
+            const XMVECTOR x = XMVectorPermute<0, 1, 2, 5>(XMVectorPermute<0, 3, 6, 7>(a, b), c);
+            const XMVECTOR y = XMVectorPermute<0, 1, 2, 6>(XMVectorPermute<1, 4, 7, 7>(a, b), c);
+            const XMVECTOR z = XMVectorPermute<0, 1, 4, 7>(XMVectorPermute<2, 5, 5, 5>(a, b), c);
+            XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.x + i), x);
+            XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.y + i), y);
+            XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.z + i), z);
+        }
+    }
+    else if (packed && stride == 16)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            const uint8_t* p = source + i * 16;
+            _mm_prefetch(reinterpret_cast<const char*>(p) + 1024, _MM_HINT_NTA);
+            XMMATRIX m;
+            m.r[0] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p));
+            m.r[1] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p + 16));
+            m.r[2] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p + 32));
+            m.r[3] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p + 48));
+            m = XMMatrixTranspose(m);
+            XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.x + i), m.r[0]);
+            XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.y + i), m.r[1]);
+            XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.z + i), m.r[2]);
+            if (block.w)
+                XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(block.w + i), m.r[3]);
+        }
+    }
+    for (; i < n; ++i)
+    {
+        const uint8_t* p = source + i * stride;
+        block.x[i] = ReadCoordinate(p + offsets[0], isDouble);
+        block.y[i] = ReadCoordinate(p + offsets[1], isDouble);
+        block.z[i] = ReadCoordinate(p + offsets[2], isDouble);
+        if (block.w)
+            block.w[i] = ReadCoordinate(p + 12, false);
+    }
+    for (size_t pad = n; n && pad < ((n + 3) & ~size_t(3)); ++pad)
+    {
+        block.x[pad] = block.x[n - 1];
+        block.y[pad] = block.y[n - 1];
+        block.z[pad] = block.z[n - 1];
+        if (block.w)
+            block.w[pad] = block.w[n - 1];
+    }
+    // converted, the file pages are not needed again this pass
+    file.Discard(sourceOffset, n * stride);
+}
@@ -0,0 +1,162 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDPointCloud
+
+Description:    Streams point clouds larger than RAM out of a memory mapped
+                file.  Packed float3 (XYZ, 12 bytes), float4 (XYZW, 16 bytes)
+                and binary little endian PLY vertices are converted a chunk at a
+                time into 16 byte aligned SoA blocks (x[], y[], z[], w[]) ready
+                for 4 wide kernels.  A worker converts the next chunk while the
+                caller works on the current one; only two blocks exist, the
+                pages ahead are prefetched and the pages already converted are
+                dropped so memory stays bounded by the chunk size.
+
+                    King::PointCloudReader reader;
+                    if (reader.Open("scan.ply"))
+                        while (const King::PointBlock* block = reader.Next())
+                            for (size_t i = 0; i < block->count; i += 4)
+                                bounds = Merge(bounds, block->GetX4(i), block->GetY4(i), block->GetZ4(i));
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <new>
+
+namespace King {
+
+    /******************************************************************************
+    *   MappedFile
+    *       Read only view of a whole file
+    ******************************************************************************/
+    class MappedFile
+    {
+        /* variables */
+    private:
+        const uint8_t*                          data = nullptr;
+        size_t                                  size = 0;
+#if defined(_WIN32)
+        void*                                   file = nullptr;
+        void*                                   mapping = nullptr;
+#endif
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+        ~MappedFile() { Close(); }
+        // Functionality
+        bool                                    Open(const std::string& fileName);
+        void                                    Close();
+        void                                    Prefetch(const size_t offset, const size_t bytes) const; // hint the range will be read soon
+        void                                    Discard(const size_t offset, const size_t bytes) const; // drop the range's pages from this process
+        // Accessors
+        inline const uint8_t*                   GetData() const { return data; }
+        inline size_t                           GetSize() const { return size; }
+        inline bool                             IsOpen() const { return data != nullptr; }
+    };
+    /******************************************************************************
+    *   PointBlock
+    *       SoA chunk, lanes from count up to the next multiple of 4 repeat the
+    *       last point so min/max reductions need no masking
+    ******************************************************************************/
+    struct PointBlock
+    {
+        float*                                  x = nullptr;
+        float*                                  y = nullptr;
+        float*                                  z = nullptr;
+        float*                                  w = nullptr;            // XYZW files only
+        size_t                                  count = 0;
+        size_t                                  first = 0;              // index in the file of x[0]
+
+        inline DirectX::XMVECTOR                GetX4(const size_t i) const { assert((i & 3) == 0); return DirectX::XMLoadFloat4A(reinterpret_cast<const DirectX::XMFLOAT4A*>(x + i)); }
+        inline DirectX::XMVECTOR                GetY4(const size_t i) const { assert((i & 3) == 0); return DirectX::XMLoadFloat4A(reinterpret_cast<const DirectX::XMFLOAT4A*>(y + i)); }
+        inline DirectX::XMVECTOR                GetZ4(const size_t i) const { assert((i & 3) == 0); return DirectX::XMLoadFloat4A(reinterpret_cast<const DirectX::XMFLOAT4A*>(z + i)); }
+        inline DirectX::XMVECTOR                GetW4(const size_t i) const { assert((i & 3) == 0 && w); return DirectX::XMLoadFloat4A(reinterpret_cast<const DirectX::XMFLOAT4A*>(w + i)); }
+        inline float3                           GetPoint(const size_t i) const { assert(i < count); return float3(x[i], y[i], z[i]); }
+    };
+    /******************************************************************************
+    *   PointCloudReader
+    ******************************************************************************/
+    class PointCloudReader
+    {
+    public:
+        enum class Format { Auto, XYZ, XYZW, PLY }; // Auto picks PLY from the "ply" magic, XYZW from a .xyzw extension, else XYZ
+
+        /* variables */
+    private:
+        MappedFile                              file;
+        Format                                  format = Format::XYZ;
+        size_t                                  headerBytes = 0;        // vertex data begins here
+        size_t                                  stride = 12;            // bytes per point
+        size_t                                  offsets[3] = { 0, 4, 8 }; // x, y, z within a point
+        bool                                    isDouble = false;       // PLY double coordinates
+        size_t                                  count = 0;
+        size_t                                  chunk = 0;
+
+        struct AlignedDelete { void operator() (float* p) const { ::operator delete(p, std::align_val_t{ 16 }); } };
+        std::unique_ptr<float, AlignedDelete>   storage[2];             // 16 byte aligned x, y, z(, w) planes of a block
+        PointBlock                              blocks[2];
+        std::thread                             worker;
+        std::mutex                              mutex;
+        std::condition_variable                 condition;
+        bool                                    ready[2] = {};
+        int                                     requested = -1;         // block the worker should fill
+        size_t                                  requestedFirst = 0;
+        int                                     filling = -1;           // block the caller receives next
+        bool                                    stop = false;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        PointCloudReader() = default;
+        PointCloudReader(const PointCloudReader&) = delete;
+        PointCloudReader& operator= (const PointCloudReader&) = delete;
+        ~PointCloudReader() { Close(); }
+        // Functionality
+        bool                                    Open(const std::string& fileName, const Format formatIn = Format::Auto, const size_t pointsPerBlock = 65536);
+        void                                    Close();
+        // next block, nullptr after the last; the previous block is reused so finish with it first
+        const PointBlock*                       Next();
+        void                                    Rewind();
+        template<class Function>
+        void                                    ForEach(Function&& function) { Rewind(); while (const PointBlock* block = Next()) function(*block); }
+        // Accessors
+        inline size_t                           GetCount() const { return count; }
+        inline size_t                           GetBlockSize() const { return chunk; }
+        inline Format                           GetFormat() const { return format; }
+    private:
+        bool                                    ParsePlyHeader();
+        void                                    Request(const int block, const size_t first);
+        void                                    Convert(PointBlock& block, const size_t first);
+        void                                    Work();
+    };
+}
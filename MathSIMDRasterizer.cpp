@@ -0,0 +1,300 @@
+﻿#include "MathSIMDRasterizer.h"
+#include "MathSIMDInstrument.h"
+#include "MathSIMDParallel.h"
+#include <algorithm>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    // vertices snap to 1/256 of a pixel; with coordinates below 2^24 units every product and sum of the edge functions
+    // is an integer below 2^53, exact in double precision
+    constexpr double SubPixel = 256.0;
+    constexpr double Limit = 65536.0 * SubPixel;
+
+    // edge k is opposite vertex k: v1 -> v2, v2 -> v0, v0 -> v1; E(p) = a * px + b * py + c is positive inside
+    struct alignas(16) TriangleSetup
+    {
+        DirectX::XMVECTOR                       attribute[3];
+        double                                  a[3];
+        double                                  b[3];
+        double                                  c[3];
+        double                                  threshold[3];   // E > threshold covers, -0.5 keeps centers on left or top edges
+        float                                   inverseArea;
+        int32_t                                 minX, minY, maxX, maxY; // inclusive pixel bounds inside the viewport
+        uint32_t                                triangle;
+        bool                                    swapped;        // vertex 1 and 2 exchanged to make the area positive
+    };
+
+    inline double PixelCenter(const int32_t p) { return p * SubPixel + SubPixel * 0.5; }
+
+    bool Setup(const FloatPoint2* vertices, const FloatPoint4* attributes, const uint32_t* indices, const uint32_t triangle, const int32_t width, const int32_t height, TriangleSetup& t)
+    {
+        uint32_t index[3];
+        for (int k = 0; k < 3; ++k)
+            index[k] = indices ? indices[3 * size_t(triangle) + k] : 3 * triangle + k;
+
+        double x[3], y[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            x[k] = std::nearbyint(double(vertices[index[k]].GetX()) * SubPixel);
+            y[k] = std::nearbyint(double(vertices[index[k]].GetY()) * SubPixel);
+            if (!(std::abs(x[k]) < Limit && std::abs(y[k]) < Limit)) // also false for NaN
+                return false;
+        }
+        double area2 = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if (area2 == 0.0)
+            return false;
+        t.swapped = area2 < 0.0;
+        if (t.swapped)
+        {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(index[1], index[2]);
+            area2 = -area2;
+        }
+
+        const double minXu = std::min({ x[0], x[1], x[2] });
+        const double maxXu = std::max({ x[0], x[1], x[2] });
+        const double minYu = std::min({ y[0], y[1], y[2] });
+        const double maxYu = std::max({ y[0], y[1], y[2] });
+        t.minX = std::max(0, static_cast<int32_t>(std::ceil((minXu - SubPixel * 0.5) / SubPixel)));
+        t.maxX = std::min(width - 1, static_cast<int32_t>(std::floor((maxXu - SubPixel * 0.5) / SubPixel)));
+        t.minY = std::max(0, static_cast<int32_t>(std::ceil((minYu - SubPixel * 0.5) / SubPixel)));
+        t.maxY = std::min(height - 1, static_cast<int32_t>(std::floor((maxYu - SubPixel * 0.5) / SubPixel)));
+        if (t.minX > t.maxX || t.minY > t.maxY)
+            return false;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            const int p = (k + 1) % 3;
+            const int q = (k + 2) % 3;
+            t.a[k] = y[p] - y[q];
+            t.b[k] = x[q] - x[p];
+            t.c[k] = x[p] * y[q] - y[p] * x[q];
+            const bool topLeft = t.a[k] > 0.0 || (t.a[k] == 0.0 && t.b[k] > 0.0);
+            t.threshold[k] = topLeft ? -0.5 : 0.0;
+            t.attribute[k] = attributes ? attributes[index[k]].GetVecConst() : DirectX::XMVectorZero();
+        }
+        t.inverseArea = static_cast<float>(1.0 / area2);
+        t.triangle = triangle;
+        return true;
+    }
+
+    // conservative: false only when no pixel center of the rectangle is inside the triangle
+    bool Overlaps(const TriangleSetup& t, const int32_t x0, const int32_t y0, const int32_t x1, const int32_t y1)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const double px = PixelCenter(t.a[k] > 0.0 ? x1 : x0);
+            const double py = PixelCenter(t.b[k] > 0.0 ? y1 : y0);
+            if (t.a[k] * px + t.b[k] * py + t.c[k] <= t.threshold[k])
+                return false;
+        }
+        return true;
+    }
+
+    inline __m128 ToFloat4(const __m128d lo, const __m128d hi) { return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)); }
+
+    // spans of one triangle clipped to the pixel rectangle [x0, x1) x [y0, y1), x0 a multiple of 4
+    void RasterTriangle(const TriangleSetup& t, const bool interpolate, const int32_t x0, const int32_t y0, const int32_t x1, const int32_t y1, const int32_t width, Rasterizer::SpanFunction function, void* context)
+    {
+        using namespace DirectX;
+        const int32_t xBegin = std::max(x0, t.minX) & ~3;
+        const int32_t xEnd = std::min(x1, t.maxX + 1);
+        const int32_t yBegin = std::max(y0, t.minY);
+        const int32_t yEnd = std::min(y1, t.maxY + 1);
+
+        __m128d laneLo[3], laneHi[3], step[3], threshold[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            const double a = t.a[k] * SubPixel;
+            laneLo[k] = _mm_setr_pd(0.0, a);
+            laneHi[k] = _mm_setr_pd(2.0 * a, 3.0 * a);
+            step[k] = _mm_set1_pd(4.0 * a);
+            threshold[k] = _mm_set1_pd(t.threshold[k]);
+        }
+        const XMVECTOR inverseArea = XMVectorReplicate(t.inverseArea);
+        const int vertex1 = t.swapped ? 2 : 1;
+        const int vertex2 = t.swapped ? 1 : 2;
+        XMMATRIX attributes;
+        if (interpolate)
+            attributes = XMMatrixTranspose(XMMATRIX(t.attribute[0], t.attribute[1], t.attribute[2], XMVectorZero()));
+
+        RasterSpan4 span;
+        span.triangle = t.triangle;
+        span.attributes = XMMatrixIdentity();
+        for (int32_t y = yBegin; y < yEnd; ++y)
+        {
+            const double py = PixelCenter(y);
+            __m128d eLo[3], eHi[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                const __m128d base = _mm_set1_pd(t.a[k] * PixelCenter(xBegin) + t.b[k] * py + t.c[k]);
+                eLo[k] = _mm_add_pd(base, laneLo[k]);
+                eHi[k] = _mm_add_pd(base, laneHi[k]);
+            }
+            bool entered = false;
+            for (int32_t x = xBegin; x < xEnd; x += 4)
+            {
+                __m128d inLo = _mm_cmpgt_pd(eLo[0], threshold[0]);
+                __m128d inHi = _mm_cmpgt_pd(eHi[0], threshold[0]);
+                for (int k = 1; k < 3; ++k)
+                {
+                    inLo = _mm_and_pd(inLo, _mm_cmpgt_pd(eLo[k], threshold[k]));
+                    inHi = _mm_and_pd(inHi, _mm_cmpgt_pd(eHi[k], threshold[k]));
+                }
+                int mask = _mm_movemask_pd(inLo) | (_mm_movemask_pd(inHi) << 2);
+                if (x + 4 > width)
+                    mask &= (1 << (width - x)) - 1;
+                if (mask)
+                {
+                    entered = true;
+                    span.x = x;
+                    span.y = y;
+                    span.mask = mask;
+                    const XMVECTOR w0 = XMVectorMultiply(ToFloat4(eLo[0], eHi[0]), inverseArea);
+                    const XMVECTOR w1 = XMVectorMultiply(ToFloat4(eLo[1], eHi[1]), inverseArea);
+                    const XMVECTOR w2 = XMVectorMultiply(ToFloat4(eLo[2], eHi[2]), inverseArea);
+                    span.weights[0] = w0;
+                    span.weights[vertex1] = w1;
+                    span.weights[vertex2] = w2;
+                    if (interpolate)
+                    {
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            XMVECTOR value = XMVectorMultiply(w0, XMVectorSplatX(attributes.r[c]));
+                            value = XMVectorMultiplyAdd(w1, XMVectorSplatY(attributes.r[c]), value);
+                            span.attributes.r[c] = XMVectorMultiplyAdd(w2, XMVectorSplatZ(attributes.r[c]), value);
+                        }
+                    }
+                    function(context, span);
+                }
+                else if (entered)
+                    break; // convex, the row has been left
+                for (int k = 0; k < 3; ++k)
+                {
+                    eLo[k] = _mm_add_pd(eLo[k], step[k]);
+                    eHi[k] = _mm_add_pd(eHi[k], step[k]);
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+*   Rasterizer
+******************************************************************************/
+King::Rasterizer::Rasterizer(const int32_t widthIn, const int32_t heightIn, const int32_t tileSizeIn, const size_t threadsIn) :
+    width(std::max(0, widthIn)),
+    height(std::max(0, heightIn)),
+    tileSize((std::max(4, tileSizeIn) + 3) & ~3)
+{
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+    SetThreadCount(threadsIn);
+}
+
+void King::Rasterizer::SetThreadCount(const size_t threadsIn)
+{
+    threads = threadsIn ? threadsIn : std::max<size_t>(1, SystemInfo::GetLogicalProcessorCount());
+}
+
+void King::Rasterizer::Rasterize(const FloatPoint2* vertices, const FloatPoint4* attributes, const uint32_t* indices, size_t triangleCount, SpanFunction function, void* context) const
+{
+    KING_MATH_COUNT("Rasterizer::Rasterize", triangleCount);
+    assert(vertices && function);
+    assert(triangleCount < size_t(UINT32_MAX));
+    if (width == 0 || height == 0)
+        return;
+
+    // setup and binning, in submission order so each tile keeps the draw order
+    std::vector<TriangleSetup> triangles;
+    triangles.reserve(triangleCount);
+    std::vector<std::vector<uint32_t>> bins(size_t(tilesX) * tilesY);
+    TriangleSetup t;
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        if (!Setup(vertices, attributes, indices, static_cast<uint32_t>(i), width, height, t))
+            continue;
+        const uint32_t setup = static_cast<uint32_t>(triangles.size());
+        triangles.push_back(t);
+        const bool single = t.minX / tileSize == t.maxX / tileSize && t.minY / tileSize == t.maxY / tileSize;
+        for (int32_t ty = t.minY / tileSize; ty <= t.maxY / tileSize; ++ty)
+        {
+            for (int32_t tx = t.minX / tileSize; tx <= t.maxX / tileSize; ++tx)
+            {
+                const int32_t x0 = std::max(t.minX, tx * tileSize);
+                const int32_t y0 = std::max(t.minY, ty * tileSize);
+                const int32_t x1 = std::min(t.maxX, (tx + 1) * tileSize - 1);
+                const int32_t y1 = std::min(t.maxY, (ty + 1) * tileSize - 1);
+                if (single || Overlaps(t, x0, y0, x1, y1))
+                    bins[size_t(ty) * tilesX + tx].push_back(setup);
+            }
+        }
+    }
+
+    std::vector<uint32_t> work;
+    for (size_t tile = 0; tile < bins.size(); ++tile)
+    {
+        if (!bins[tile].empty())
+            work.push_back(static_cast<uint32_t>(tile));
+    }
+    if (work.empty())
+        return;
+
+    // raster, one thread owns a tile at a time
+    const bool interpolate = attributes != nullptr;
+    ParallelItems(work.size(), threads, [&](size_t w)
+    {
+        const int32_t tx = static_cast<int32_t>(work[w] % tilesX);
+        const int32_t ty = static_cast<int32_t>(work[w] / tilesX);
+        const int32_t x0 = tx * tileSize;
+        const int32_t y0 = ty * tileSize;
+        const int32_t x1 = std::min(width, x0 + tileSize);
+        const int32_t y1 = std::min(height, y0 + tileSize);
+        for (const uint32_t setup : bins[work[w]])
+            RasterTriangle(triangles[setup], interpolate, x0, y0, x1, y1, width, function, context);
+    });
+}
+
+size_t King::Rasterizer::Coverage(const FloatPoint2* vertices, const uint32_t* indices, size_t triangleCount, std::vector<IntPoint2>& pixelsOut) const
+{
+    std::vector<std::vector<IntPoint2>> tiles(size_t(tilesX) * tilesY);
+    Rasterize(vertices, nullptr, indices, triangleCount, [this, &tiles](const RasterSpan4& span)
+    {
+        auto& pixels = tiles[size_t(span.y / tileSize) * tilesX + span.x / tileSize];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (span.IsCovered(lane))
+                pixels.emplace_back(span.x + lane, span.y);
+        }
+    });
+    const size_t before = pixelsOut.size();
+    for (const auto& pixels : tiles)
+        pixelsOut.insert(pixelsOut.end(), pixels.begin(), pixels.end());
+    return pixelsOut.size() - before;
+}
+
+size_t King::Rasterizer::TileCoverage(const FloatPoint2* vertices, const uint32_t* indices, size_t triangleCount, std::vector<IntPoint2>& tilesOut) const
+{
+    std::vector<uint8_t> covered(size_t(tilesX) * tilesY, 0);
+    Rasterize(vertices, nullptr, indices, triangleCount, [this, &covered](const RasterSpan4& span)
+    {
+        covered[size_t(span.y / tileSize) * tilesX + span.x / tileSize] = 1;
+    });
+    const size_t before = tilesOut.size();
+    for (int32_t ty = 0; ty < tilesY; ++ty)
+    {
+        for (int32_t tx = 0; tx < tilesX; ++tx)
+        {
+            if (covered[size_t(ty) * tilesX + tx])
+                tilesOut.emplace_back(tx, ty);
+        }
+    }
+    return tilesOut.size() - before;
+}
@@ -0,0 +1,124 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDRasterizer
+
+Description:    Software rasterization of 2D triangles onto an integer pixel grid
+                for servers without GPUs: occlusion depth buffers and navmesh
+                baking.  Triangles are set up once and binned into square tiles,
+                then worker threads take whole tiles and walk the covered rows
+                four pixels at a time with half-space edge functions.  Each
+                covered span of 4 receives the barycentric interpolation of the
+                FloatPoint4 vertex attributes, transposed so a depth test or
+                write stays in SIMD registers.
+
+                    King::Rasterizer raster(1024, 512);
+                    raster.Rasterize(positions, attributes, indices, triangles, [&](const King::RasterSpan4& span)
+                    {
+                        // span.attributes.r[0] holds attribute x for pixels span.x .. span.x + 3 of row span.y
+                    });
+
+                    std::vector<King::IntPoint2> pixels;
+                    raster.Coverage(positions, indices, triangles, pixels);
+
+                Pixel centers are at +0.5.  Vertices snap to 1/256 of a pixel and
+                the edge functions are exact in double precision for vertices
+                within 65536 pixels of the origin; centers exactly on an edge go
+                to one side only, so a mesh without gaps covers every pixel once.
+                Both windings are drawn.  Attributes interpolate linearly in screen space; divide by
+                w before and multiply after for perspective correct values.
+
+                Tiles run on several threads at once, so the callback must be
+                safe to call concurrently for different tiles.  Within a tile the
+                spans of a triangle arrive before those of later triangles.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include <memory>
+#include <type_traits>
+
+namespace King {
+
+    /******************************************************************************
+    *   RasterSpan4
+    *       Four horizontal pixels of one row covered by one triangle
+    ******************************************************************************/
+    struct alignas(16) RasterSpan4
+    {
+        DirectX::XMMATRIX                       attributes; // transposed, r[0] holds attribute x of the 4 pixels, r[3] attribute w
+        DirectX::XMVECTOR                       weights[3]; // barycentric weight of vertex 0, 1 and 2 per pixel
+        int32_t                                 x;          // leftmost pixel, a multiple of 4
+        int32_t                                 y;
+        int                                     mask;       // bit n set when pixel x + n is covered
+        uint32_t                                triangle;   // index of the triangle in the draw
+
+        inline bool                             IsCovered(const int lane) const { return (mask >> lane) & 1; }
+        inline FloatPoint4                      GetAttribute(const int lane) const { return FloatPoint4(DirectX::XMMatrixTranspose(attributes).r[lane]); }
+    };
+
+    /******************************************************************************
+    *   Rasterizer
+    ******************************************************************************/
+    class Rasterizer
+    {
+    public:
+        typedef void                            (*SpanFunction)(void* context, const RasterSpan4& span);
+
+        /* variables */
+    private:
+        int32_t                                 width;
+        int32_t                                 height;
+        int32_t                                 tileSize;
+        int32_t                                 tilesX;
+        int32_t                                 tilesY;
+        size_t                                  threads;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        Rasterizer(const int32_t widthIn, const int32_t heightIn, const int32_t tileSizeIn = 32, const size_t threadsIn = 0); // tile size rounds up to a multiple of 4, 0 threads is one per logical processor
+        // Accessors
+        inline int32_t                          GetWidth() const { return width; }
+        inline int32_t                          GetHeight() const { return height; }
+        inline int32_t                          GetTileSize() const { return tileSize; }
+        inline IntPoint2                        GetTileCount() const { return IntPoint2(tilesX, tilesY); }
+        inline size_t                           GetThreadCount() const { return threads; }
+        // Assignments
+        void                                    SetThreadCount(const size_t threadsIn);
+        // Functionality
+        // vertices in pixels; attributes may be null; indices may be null for sequential triangles of 3 vertices
+        void                                    Rasterize(const FloatPoint2* vertices, const FloatPoint4* attributes, const uint32_t* indices, size_t triangleCount, SpanFunction function, void* context) const;
+        template<class Function>
+        inline void                             Rasterize(const FloatPoint2* vertices, const FloatPoint4* attributes, const uint32_t* indices, size_t triangleCount, Function&& function) const
+        {
+            using F = std::remove_reference_t<Function>;
+            Rasterize(vertices, attributes, indices, triangleCount, [](void* context, const RasterSpan4& span) { (*static_cast<F*>(context))(span); },
+                const_cast<void*>(static_cast<const void*>(std::addressof(function))));
+        }
+        size_t                                  Coverage(const FloatPoint2* vertices, const uint32_t* indices, size_t triangleCount, std::vector<IntPoint2>& pixelsOut) const; // appends covered pixels by tile, once per covering triangle
+        size_t                                  TileCoverage(const FloatPoint2* vertices, const uint32_t* indices, size_t triangleCount, std::vector<IntPoint2>& tilesOut) const; // appends tiles with a covered pixel, in tile units
+    };
+}
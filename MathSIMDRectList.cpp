@@ -0,0 +1,353 @@
+#include "MathSIMDRectList.h"
+#include "MathSIMDInstrument.h"
+#include <algorithm>
+#include <limits>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Streams
+******************************************************************************/
+std::ostream& King::operator<< (std::ostream& os, const King::RectList& in)
+{
+    os << "{ " << "rects: " << in.GetCount();
+    for (size_t i = 0; i < in.GetCount(); ++i)
+        os << " { min: " << in.GetMin(i) << " max: " << in.GetMax(i) << " z: " << in.GetZ(i) << " id: " << in.GetId(i) << " }";
+    return os << " }";
+}
+
+std::ostream& King::operator<< (std::ostream& os, const King::DirtyRects& in)
+{
+    os << "{ " << "dirty: " << in.GetCount();
+    for (size_t i = 0; i < in.GetCount(); ++i)
+        os << " { min: " << in.GetMin(i) << " max: " << in.GetMax(i) << " }";
+    return os << " }";
+}
+
+/******************************************************************************
+*   json
+******************************************************************************/
+void King::to_json(json& j, const RectList& from)
+{
+    j = json::array();
+    for (size_t i = 0; i < from.GetCount(); ++i)
+        j.push_back(json{ {"min", from.GetMin(i)}, {"max", from.GetMax(i)}, {"z", from.GetZ(i)}, {"id", from.GetId(i)} });
+}
+
+void King::to_json(json& j, const DirtyRects& from)
+{
+    j = json::array();
+    for (size_t i = 0; i < from.GetCount(); ++i)
+        j.push_back(json{ {"min", from.GetMin(i)}, {"max", from.GetMax(i)} });
+}
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    inline __m128i Load4(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline DirectX::XMVECTOR Load4(const float* p) { return DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4*>(p)); }
+    inline __m128i Select(const __m128i mask, const __m128i a, const __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); } // mask ? a : b
+
+    // min <= p < max on both axes; SSE2 has no less or equal so the greater than is inverted
+    inline __m128i Inside(const int32_t* minX, const int32_t* minY, const int32_t* maxX, const int32_t* maxY, const __m128i px, const __m128i py)
+    {
+        const __m128i inX = _mm_andnot_si128(_mm_cmpgt_epi32(Load4(minX), px), _mm_cmpgt_epi32(Load4(maxX), px));
+        const __m128i inY = _mm_andnot_si128(_mm_cmpgt_epi32(Load4(minY), py), _mm_cmpgt_epi32(Load4(maxY), py));
+        return _mm_and_si128(inX, inY);
+    }
+
+    inline size_t AppendLanes(int bits, size_t index, std::vector<uint32_t>& indicesOut)
+    {
+        size_t found = 0;
+        for (int lane = 0; bits; ++lane, bits >>= 1)
+        {
+            if (bits & 1)
+            {
+                indicesOut.push_back(static_cast<uint32_t>(index + lane));
+                ++found;
+            }
+        }
+        return found;
+    }
+
+    inline float Area(float x0, float y0, float x1, float y1) { return (x1 - x0) * (y1 - y0); }
+}
+
+/******************************************************************************
+*   RectList
+******************************************************************************/
+void King::RectList::Pad(size_t i)
+{
+    // holds no point: min above every coordinate, max below
+    minX[i] = minY[i] = std::numeric_limits<int32_t>::max();
+    maxX[i] = maxY[i] = std::numeric_limits<int32_t>::min();
+    z[i] = std::numeric_limits<int32_t>::min();
+    id[i] = 0;
+}
+
+void King::RectList::Write(size_t i, const IntPoint2 minIn, const IntPoint2 maxIn, const int32_t zIn, const uint32_t idIn)
+{
+    minX[i] = minIn.GetX();
+    minY[i] = minIn.GetY();
+    maxX[i] = maxIn.GetX();
+    maxY[i] = maxIn.GetY();
+    z[i] = zIn;
+    id[i] = idIn;
+}
+
+void King::RectList::Reserve(size_t capacity)
+{
+    const size_t padded = (capacity + 3) & ~size_t(3);
+    minX.reserve(padded);
+    minY.reserve(padded);
+    maxX.reserve(padded);
+    maxY.reserve(padded);
+    z.reserve(padded);
+    id.reserve(padded);
+}
+
+size_t King::RectList::Add(const IntPoint2 minIn, const IntPoint2 maxIn, const int32_t zIn, const uint32_t idIn)
+{
+    if (count == minX.size())
+    {
+        const size_t padded = count + 4;
+        minX.resize(padded);
+        minY.resize(padded);
+        maxX.resize(padded);
+        maxY.resize(padded);
+        z.resize(padded);
+        id.resize(padded);
+        for (size_t i = count; i < padded; ++i)
+            Pad(i);
+    }
+    Write(count, minIn, maxIn, zIn, idIn);
+    return count++;
+}
+
+void King::RectList::Set(size_t i, const IntPoint2 minIn, const IntPoint2 maxIn)
+{
+    assert(i < count);
+    Write(i, minIn, maxIn, z[i], id[i]);
+}
+
+void King::RectList::Remove(size_t i)
+{
+    assert(i < count);
+    const size_t last = --count;
+    if (i != last)
+        Write(i, IntPoint2(minX[last], minY[last]), IntPoint2(maxX[last], maxY[last]), z[last], id[last]);
+    Pad(last);
+}
+
+void King::RectList::Clear()
+{
+    minX.clear();
+    minY.clear();
+    maxX.clear();
+    maxY.clear();
+    z.clear();
+    id.clear();
+    count = 0;
+}
+
+int32_t King::RectList::HitTest(const IntPoint2 point) const
+{
+    KING_MATH_COUNT("RectList::HitTest", count);
+    const __m128i px = _mm_set1_epi32(point.GetX());
+    const __m128i py = _mm_set1_epi32(point.GetY());
+    const __m128i four = _mm_set1_epi32(4);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i bestZ = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+    __m128i bestIndex = _mm_set1_epi32(NoHit);
+    // per lane topmost, later rects of equal z replace earlier ones
+    for (size_t i = 0; i < minX.size(); i += 4)
+    {
+        const __m128i zi = Load4(&z[i]);
+        const __m128i better = _mm_andnot_si128(_mm_cmpgt_epi32(bestZ, zi), Inside(&minX[i], &minY[i], &maxX[i], &maxY[i], px, py));
+        bestZ = Select(better, zi, bestZ);
+        bestIndex = Select(better, index, bestIndex);
+        index = _mm_add_epi32(index, four);
+    }
+    alignas(16) int32_t laneZ[4], laneIndex[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(laneZ), bestZ);
+    _mm_store_si128(reinterpret_cast<__m128i*>(laneIndex), bestIndex);
+    int32_t hit = NoHit;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        if (laneIndex[lane] == NoHit)
+            continue;
+        if (hit == NoHit || laneZ[lane] > z[hit] || (laneZ[lane] == z[hit] && laneIndex[lane] > hit))
+            hit = laneIndex[lane];
+    }
+    return hit;
+}
+
+void King::RectList::HitTest(const IntPoint2* points, size_t pointCount, int32_t* indicesOut) const
+{
+    KING_MATH_COUNT("RectList::HitTest(batch)", pointCount);
+    for (size_t i = 0; i < pointCount; ++i)
+        indicesOut[i] = HitTest(points[i]);
+}
+
+size_t King::RectList::HitTestAll(const IntPoint2 point, std::vector<uint32_t>& indicesOut) const
+{
+    KING_MATH_COUNT("RectList::HitTestAll", count);
+    const __m128i px = _mm_set1_epi32(point.GetX());
+    const __m128i py = _mm_set1_epi32(point.GetY());
+    size_t found = 0;
+    for (size_t i = 0; i < minX.size(); i += 4)
+        found += AppendLanes(_mm_movemask_ps(_mm_castsi128_ps(Inside(&minX[i], &minY[i], &maxX[i], &maxY[i], px, py))), i, indicesOut);
+    return found;
+}
+
+size_t King::RectList::Query(const IntPoint2 minIn, const IntPoint2 maxIn, std::vector<uint32_t>& indicesOut) const
+{
+    KING_MATH_COUNT("RectList::Query", count);
+    const __m128i qMinX = _mm_set1_epi32(minIn.GetX());
+    const __m128i qMinY = _mm_set1_epi32(minIn.GetY());
+    const __m128i qMaxX = _mm_set1_epi32(maxIn.GetX());
+    const __m128i qMaxY = _mm_set1_epi32(maxIn.GetY());
+    size_t found = 0;
+    for (size_t i = 0; i < minX.size(); i += 4)
+    {
+        // min < qMax and qMin < max on both axes
+        const __m128i overlapX = _mm_and_si128(_mm_cmpgt_epi32(qMaxX, Load4(&minX[i])), _mm_cmpgt_epi32(Load4(&maxX[i]), qMinX));
+        const __m128i overlapY = _mm_and_si128(_mm_cmpgt_epi32(qMaxY, Load4(&minY[i])), _mm_cmpgt_epi32(Load4(&maxY[i]), qMinY));
+        found += AppendLanes(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(overlapX, overlapY))), i, indicesOut);
+    }
+    return found;
+}
+
+/******************************************************************************
+*   DirtyRects
+******************************************************************************/
+Rect2D King::DirtyRects::GetBounds() const
+{
+    if (!count)
+        return Rect2D();
+    Rect2D bounds = GetRect(0);
+    for (size_t i = 1; i < count; ++i)
+        bounds = bounds.Union(GetRect(i));
+    return bounds;
+}
+
+double King::DirtyRects::GetArea() const
+{
+    double area = 0.0;
+    for (size_t i = 0; i < count; ++i)
+        area += static_cast<double>(Area(minX[i], minY[i], maxX[i], maxY[i]));
+    return area;
+}
+
+void King::DirtyRects::Clear()
+{
+    minX.clear();
+    minY.clear();
+    maxX.clear();
+    maxY.clear();
+    count = 0;
+}
+
+void King::DirtyRects::RemoveAt(size_t i)
+{
+    const size_t last = --count;
+    minX[i] = minX[last];
+    minY[i] = minY[last];
+    maxX[i] = maxX[last];
+    maxY[i] = maxY[last];
+    minX[last] = minY[last] = maxX[last] = maxY[last] = 0.0f;
+}
+
+void King::DirtyRects::Add(const IntPoint2 minIn, const IntPoint2 maxIn)
+{
+    KING_MATH_COUNT("DirtyRects::Add", count);
+    if (maxIn.GetX() <= minIn.GetX() || maxIn.GetY() <= minIn.GetY())
+        return;
+    Insert(static_cast<float>(minIn.GetX()), static_cast<float>(minIn.GetY()), static_cast<float>(maxIn.GetX()), static_cast<float>(maxIn.GetY()));
+    Collapse();
+}
+
+void King::DirtyRects::Insert(float x0, float y0, float x1, float y1)
+{
+    using namespace DirectX;
+    // absorb rects four at a time until none is worth merging, each merge can make the next one worth it
+    for (bool merged = true; merged;)
+    {
+        merged = false;
+        const XMVECTOR nx0 = XMVectorReplicate(x0), ny0 = XMVectorReplicate(y0);
+        const XMVECTOR nx1 = XMVectorReplicate(x1), ny1 = XMVectorReplicate(y1);
+        const XMVECTOR area = XMVectorReplicate(Area(x0, y0, x1, y1));
+        const XMVECTOR slack = XMVectorReplicate(mergeSlack);
+        for (size_t i = 0; i < count; i += 4)
+        {
+            const XMVECTOR rx0 = Load4(&minX[i]), ry0 = Load4(&minY[i]);
+            const XMVECTOR rx1 = Load4(&maxX[i]), ry1 = Load4(&maxY[i]);
+            const XMVECTOR unionArea = XMVectorMultiply(XMVectorSubtract(XMVectorMax(rx1, nx1), XMVectorMin(rx0, nx0)), XMVectorSubtract(XMVectorMax(ry1, ny1), XMVectorMin(ry0, ny0)));
+            const XMVECTOR parts = XMVectorAdd(area, XMVectorMultiply(XMVectorSubtract(rx1, rx0), XMVectorSubtract(ry1, ry0)));
+            int bits = _mm_movemask_ps(XMVectorLessOrEqual(unionArea, XMVectorMultiply(parts, slack)));
+            if (count - i < 4)
+                bits &= (1 << (count - i)) - 1;
+            if (bits)
+            {
+                size_t j = i;
+                while (!(bits & 1))
+                {
+                    bits >>= 1;
+                    ++j;
+                }
+                x0 = std::min(x0, minX[j]);
+                y0 = std::min(y0, minY[j]);
+                x1 = std::max(x1, maxX[j]);
+                y1 = std::max(y1, maxY[j]);
+                RemoveAt(j);
+                merged = true;
+                break;
+            }
+        }
+    }
+    if (count + 4 > minX.size())
+    {
+        const size_t padded = ((count + 4) + 3) & ~size_t(3); // a full group of 4 past the last rect is always readable
+        minX.resize(padded);
+        minY.resize(padded);
+        maxX.resize(padded);
+        maxY.resize(padded);
+    }
+    minX[count] = x0;
+    minY[count] = y0;
+    maxX[count] = x1;
+    maxY[count] = y1;
+    ++count;
+}
+
+void King::DirtyRects::Collapse()
+{
+    while (count > maxRects)
+    {
+        // merge the pair whose union adds the least area
+        size_t bestA = 0, bestB = 1;
+        float bestGrowth = std::numeric_limits<float>::max();
+        for (size_t a = 0; a < count; ++a)
+        {
+            const float areaA = Area(minX[a], minY[a], maxX[a], maxY[a]);
+            for (size_t b = a + 1; b < count; ++b)
+            {
+                const float growth = Area(std::min(minX[a], minX[b]), std::min(minY[a], minY[b]), std::max(maxX[a], maxX[b]), std::max(maxY[a], maxY[b])) - areaA - Area(minX[b], minY[b], maxX[b], maxY[b]);
+                if (growth < bestGrowth)
+                {
+                    bestGrowth = growth;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        const float x0 = std::min(minX[bestA], minX[bestB]), y0 = std::min(minY[bestA], minY[bestB]);
+        const float x1 = std::max(maxX[bestA], maxX[bestB]), y1 = std::max(maxY[bestA], maxY[bestB]);
+        RemoveAt(bestB); // higher index first so bestA stays put
+        RemoveAt(bestA);
+        Insert(x0, y0, x1, y1);
+    }
+}
@@ -0,0 +1,153 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDRectList
+
+Description:    Integer UI rectangles for dense tool layouts.  RectList keeps
+                thousands of widget rects as separate min and max arrays with a
+                z order and hit tests a cursor (or many points) four rects per
+                step with SSE2 integer compares, returning the topmost rect.
+                DirtyRects collects invalidated areas and merges them while the
+                union is not much larger than the parts, so a frame repaints a
+                few rects instead of hundreds of small ones.
+
+                    King::RectList widgets;
+                    const size_t button = widgets.Add(int2(10, 10), int2(90, 30), 2);
+                    const int32_t hit = widgets.HitTest(cursor);
+                    if (hit == static_cast<int32_t>(button)) ...
+
+                    King::DirtyRects dirty;
+                    dirty.Add(int2(10, 10), int2(90, 30));
+                    for (size_t i = 0; i < dirty.GetCount(); ++i) Repaint(dirty.GetRect(i));
+
+                Rects are half open, [min, max) in pixels.  The topmost hit is
+                the highest z, the later added rect when z is equal.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+#include "MathSIMDGeometry2D.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   RectList
+    *       Min and max arrays padded to a multiple of 4 with rects that hold no
+    *       point, so the hit test never needs a tail loop
+    ******************************************************************************/
+    class RectList
+    {
+        /* variables */
+    public:
+        static constexpr int32_t                NoHit = -1;
+    private:
+        std::vector<int32_t>                    minX;
+        std::vector<int32_t>                    minY;
+        std::vector<int32_t>                    maxX;
+        std::vector<int32_t>                    maxY;
+        std::vector<int32_t>                    z;
+        std::vector<uint32_t>                   id;
+        size_t                                  count = 0;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        RectList() = default;
+        explicit RectList(size_t capacity) { Reserve(capacity); }
+        // Accessors
+        inline size_t                           GetCount() const { return count; }
+        inline IntPoint2                        GetMin(size_t i) const { assert(i < count); return IntPoint2(minX[i], minY[i]); }
+        inline IntPoint2                        GetMax(size_t i) const { assert(i < count); return IntPoint2(maxX[i], maxY[i]); }
+        inline Rect2D                           GetRect(size_t i) const { return Rect2D(GetMin(i), GetMax(i)); }
+        inline int32_t                          GetZ(size_t i) const { assert(i < count); return z[i]; }
+        inline uint32_t                         GetId(size_t i) const { assert(i < count); return id[i]; }
+        // Assignments
+        size_t                                  Add(const IntPoint2 minIn, const IntPoint2 maxIn, const int32_t zIn = 0, const uint32_t idIn = 0); // returns the index
+        void                                    Set(size_t i, const IntPoint2 minIn, const IntPoint2 maxIn);
+        inline void                             SetZ(size_t i, const int32_t zIn) { assert(i < count); z[i] = zIn; }
+        inline void                             SetId(size_t i, const uint32_t idIn) { assert(i < count); id[i] = idIn; }
+        void                                    Remove(size_t i); // the last rect moves into i
+        void                                    Clear();
+        void                                    Reserve(size_t capacity);
+        // Functionality
+        int32_t                                 HitTest(const IntPoint2 point) const; // index of the topmost rect holding point or NoHit
+        inline int32_t                          HitTest(const UIntPoint2 point) const { return HitTest(IntPoint2(point.GetX(), point.GetY())); }
+        void                                    HitTest(const IntPoint2* points, size_t pointCount, int32_t* indicesOut) const; // batch, topmost per point
+        size_t                                  HitTestAll(const IntPoint2 point, std::vector<uint32_t>& indicesOut) const; // appends every rect holding point in index order
+        size_t                                  Query(const IntPoint2 minIn, const IntPoint2 maxIn, std::vector<uint32_t>& indicesOut) const; // appends rects overlapping [min, max)
+    private:
+        void                                    Write(size_t i, const IntPoint2 minIn, const IntPoint2 maxIn, const int32_t zIn, const uint32_t idIn);
+        void                                    Pad(size_t i);
+    };
+
+    /******************************************************************************
+    *   DirtyRects
+    *       Invalidated areas; a new rect absorbs every rect whose union with it
+    *       is at most mergeSlack times their summed area, and when more than
+    *       maxRects remain the pair that grows least is merged
+    ******************************************************************************/
+    class DirtyRects
+    {
+        /* variables */
+    private:
+        std::vector<float>                      minX; // exact for coordinates within 2^24
+        std::vector<float>                      minY;
+        std::vector<float>                      maxX;
+        std::vector<float>                      maxY;
+        size_t                                  count = 0;
+        size_t                                  maxRects;
+        float                                   mergeSlack;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        explicit DirtyRects(const size_t maxRectsIn = 16, const float mergeSlackIn = 1.25f) : maxRects(maxRectsIn ? maxRectsIn : 1), mergeSlack(mergeSlackIn) {}
+        // Accessors
+        inline size_t                           GetCount() const { return count; }
+        inline bool                             IsEmpty() const { return count == 0; }
+        inline IntPoint2                        GetMin(size_t i) const { assert(i < count); return IntPoint2(minX[i], minY[i]); }
+        inline IntPoint2                        GetMax(size_t i) const { assert(i < count); return IntPoint2(maxX[i], maxY[i]); }
+        inline Rect2D                           GetRect(size_t i) const { assert(i < count); return Rect2D(minX[i], minY[i], maxX[i], maxY[i]); }
+        Rect2D                                  GetBounds() const; // union of all, empty rect when clean
+        double                                  GetArea() const; // summed, overlap between kept rects counts twice
+        // Assignments
+        inline void                             SetMaxRects(const size_t maxRectsIn) { maxRects = maxRectsIn ? maxRectsIn : 1; Collapse(); }
+        inline void                             SetMergeSlack(const float mergeSlackIn) { mergeSlack = mergeSlackIn; }
+        // Functionality
+        void                                    Add(const IntPoint2 minIn, const IntPoint2 maxIn); // empty rects are ignored
+        inline void                             Add(const Rect2D& rect) { Add(IntPoint2(std::floor(DirectX::XMVectorGetX(rect.v)), std::floor(DirectX::XMVectorGetY(rect.v))), IntPoint2(std::ceil(DirectX::XMVectorGetZ(rect.v)), std::ceil(DirectX::XMVectorGetW(rect.v)))); } // covers every touched pixel
+        void                                    Clear();
+    private:
+        void                                    Insert(float x0, float y0, float x1, float y1);
+        void                                    RemoveAt(size_t i);
+        void                                    Collapse();
+    };
+
+    std::ostream& operator<< (std::ostream& os, const RectList& in);
+    std::ostream& operator<< (std::ostream& os, const DirtyRects& in);
+
+    void to_json(json& j, const RectList& from);
+    void to_json(json& j, const DirtyRects& from);
+}
@@ -0,0 +1,337 @@
+﻿#include "MathSIMDSVD.h"
+#include "MathSIMDInstrument.h"
+#include <algorithm>
+
+using namespace King;
+using namespace DirectX;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    const int JacobiSweeps = 6;                // the paper uses 4; the worst of random matrices needs 6 to reach float round off
+    const float Gamma = 5.828427124f;          // 3 + 2 sqrt(2), approximate angles past pi / 4 take the pi / 8 half angle instead
+    const float CosPi8 = 0.923879532f;
+    const float SinPi8 = 0.382683432f;
+    const float SqrtHalf = 0.707106781f;
+    const float QREpsilon = 1.0e-6f;
+
+    // four quaternions, one per lane
+    struct Quat4
+    {
+        XMVECTOR                                x, y, z, w;
+    };
+
+    // four symmetric 3x3, one per lane
+    struct Symmetric4
+    {
+        XMVECTOR                                s11, s21, s22, s31, s32, s33;
+    };
+
+    // four 3x3, one per lane, b[row][column]
+    struct Matrix4
+    {
+        XMVECTOR                                b[3][3];
+    };
+
+    // Hamilton product, the rotation of a * b is a's after b's on column vectors
+    inline Quat4 Multiply(const Quat4& a, const Quat4& b)
+    {
+        Quat4 r;
+        r.w = XMVectorSubtract(XMVectorSubtract(XMVectorMultiply(a.w, b.w), XMVectorMultiply(a.x, b.x)), XMVectorMultiplyAdd(a.y, b.y, XMVectorMultiply(a.z, b.z)));
+        r.x = XMVectorSubtract(XMVectorMultiplyAdd(a.w, b.x, XMVectorMultiplyAdd(a.x, b.w, XMVectorMultiply(a.y, b.z))), XMVectorMultiply(a.z, b.y));
+        r.y = XMVectorSubtract(XMVectorMultiplyAdd(a.w, b.y, XMVectorMultiplyAdd(a.y, b.w, XMVectorMultiply(a.z, b.x))), XMVectorMultiply(a.x, b.z));
+        r.z = XMVectorSubtract(XMVectorMultiplyAdd(a.w, b.z, XMVectorMultiplyAdd(a.z, b.w, XMVectorMultiply(a.x, b.y))), XMVectorMultiply(a.y, b.x));
+        return r;
+    }
+
+    inline Quat4 Conjugate(const Quat4& q) { return { XMVectorNegate(q.x), XMVectorNegate(q.y), XMVectorNegate(q.z), q.w }; }
+
+    inline Quat4 Normalize(const Quat4& q)
+    {
+        const XMVECTOR lengthSq = XMVectorMultiplyAdd(q.x, q.x, XMVectorMultiplyAdd(q.y, q.y, XMVectorMultiplyAdd(q.z, q.z, XMVectorMultiply(q.w, q.w))));
+        const XMVECTOR scale = XMVectorReciprocalSqrt(lengthSq);
+        return { XMVectorMultiply(q.x, scale), XMVectorMultiply(q.y, scale), XMVectorMultiply(q.z, scale), XMVectorMultiply(q.w, scale) };
+    }
+
+    inline Quat4 Select(const Quat4& a, const Quat4& b, FXMVECTOR control) { return { XMVectorSelect(a.x, b.x, control), XMVectorSelect(a.y, b.y, control), XMVectorSelect(a.z, b.z, control), XMVectorSelect(a.w, b.w, control) }; }
+
+    // q * (sh about axis, ch), a rotation by 2 atan(sh / ch) about the axis applied before q
+    inline void RotateAbout(Quat4& q, FXMVECTOR ch, FXMVECTOR sh, const int axis)
+    {
+        XMVECTOR* v[3] = { &q.x, &q.y, &q.z };
+        XMVECTOR& a = *v[axis];
+        XMVECTOR& b = *v[(axis + 1) % 3];
+        XMVECTOR& c = *v[(axis + 2) % 3];
+        const XMVECTOR a0 = a, b0 = b, c0 = c, w0 = q.w;
+        a = XMVectorMultiplyAdd(ch, a0, XMVectorMultiply(sh, w0));
+        q.w = XMVectorNegativeMultiplySubtract(sh, a0, XMVectorMultiply(ch, w0));
+        b = XMVectorMultiplyAdd(ch, b0, XMVectorMultiply(sh, c0));
+        c = XMVectorNegativeMultiplySubtract(sh, b0, XMVectorMultiply(ch, c0));
+    }
+
+    // column vector rotation matrix of a unit quaternion
+    inline Matrix4 ToMatrix(const Quat4& q)
+    {
+        const XMVECTOR one = XMVectorSplatOne();
+        const XMVECTOR x2 = XMVectorAdd(q.x, q.x), y2 = XMVectorAdd(q.y, q.y), z2 = XMVectorAdd(q.z, q.z);
+        const XMVECTOR xx = XMVectorMultiply(q.x, x2), yy = XMVectorMultiply(q.y, y2), zz = XMVectorMultiply(q.z, z2);
+        const XMVECTOR xy = XMVectorMultiply(q.x, y2), xz = XMVectorMultiply(q.x, z2), yz = XMVectorMultiply(q.y, z2);
+        const XMVECTOR wx = XMVectorMultiply(q.w, x2), wy = XMVectorMultiply(q.w, y2), wz = XMVectorMultiply(q.w, z2);
+        Matrix4 m;
+        m.b[0][0] = XMVectorSubtract(one, XMVectorAdd(yy, zz));
+        m.b[0][1] = XMVectorSubtract(xy, wz);
+        m.b[0][2] = XMVectorAdd(xz, wy);
+        m.b[1][0] = XMVectorAdd(xy, wz);
+        m.b[1][1] = XMVectorSubtract(one, XMVectorAdd(xx, zz));
+        m.b[1][2] = XMVectorSubtract(yz, wx);
+        m.b[2][0] = XMVectorSubtract(xz, wy);
+        m.b[2][1] = XMVectorAdd(yz, wx);
+        m.b[2][2] = XMVectorSubtract(one, XMVectorAdd(xx, yy));
+        return m;
+    }
+
+    // one approximate Givens conjugation S = Qᵀ S Q zeroing s21, accumulated into v, then the matrix is cycled so
+    // the next call works on the next pair; three calls are one sweep over (1, 2), (2, 3), (3, 1)
+    inline void JacobiConjugation(Symmetric4& s, Quat4& v, const int axis)
+    {
+        XMVECTOR ch = XMVectorScale(XMVectorSubtract(s.s11, s.s22), 2.0f);
+        XMVECTOR sh = s.s21;
+        const XMVECTOR ch2 = XMVectorMultiply(ch, ch);
+        const XMVECTOR sh2 = XMVectorMultiply(sh, sh);
+        const XMVECTOR small = XMVectorLess(XMVectorScale(sh2, Gamma), ch2);
+        const XMVECTOR w = XMVectorReciprocalSqrt(XMVectorAdd(ch2, sh2));
+        ch = XMVectorSelect(XMVectorReplicate(CosPi8), XMVectorMultiply(w, ch), small);
+        sh = XMVectorSelect(XMVectorReplicate(SinPi8), XMVectorMultiply(w, sh), small);
+
+        const XMVECTOR a = XMVectorNegativeMultiplySubtract(sh, sh, XMVectorMultiply(ch, ch)); // cos, ch and sh are unit
+        const XMVECTOR b = XMVectorScale(XMVectorMultiply(sh, ch), 2.0f);                     // sin
+        const XMVECTOR t11 = XMVectorMultiplyAdd(a, s.s11, XMVectorMultiply(b, s.s21));
+        const XMVECTOR t21 = XMVectorMultiplyAdd(a, s.s21, XMVectorMultiply(b, s.s22));
+        const XMVECTOR u11 = XMVectorNegativeMultiplySubtract(b, s.s11, XMVectorMultiply(a, s.s21));
+        const XMVECTOR u21 = XMVectorNegativeMultiplySubtract(b, s.s21, XMVectorMultiply(a, s.s22));
+        const XMVECTOR s11 = XMVectorMultiplyAdd(a, t11, XMVectorMultiply(b, t21));
+        const XMVECTOR s21 = XMVectorMultiplyAdd(a, u11, XMVectorMultiply(b, u21));
+        const XMVECTOR s22 = XMVectorNegativeMultiplySubtract(b, u11, XMVectorMultiply(a, u21));
+        const XMVECTOR s31 = XMVectorMultiplyAdd(a, s.s31, XMVectorMultiply(b, s.s32));
+        const XMVECTOR s32 = XMVectorNegativeMultiplySubtract(b, s.s31, XMVectorMultiply(a, s.s32));
+        RotateAbout(v, ch, sh, axis);
+
+        // cycle 1 -> 3, 2 -> 1, 3 -> 2
+        s.s11 = s22;
+        s.s21 = s32;
+        s.s22 = s.s33;
+        s.s31 = s21;
+        s.s32 = s31;
+        s.s33 = s11;
+    }
+
+    inline Quat4 JacobiEigen(Symmetric4& s)
+    {
+        Quat4 v = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorSplatOne() };
+        for (int sweep = 0; sweep < JacobiSweeps; ++sweep)
+        {
+            JacobiConjugation(s, v, 2);
+            JacobiConjugation(s, v, 0);
+            JacobiConjugation(s, v, 1);
+        }
+        return Normalize(v);
+    }
+
+    // where control is set, v * 90 degrees about the axis: column i takes column j and column j takes -column i
+    inline void SwapColumns(Quat4& v, const int axis, const float sign, FXMVECTOR control)
+    {
+        Quat4 swapped = v;
+        RotateAbout(swapped, XMVectorReplicate(SqrtHalf), XMVectorReplicate(sign * SqrtHalf), axis);
+        v = Select(v, swapped, control);
+    }
+
+    inline void NegateSwap(XMVECTOR& x, XMVECTOR& y, FXMVECTOR control)
+    {
+        const XMVECTOR negated = XMVectorNegate(x);
+        x = XMVectorSelect(x, y, control);
+        y = XMVectorSelect(y, negated, control);
+    }
+
+    inline void Swap(XMVECTOR& x, XMVECTOR& y, FXMVECTOR control)
+    {
+        const XMVECTOR x0 = x;
+        x = XMVectorSelect(x, y, control);
+        y = XMVectorSelect(y, x0, control);
+    }
+
+    // Givens rotation zeroing a2 against a1, as the half angle cosine and sine
+    inline void QRGivens(FXMVECTOR a1, FXMVECTOR a2, XMVECTOR& ch, XMVECTOR& sh)
+    {
+        const XMVECTOR epsilon = XMVectorReplicate(QREpsilon);
+        const XMVECTOR rho = XMVectorSqrt(XMVectorMultiplyAdd(a1, a1, XMVectorMultiply(a2, a2)));
+        sh = XMVectorSelect(XMVectorZero(), a2, XMVectorGreater(rho, epsilon));
+        ch = XMVectorAdd(XMVectorAbs(a1), XMVectorMax(rho, epsilon));
+        Swap(sh, ch, XMVectorLess(a1, XMVectorZero()));
+        const XMVECTOR w = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(ch, ch, XMVectorMultiply(sh, sh)));
+        ch = XMVectorMultiply(ch, w);
+        sh = XMVectorMultiply(sh, w);
+    }
+
+    // rows p and q of b rotated by Qᵀ, the Givens rotation of half angle cosine ch and sine sh
+    inline void ApplyGivens(Matrix4& m, const int p, const int q, FXMVECTOR ch, FXMVECTOR sh)
+    {
+        const XMVECTOR a = XMVectorNegativeMultiplySubtract(XMVectorScale(sh, 2.0f), sh, XMVectorSplatOne());
+        const XMVECTOR b = XMVectorScale(XMVectorMultiply(ch, sh), 2.0f);
+        for (int column = 0; column < 3; ++column)
+        {
+            const XMVECTOR bp = m.b[p][column], bq = m.b[q][column];
+            m.b[p][column] = XMVectorMultiplyAdd(a, bp, XMVectorMultiply(b, bq));
+            m.b[q][column] = XMVectorNegativeMultiplySubtract(b, bp, XMVectorMultiply(a, bq));
+        }
+    }
+
+    // A = U diag(sigma) Vᵀ for four matrices
+    void Decompose4(const Matrix4& a, Quat4& u, XMVECTOR sigma[3], Quat4& v)
+    {
+        // AᵀA
+        Symmetric4 s;
+        XMVECTOR* ata[6] = { &s.s11, &s.s21, &s.s22, &s.s31, &s.s32, &s.s33 };
+        const int pairs[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 2, 0 }, { 2, 1 }, { 2, 2 } };
+        for (int k = 0; k < 6; ++k)
+        {
+            const int i = pairs[k][0], j = pairs[k][1];
+            *ata[k] = XMVectorMultiplyAdd(a.b[0][i], a.b[0][j], XMVectorMultiplyAdd(a.b[1][i], a.b[1][j], XMVectorMultiply(a.b[2][i], a.b[2][j])));
+        }
+        v = JacobiEigen(s);
+
+        // B = A V, columns orthogonal with the singular values as lengths
+        const Matrix4 rv = ToMatrix(v);
+        Matrix4 b;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                b.b[i][j] = XMVectorMultiplyAdd(a.b[i][0], rv.b[0][j], XMVectorMultiplyAdd(a.b[i][1], rv.b[1][j], XMVectorMultiply(a.b[i][2], rv.b[2][j])));
+
+        // sort the columns by length, largest first, keeping V a rotation
+        XMVECTOR rho[3];
+        for (int j = 0; j < 3; ++j)
+            rho[j] = XMVectorMultiplyAdd(b.b[0][j], b.b[0][j], XMVectorMultiplyAdd(b.b[1][j], b.b[1][j], XMVectorMultiply(b.b[2][j], b.b[2][j])));
+        const int swaps[3][4] = { { 0, 1, 2, 1 }, { 0, 2, 1, -1 }, { 1, 2, 0, 1 } }; // columns i and j, axis, sign of the quarter turn
+        for (const auto& swap : swaps)
+        {
+            const int i = swap[0], j = swap[1];
+            const XMVECTOR control = XMVectorLess(rho[i], rho[j]);
+            for (int row = 0; row < 3; ++row)
+                NegateSwap(b.b[row][i], b.b[row][j], control);
+            SwapColumns(v, swap[2], static_cast<float>(swap[3]), control);
+            Swap(rho[i], rho[j], control);
+        }
+
+        // QR of B by Givens rotations (2, 1), (3, 1), (3, 2); U = Q1 Q2 Q3, R is diagonal up to round off
+        XMVECTOR ch1, sh1, ch2, sh2, ch3, sh3;
+        QRGivens(b.b[0][0], b.b[1][0], ch1, sh1);
+        ApplyGivens(b, 0, 1, ch1, sh1);
+        QRGivens(b.b[0][0], b.b[2][0], ch2, sh2);
+        ApplyGivens(b, 0, 2, ch2, sh2);
+        QRGivens(b.b[1][1], b.b[2][1], ch3, sh3);
+        ApplyGivens(b, 1, 2, ch3, sh3);
+        const XMVECTOR zero = XMVectorZero();
+        const Quat4 q1 = { zero, zero, sh1, ch1 };
+        const Quat4 q2 = { zero, XMVectorNegate(sh2), zero, ch2 };
+        const Quat4 q3 = { sh3, zero, zero, ch3 };
+        u = Normalize(Multiply(Multiply(q1, q2), q3));
+        sigma[0] = b.b[0][0];
+        sigma[1] = b.b[1][1];
+        sigma[2] = b.b[2][2];
+    }
+
+    // four matrices, lanes past count repeat the last one
+    inline Matrix4 LoadMatrices(const XMFLOAT3X3* matrices, const size_t count)
+    {
+        const XMFLOAT3X3* m[4];
+        for (size_t lane = 0; lane < 4; ++lane)
+            m[lane] = matrices + (lane < count ? lane : count - 1);
+        Matrix4 out;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                out.b[i][j] = XMVectorSet(m[0]->m[i][j], m[1]->m[i][j], m[2]->m[i][j], m[3]->m[i][j]);
+        return out;
+    }
+
+    inline void StoreQuaternions(const Quat4& q, Quaternion* out, const size_t count)
+    {
+        const XMMATRIX t = XMMatrixTranspose(XMMATRIX(q.x, q.y, q.z, q.w));
+        for (size_t lane = 0; lane < count && lane < 4; ++lane)
+            out[lane] = Quaternion(t.r[lane]);
+    }
+
+    inline void StorePoints(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, FloatPoint3* out, const size_t count)
+    {
+        const XMMATRIX t = XMMatrixTranspose(XMMATRIX(x, y, z, XMVectorZero()));
+        for (size_t lane = 0; lane < count && lane < 4; ++lane)
+            out[lane] = FloatPoint3(t.r[lane]);
+    }
+}
+
+/******************************************************************************
+*   SVD3
+******************************************************************************/
+void King::SVD3::Decompose(const XMFLOAT3X3* matrices, Quaternion* uOut, FloatPoint3* sigmaOut, Quaternion* vOut, size_t count)
+{
+    KING_MATH_COUNT("SVD3::Decompose(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        Quat4 u, v;
+        XMVECTOR sigma[3];
+        Decompose4(LoadMatrices(matrices + i, count - i), u, sigma, v);
+        if (uOut)
+            StoreQuaternions(u, uOut + i, count - i);
+        if (sigmaOut)
+            StorePoints(sigma[0], sigma[1], sigma[2], sigmaOut + i, count - i);
+        if (vOut)
+            StoreQuaternions(v, vOut + i, count - i);
+    }
+}
+
+void King::SVD3::Polar(const XMFLOAT3X3* matrices, Quaternion* rotationsOut, size_t count)
+{
+    KING_MATH_COUNT("SVD3::Polar(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        Quat4 u, v;
+        XMVECTOR sigma[3];
+        Decompose4(LoadMatrices(matrices + i, count - i), u, sigma, v);
+        StoreQuaternions(Normalize(Multiply(u, Conjugate(v))), rotationsOut + i, count - i);
+    }
+}
+
+void King::SVD3::SymmetricEigen(const FloatPoint3* diagonals, const FloatPoint3* uppers, Quaternion* vectorsOut, FloatPoint3* valuesOut, size_t count)
+{
+    KING_MATH_COUNT("SVD3::SymmetricEigen(batch)", count);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const size_t lanes = std::min<size_t>(4, count - i);
+        XMVECTOR d[4], e[4];
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            const size_t k = i + (lane < lanes ? lane : lanes - 1);
+            d[lane] = diagonals[k];
+            e[lane] = uppers[k];
+        }
+        const XMMATRIX dt = XMMatrixTranspose(XMMATRIX(d[0], d[1], d[2], d[3]));
+        const XMMATRIX et = XMMatrixTranspose(XMMATRIX(e[0], e[1], e[2], e[3]));
+        Symmetric4 s = { dt.r[0], et.r[0], dt.r[1], et.r[1], et.r[2], dt.r[2] };
+        Quat4 v = JacobiEigen(s);
+
+        // after whole sweeps the diagonal is back in order; sort it largest first with the columns
+        XMVECTOR values[3] = { s.s11, s.s22, s.s33 };
+        const int swaps[3][4] = { { 0, 1, 2, 1 }, { 0, 2, 1, -1 }, { 1, 2, 0, 1 } };
+        for (const auto& swap : swaps)
+        {
+            const XMVECTOR control = XMVectorLess(values[swap[0]], values[swap[1]]);
+            SwapColumns(v, swap[2], static_cast<float>(swap[3]), control);
+            Swap(values[swap[0]], values[swap[1]], control);
+        }
+        if (vectorsOut)
+            StoreQuaternions(v, vectorsOut + i, lanes);
+        if (valuesOut)
+            StorePoints(values[0], values[1], values[2], valuesOut + i, lanes);
+    }
+}
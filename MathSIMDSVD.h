@@ -0,0 +1,71 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDSVD
+
+Description:    Batched 3x3 singular value and polar decomposition, and the
+                symmetric eigen solver under it, for shape matching, FEM and
+                point set registration that need thousands per frame.  Four
+                matrices run at once, one per SIMD lane, through the branch
+                free algorithm of McAdams, Selle, Tamstorf, Teran and Sifakis
+                (Computing the Singular Value Decomposition of 3x3 matrices
+                with minimal branching and elementary floating point
+                operations, 2011): six sweeps of approximate Jacobi rotations
+                on AᵀA accumulated as a quaternion, the columns sorted, then a
+                Givens QR.  Rotations are returned as Quaternion.
+
+                    std::vector<DirectX::XMFLOAT3X3> deformation = ...; // one per element
+                    std::vector<King::Quaternion> rotations(deformation.size());
+                    King::SVD3::Polar(deformation.data(), rotations.data(), deformation.size());
+
+                Matrices are read as m[row][column] acting on column vectors,
+                A = U * diag(sigma) * Vᵀ, with U and V the rotations
+                XMVector3Rotate applies (XMMatrixRotationQuaternion gives their
+                transpose, the row vector form).  Sigma is sorted by magnitude,
+                largest first, and only the last one is negative when det(A) is,
+                so U and V are always proper rotations.  Polar returns R = U Vᵀ
+                of A = R S, the rotation closest to A.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   SVD3
+    ******************************************************************************/
+    class SVD3
+    {
+        /* methods */
+    public:
+        // Statics
+        static void                             Decompose(const DirectX::XMFLOAT3X3* matrices, Quaternion* uOut, FloatPoint3* sigmaOut, Quaternion* vOut, size_t count); // batch, 4 wide, outputs may be null
+        static void                             Polar(const DirectX::XMFLOAT3X3* matrices, Quaternion* rotationsOut, size_t count); // batch, 4 wide
+        static void                             SymmetricEigen(const FloatPoint3* diagonals, const FloatPoint3* uppers, Quaternion* vectorsOut, FloatPoint3* valuesOut, size_t count); // batch, 4 wide, diagonal xx, yy, zz and upper xy, xz, yz; eigenvectors are the columns of the rotation, values largest first
+        static inline void                      Decompose(const DirectX::XMFLOAT3X3& matrix, Quaternion& uOut, FloatPoint3& sigmaOut, Quaternion& vOut) { Decompose(&matrix, &uOut, &sigmaOut, &vOut, 1); }
+        static inline Quaternion                Polar(const DirectX::XMFLOAT3X3& matrix) { Quaternion r; Polar(&matrix, &r, 1); return r; }
+    };
+}
@@ -0,0 +1,265 @@
+﻿#include "MathSIMDStatistics.h"
+#include "MathSIMDInstrument.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    const size_t BlockSize = 256; // points per block, 8 KB of FloatPoint3 stays in L1 for the second pass
+
+    inline DirectX::XMVECTOR __vectorcall LoadXYZ(const FloatPoint3& point) { return DirectX::XMVectorSelect(DirectX::XMVectorZero(), point, DirectX::g_XMSelect1110); }
+    inline DirectX::XMVECTOR __vectorcall OuterUpper(DirectX::FXMVECTOR a, DirectX::FXMVECTOR b) { return DirectX::XMVectorMultiply(DirectX::XMVectorSwizzle<0, 0, 1, 3>(a), DirectX::XMVectorSwizzle<1, 2, 2, 3>(b)); } // xy, xz, yz, ww
+
+    // mean and summed outer products of the deviations of load(0) to load(count - 1), two passes while they are cached
+    template<class Load>
+    void BlockMoments(Load&& load, const size_t count, DirectX::XMVECTOR& meanOut, DirectX::XMVECTOR& diagonalOut, DirectX::XMVECTOR& upperOut)
+    {
+        using namespace DirectX;
+        XMVECTOR sum0 = XMVectorZero();
+        XMVECTOR sum1 = XMVectorZero();
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            sum0 = XMVectorAdd(sum0, load(i));
+            sum1 = XMVectorAdd(sum1, load(i + 1));
+        }
+        if (i < count)
+            sum0 = XMVectorAdd(sum0, load(i));
+        meanOut = XMVectorScale(XMVectorAdd(sum0, sum1), 1.0f / count);
+
+        XMVECTOR diagonal0 = XMVectorZero(), diagonal1 = XMVectorZero();
+        XMVECTOR upper0 = XMVectorZero(), upper1 = XMVectorZero();
+        for (i = 0; i + 2 <= count; i += 2)
+        {
+            const XMVECTOR d0 = XMVectorSubtract(load(i), meanOut);
+            const XMVECTOR d1 = XMVectorSubtract(load(i + 1), meanOut);
+            diagonal0 = XMVectorMultiplyAdd(d0, d0, diagonal0);
+            diagonal1 = XMVectorMultiplyAdd(d1, d1, diagonal1);
+            upper0 = XMVectorAdd(upper0, OuterUpper(d0, d0));
+            upper1 = XMVectorAdd(upper1, OuterUpper(d1, d1));
+        }
+        if (i < count)
+        {
+            const XMVECTOR d = XMVectorSubtract(load(i), meanOut);
+            diagonal0 = XMVectorMultiplyAdd(d, d, diagonal0);
+            upper0 = XMVectorAdd(upper0, OuterUpper(d, d));
+        }
+        diagonalOut = XMVectorAdd(diagonal0, diagonal1);
+        upperOut = XMVectorAdd(upper0, upper1);
+    }
+}
+
+/******************************************************************************
+*   Covariance3
+******************************************************************************/
+void __vectorcall King::Covariance3::Add(const FloatPoint3 point)
+{
+    using namespace DirectX;
+    const XMVECTOR p = LoadXYZ(point);
+    ++count;
+    const XMVECTOR delta = XMVectorSubtract(p, mean);
+    mean = XMVectorAdd(mean, XMVectorScale(delta, 1.0f / count));
+    const XMVECTOR delta2 = XMVectorSubtract(p, mean);
+    diagonal = XMVectorMultiplyAdd(delta, delta2, diagonal);
+    upper = XMVectorAdd(upper, OuterUpper(delta, delta2));
+}
+
+void King::Covariance3::Add(const FloatPoint3* points, size_t countIn)
+{
+    KING_MATH_COUNT("Covariance3::Add(batch)", countIn);
+    for (size_t first = 0; first < countIn; first += BlockSize)
+    {
+        DirectX::XMVECTOR blockMean, blockDiagonal, blockUpper;
+        const size_t n = std::min(BlockSize, countIn - first);
+        BlockMoments([points, first](size_t i) { return LoadXYZ(points[first + i]); }, n, blockMean, blockDiagonal, blockUpper);
+        Merge(blockMean, blockDiagonal, blockUpper, n);
+    }
+}
+
+void King::Covariance3::Add(const FloatPoint3* points, const uint32_t* indices, size_t countIn)
+{
+    KING_MATH_COUNT("Covariance3::Add(batch)", countIn);
+    for (size_t first = 0; first < countIn; first += BlockSize)
+    {
+        DirectX::XMVECTOR blockMean, blockDiagonal, blockUpper;
+        const size_t n = std::min(BlockSize, countIn - first);
+        BlockMoments([points, indices, first](size_t i) { return LoadXYZ(points[indices[first + i]]); }, n, blockMean, blockDiagonal, blockUpper);
+        Merge(blockMean, blockDiagonal, blockUpper, n);
+    }
+}
+
+void King::Covariance3::Merge(const Covariance3& in)
+{
+    Merge(in.mean, in.diagonal, in.upper, in.count);
+}
+
+// pairwise update of Chan, Golub and LeVeque; the cross term is the outer product of the difference of the means
+void __vectorcall King::Covariance3::Merge(DirectX::FXMVECTOR meanIn, DirectX::FXMVECTOR diagonalIn, DirectX::FXMVECTOR upperIn, size_t countIn)
+{
+    using namespace DirectX;
+    if (countIn == 0)
+        return;
+    if (count == 0)
+    {
+        mean = meanIn;
+        diagonal = diagonalIn;
+        upper = upperIn;
+        count = countIn;
+        return;
+    }
+    const size_t total = count + countIn;
+    const XMVECTOR delta = XMVectorSubtract(meanIn, mean);
+    const XMVECTOR scaled = XMVectorScale(delta, static_cast<float>(double(count) * double(countIn) / double(total)));
+    mean = XMVectorAdd(mean, XMVectorScale(delta, static_cast<float>(double(countIn) / double(total))));
+    diagonal = XMVectorAdd(XMVectorAdd(diagonal, diagonalIn), XMVectorMultiply(delta, scaled));
+    upper = XMVectorAdd(XMVectorAdd(upper, upperIn), OuterUpper(delta, scaled));
+    count = total;
+}
+
+Eigen3 King::Covariance3::GetEigen() const
+{
+    return SymmetricEigen(GetVariance(), GetCovariance());
+}
+
+FloatPoint4 King::Covariance3::GetPlane() const
+{
+    using namespace DirectX;
+    const XMVECTOR normal = GetEigen().vectors[2];
+    return FloatPoint4(XMVectorSetW(normal, -XMVectorGetX(XMVector3Dot(normal, mean))));
+}
+
+FloatPoint3 King::Covariance3::GetLineDirection() const
+{
+    return GetEigen().vectors[0];
+}
+
+float King::Covariance3::Get(const int row, const int column) const
+{
+    assert(row >= 0 && row < 3 && column >= 0 && column < 3);
+    if (count == 0)
+        return 0.0f;
+    const float sum = row == column ? DirectX::XMVectorGetByIndex(diagonal, row) : DirectX::XMVectorGetByIndex(upper, row + column - 1);
+    return sum / count;
+}
+
+DirectX::XMMATRIX King::Covariance3::GetMatrix() const
+{
+    using namespace DirectX;
+    const XMVECTOR d = GetVariance();
+    const XMVECTOR u = GetCovariance();
+    const XMVECTOR row0 = XMVectorPermute<0, 4, 5, 3>(d, u); // xx, xy, xz, 0
+    const XMVECTOR row1 = XMVectorPermute<4, 1, 6, 3>(d, u); // xy, yy, yz, 0
+    const XMVECTOR row2 = XMVectorPermute<5, 6, 2, 3>(d, u); // xz, yz, zz, 0
+    return XMMATRIX(row0, row1, row2, XMVectorZero());
+}
+
+// cyclic Jacobi rotations zeroing xy, xz and yz in turn (Golub and Van Loan 8.5); the rotations are applied to the
+// eigenvector columns four floats at a time and a 3x3 converges in three or four sweeps
+Eigen3 __vectorcall King::Covariance3::SymmetricEigen(DirectX::FXMVECTOR diagonalIn, DirectX::FXMVECTOR upperIn)
+{
+    using namespace DirectX;
+    float a[3][3];
+    a[0][0] = XMVectorGetX(diagonalIn);
+    a[1][1] = XMVectorGetY(diagonalIn);
+    a[2][2] = XMVectorGetZ(diagonalIn);
+    a[0][1] = a[1][0] = XMVectorGetX(upperIn);
+    a[0][2] = a[2][0] = XMVectorGetY(upperIn);
+    a[1][2] = a[2][1] = XMVectorGetZ(upperIn);
+    XMVECTOR v[3] = { g_XMIdentityR0, g_XMIdentityR1, g_XMIdentityR2 };
+
+    const float epsilon = std::numeric_limits<float>::epsilon();
+    const float norm = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2] + 2.0f * (a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2]);
+    const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+    for (int sweep = 0; sweep < 16; ++sweep)
+    {
+        const float off = 2.0f * (a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2]);
+        if (off <= epsilon * epsilon * norm)
+            break;
+        for (const auto& pair : pairs)
+        {
+            const int p = pair[0], q = pair[1], r = 3 - p - q;
+            const float apq = a[p][q];
+            if (apq == 0.0f)
+                continue;
+            const float theta = (a[q][q] - a[p][p]) / (2.0f * apq);
+            const float t = std::copysign(1.0f, theta) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0f)); // tan, the smaller rotation
+            const float c = 1.0f / std::sqrt(t * t + 1.0f);
+            const float s = t * c;
+            a[p][p] -= t * apq;
+            a[q][q] += t * apq;
+            a[p][q] = a[q][p] = 0.0f;
+            const float arp = a[r][p], arq = a[r][q];
+            a[r][p] = a[p][r] = c * arp - s * arq;
+            a[r][q] = a[q][r] = s * arp + c * arq;
+            const XMVECTOR vp = v[p], vq = v[q];
+            v[p] = XMVectorSubtract(XMVectorScale(vp, c), XMVectorScale(vq, s));
+            v[q] = XMVectorAdd(XMVectorScale(vp, s), XMVectorScale(vq, c));
+        }
+    }
+
+    int order[3] = { 0, 1, 2 };
+    std::sort(order, order + 3, [&a](int i, int j) { return a[i][i] > a[j][j]; });
+    Eigen3 out;
+    out.values = FloatPoint3(a[order[0]][order[0]], a[order[1]][order[1]], a[order[2]][order[2]]);
+    out.vectors[0] = FloatPoint3(v[order[0]]);
+    out.vectors[1] = FloatPoint3(v[order[1]]);
+    out.vectors[2] = FloatPoint3(XMVector3Cross(v[order[0]], v[order[1]]));
+    return out;
+}
+
+void King::Covariance3::FitLine(const FloatPoint3* points, size_t countIn, FloatPoint3& originOut, FloatPoint3& directionOut)
+{
+    const Covariance3 covariance(points, countIn);
+    originOut = covariance.GetMean();
+    directionOut = covariance.GetLineDirection();
+}
+
+OrientedBox3 King::Covariance3::FitOrientedBox(const FloatPoint3* points, size_t countIn)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("Covariance3::FitOrientedBox(batch)", countIn);
+    OrientedBox3 box;
+    const Covariance3 covariance(points, countIn);
+    const Eigen3 eigen = covariance.GetEigen();
+    const XMVECTOR mean = covariance.mean;
+    const XMMATRIX axes(eigen.vectors[0], eigen.vectors[1], eigen.vectors[2], g_XMIdentityR3);
+    const XMMATRIX toLocal = XMMatrixTranspose(axes); // rows are the axes, transposed so a transform dots with each
+    XMVECTOR lo = XMVectorReplicate(std::numeric_limits<float>::max());
+    XMVECTOR hi = XMVectorNegate(lo);
+    for (size_t i = 0; i < countIn; ++i)
+    {
+        // relative to the mean so coordinates far from the origin keep their low bits
+        const XMVECTOR local = XMVector3TransformNormal(XMVectorSubtract(points[i], mean), toLocal);
+        lo = XMVectorMin(lo, local);
+        hi = XMVectorMax(hi, local);
+    }
+    for (int k = 0; k < 3; ++k)
+        box.axes[k] = eigen.vectors[k];
+    if (countIn == 0)
+    {
+        box.center = FloatPoint3(XMVectorZero());
+        box.extents = FloatPoint3(XMVectorZero());
+        return box;
+    }
+    const XMVECTOR centerLocal = XMVectorScale(XMVectorAdd(lo, hi), 0.5f);
+    const XMVECTOR center = XMVectorAdd(XMVector3TransformNormal(centerLocal, axes), mean);
+    // far from the origin the float center rounds by up to half an ulp of the coordinates, the extents grow by that shift
+    const XMVECTOR shift = XMVectorAbs(XMVectorSubtract(XMVector3TransformNormal(XMVectorSubtract(center, mean), toLocal), centerLocal));
+    box.center = FloatPoint3(center);
+    box.extents = FloatPoint3(XMVectorAdd(XMVectorScale(XMVectorSubtract(hi, lo), 0.5f), shift));
+    return box;
+}
+
+void King::Covariance3::FitPlanes(const FloatPoint3* points, const uint32_t* offsets, const uint32_t* neighbors, size_t countIn, FloatPoint4* planesOut)
+{
+    KING_MATH_COUNT("Covariance3::FitPlanes(batch)", countIn);
+    for (size_t i = 0; i < countIn; ++i)
+        planesOut[i] = Covariance3(points, neighbors + offsets[i], offsets[i + 1] - offsets[i]).GetPlane();
+}
@@ -0,0 +1,118 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDStatistics
+
+Description:    Second order statistics of FloatPoint3 arrays, the Average
+                helpers taken one step further: mean and 3x3 covariance, its
+                eigen decomposition by cyclic Jacobi rotations, principal
+                axes, best-fit planes and lines and oriented bounding boxes.
+                Oriented boxes and surface normals from point neighborhoods are
+                computed millions of times, so the covariance is accumulated
+                in one pass over memory: blocks of points small enough to stay
+                in L1 are summed for their mean, then their deviations, and the
+                blocks are merged (Chan et al.) so large coordinates far from
+                the origin do not cancel.
+
+                    King::Covariance3 covariance(points.data(), points.size());
+                    King::Eigen3 eigen = covariance.GetEigen();
+                    King::FloatPoint4 plane = covariance.GetPlane();
+                    King::OrientedBox3 box = King::Covariance3::FitOrientedBox(points.data(), points.size());
+
+                    std::vector<King::FloatPoint4> planes(points.size());
+                    King::Covariance3::FitPlanes(points.data(), offsets.data(), neighbors.data(), points.size(), planes.data());
+
+                Covariance is the population covariance (divided by the count).
+                Plane and line directions have no preferred sign; orient normals
+                against a view point or a neighbor when it matters.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   Eigen3
+    *       Eigen decomposition of a symmetric 3x3
+    ******************************************************************************/
+    struct alignas(16) Eigen3
+    {
+        FloatPoint3                             values;     // largest first
+        FloatPoint3                             vectors[3]; // unit columns for values x, y, z; right handed, vectors[2] = vectors[0] x vectors[1]
+    };
+    /******************************************************************************
+    *   OrientedBox3
+    ******************************************************************************/
+    struct alignas(16) OrientedBox3
+    {
+        FloatPoint3                             center;
+        FloatPoint3                             axes[3];    // unit, right handed, axis of largest variance first
+        FloatPoint3                             extents;    // half sizes along the axes
+    };
+    /******************************************************************************
+    *   Covariance3
+    *       Running mean and summed outer products of the deviations
+    ******************************************************************************/
+    class alignas(16) Covariance3
+    {
+        /* variables */
+    private:
+        DirectX::XMVECTOR                       mean;       // x, y, z, 0
+        DirectX::XMVECTOR                       diagonal;   // summed squared deviations xx, yy, zz, 0
+        DirectX::XMVECTOR                       upper;      // summed products of deviations xy, xz, yz, 0
+        size_t                                  count;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        inline Covariance3() noexcept : mean(DirectX::XMVectorZero()), diagonal(DirectX::XMVectorZero()), upper(DirectX::XMVectorZero()), count(0) {}
+        inline Covariance3(const FloatPoint3* points, size_t countIn) : Covariance3() { Add(points, countIn); }
+        inline Covariance3(const FloatPoint3* points, const uint32_t* indices, size_t countIn) : Covariance3() { Add(points, indices, countIn); }
+        // Functionality
+        void __vectorcall                       Add(const FloatPoint3 point); // Welford update
+        void                                    Add(const FloatPoint3* points, size_t countIn); // one pass, blocks merged
+        void                                    Add(const FloatPoint3* points, const uint32_t* indices, size_t countIn); // one pass over points[indices[i]]
+        void                                    Merge(const Covariance3& in);
+        Eigen3                                  GetEigen() const; // zero covariance gives the identity vectors
+        FloatPoint4                             GetPlane() const; // unit normal of least variance through the mean, w = -dot(normal, mean)
+        FloatPoint3                             GetLineDirection() const; // unit direction of largest variance, the line passes through the mean
+        // Accessors
+        inline size_t                           GetCount() const { return count; }
+        inline FloatPoint3                      GetMean() const { return FloatPoint3(mean); }
+        inline FloatPoint3                      GetVariance() const { return FloatPoint3(count ? DirectX::XMVectorScale(diagonal, 1.0f / count) : DirectX::XMVectorZero()); } // xx, yy, zz
+        inline FloatPoint3                      GetCovariance() const { return FloatPoint3(count ? DirectX::XMVectorScale(upper, 1.0f / count) : DirectX::XMVectorZero()); } // xy, xz, yz
+        float                                   Get(const int row, const int column) const;
+        DirectX::XMMATRIX                       GetMatrix() const; // 3x3 in the upper left, zero elsewhere
+        // Statics
+        static Eigen3 __vectorcall              SymmetricEigen(DirectX::FXMVECTOR diagonalIn, DirectX::FXMVECTOR upperIn); // diagonal xx, yy, zz and upper xy, xz, yz
+        static inline FloatPoint4               FitPlane(const FloatPoint3* points, size_t countIn) { return Covariance3(points, countIn).GetPlane(); }
+        static void                             FitLine(const FloatPoint3* points, size_t countIn, FloatPoint3& originOut, FloatPoint3& directionOut);
+        static OrientedBox3                     FitOrientedBox(const FloatPoint3* points, size_t countIn); // principal axes, extents from a second pass
+        static void                             FitPlanes(const FloatPoint3* points, const uint32_t* offsets, const uint32_t* neighbors, size_t countIn, FloatPoint4* planesOut); // batch, neighborhood i is neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1]
+    private:
+        void __vectorcall                       Merge(DirectX::FXMVECTOR meanIn, DirectX::FXMVECTOR diagonalIn, DirectX::FXMVECTOR upperIn, size_t countIn);
+    };
+}
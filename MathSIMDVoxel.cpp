@@ -0,0 +1,556 @@
+﻿#include "MathSIMDVoxel.h"
+#include "MathSIMDInstrument.h"
+#include "MathSIMDRasterizer.h"
+#include "MathSIMDParallel.h"
+#include <algorithm>
+#include <limits>
+
+using namespace King;
+using namespace std;
+
+/******************************************************************************
+*   Helpers
+******************************************************************************/
+namespace
+{
+    inline uint32_t VertexIndex(const uint32_t* indices, size_t triangle, int corner) { return indices ? indices[3 * triangle + corner] : static_cast<uint32_t>(3 * triangle + corner); }
+
+    inline size_t HardwareThreads(const size_t threads) { return threads ? threads : std::max<size_t>(1, SystemInfo::GetLogicalProcessorCount()); }
+
+    // closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+    DirectX::XMVECTOR __vectorcall ClosestPointTriangle(DirectX::FXMVECTOR p, DirectX::FXMVECTOR a, DirectX::FXMVECTOR b, DirectX::GXMVECTOR c)
+    {
+        using namespace DirectX;
+        const XMVECTOR ab = XMVectorSubtract(b, a);
+        const XMVECTOR ac = XMVectorSubtract(c, a);
+        const XMVECTOR ap = XMVectorSubtract(p, a);
+        const float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+        const float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+        if (d1 <= 0.0f && d2 <= 0.0f)
+            return a;
+        const XMVECTOR bp = XMVectorSubtract(p, b);
+        const float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+        const float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+        if (d3 >= 0.0f && d4 <= d3)
+            return b;
+        const float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return XMVectorMultiplyAdd(ab, XMVectorReplicate(d1 / (d1 - d3)), a);
+        const XMVECTOR cp = XMVectorSubtract(p, c);
+        const float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+        const float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+        if (d6 >= 0.0f && d5 <= d6)
+            return c;
+        const float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return XMVectorMultiplyAdd(ac, XMVectorReplicate(d2 / (d2 - d6)), a);
+        const float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return XMVectorMultiplyAdd(XMVectorSubtract(c, b), XMVectorReplicate((d4 - d3) / ((d4 - d3) + (d5 - d6))), b);
+        const float denominator = 1.0f / (va + vb + vc);
+        return XMVectorAdd(a, XMVectorAdd(XMVectorScale(ab, vb * denominator), XMVectorScale(ac, vc * denominator)));
+    }
+
+    // voxel range [lo, hi] covered by the coordinate range, clamped to [0, dimension)
+    inline void VoxelRange(const float minimum, const float maximum, const int32_t dimension, int32_t& lo, int32_t& hi)
+    {
+        lo = std::max(0, static_cast<int32_t>(std::floor(minimum)));
+        hi = std::min(dimension - 1, static_cast<int32_t>(std::floor(maximum)));
+    }
+
+    // candidate closest points of 4 voxels [x, x + 4) of a row, lanes outside [0, width) are at infinity
+    inline void LoadSeeds4(const float* sx, const float* sy, const float* sz, const int32_t x, const int32_t width, DirectX::XMVECTOR& cx, DirectX::XMVECTOR& cy, DirectX::XMVECTOR& cz)
+    {
+        if (x >= 0 && x + 4 <= width)
+        {
+            cx = _mm_loadu_ps(sx + x);
+            cy = _mm_loadu_ps(sy + x);
+            cz = _mm_loadu_ps(sz + x);
+            return;
+        }
+        alignas(16) float lx[4], ly[4], lz[4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const bool inside = x + lane >= 0 && x + lane < width;
+            lx[lane] = inside ? sx[x + lane] : std::numeric_limits<float>::infinity();
+            ly[lane] = inside ? sy[x + lane] : std::numeric_limits<float>::infinity();
+            lz[lane] = inside ? sz[x + lane] : std::numeric_limits<float>::infinity();
+        }
+        cx = _mm_load_ps(lx);
+        cy = _mm_load_ps(ly);
+        cz = _mm_load_ps(lz);
+    }
+}
+
+/******************************************************************************
+*   VoxelGrid
+******************************************************************************/
+King::VoxelGrid::VoxelGrid(const IntPoint3 dimensionsIn, const FloatPoint3 originIn, const float voxelSizeIn) :
+    dimensions(std::max(1, dimensionsIn.GetX()), std::max(1, dimensionsIn.GetY()), std::max(1, dimensionsIn.GetZ())),
+    origin(originIn),
+    voxelSize(voxelSizeIn),
+    voxels(size_t(dimensions.GetX()) * dimensions.GetY() * dimensions.GetZ(), 0)
+{
+    assert(voxelSize > 0.0f);
+}
+
+King::VoxelGrid King::VoxelGrid::Bounds(const FloatPoint3* vertices, size_t vertexCount, const float voxelSize, const int32_t padding)
+{
+    using namespace DirectX;
+    assert(voxelSize > 0.0f);
+    XMVECTOR lo = vertexCount ? vertices[0].GetVecConst() : XMVectorZero();
+    XMVECTOR hi = lo;
+    for (size_t i = 1; i < vertexCount; ++i)
+    {
+        lo = XMVectorMin(lo, vertices[i]);
+        hi = XMVectorMax(hi, vertices[i]);
+    }
+    const XMVECTOR pad = XMVectorReplicate(padding * voxelSize);
+    lo = XMVectorSubtract(lo, pad);
+    const XMVECTOR cells = XMVectorCeiling(XMVectorDivide(XMVectorSubtract(XMVectorAdd(hi, pad), lo), XMVectorReplicate(voxelSize)));
+    return VoxelGrid(IntPoint3(std::max(1.0f, XMVectorGetX(cells)), std::max(1.0f, XMVectorGetY(cells)), std::max(1.0f, XMVectorGetZ(cells))), FloatPoint3(lo), voxelSize);
+}
+
+size_t King::VoxelGrid::VoxelizeSurface(const FloatPoint3* vertices, const uint32_t* indices, size_t triangleCount)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("VoxelGrid::VoxelizeSurface", triangleCount);
+    const XMVECTOR scale = XMVectorReplicate(1.0f / voxelSize);
+    const XMVECTOR half = XMVectorReplicate(0.5f);
+    size_t marked = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        // voxel units, voxel (x, y, z) is the unit box at (x, y, z)
+        XMVECTOR v[3];
+        for (int k = 0; k < 3; ++k)
+            v[k] = XMVectorMultiply(XMVectorSubtract(vertices[VertexIndex(indices, t, k)], origin), scale);
+        const XMVECTOR lo = XMVectorMin(v[0], XMVectorMin(v[1], v[2]));
+        const XMVECTOR hi = XMVectorMax(v[0], XMVectorMax(v[1], v[2]));
+        int32_t x0, x1, y0, y1, z0, z1;
+        VoxelRange(XMVectorGetX(lo), XMVectorGetX(hi), dimensions.GetX(), x0, x1);
+        VoxelRange(XMVectorGetY(lo), XMVectorGetY(hi), dimensions.GetY(), y0, y1);
+        VoxelRange(XMVectorGetZ(lo), XMVectorGetZ(hi), dimensions.GetZ(), z0, z1);
+        if (x0 > x1 || y0 > y1 || z0 > z1)
+            continue;
+
+        // separating axes past the box faces: the triangle normal and the 9 edge cross box axis products. An axis
+        // separates box center c when a.c leaves [min(a.v) - r, max(a.v) + r], r the projected box half extent
+        const XMVECTOR edge[3] = { XMVectorSubtract(v[1], v[0]), XMVectorSubtract(v[2], v[1]), XMVectorSubtract(v[0], v[2]) };
+        XMVECTOR axes[10];
+        axes[0] = XMVector3Cross(edge[0], edge[1]);
+        for (int e = 0; e < 3; ++e)
+        {
+            axes[1 + 3 * e] = XMVector3Cross(g_XMIdentityR0, edge[e]);
+            axes[2 + 3 * e] = XMVector3Cross(g_XMIdentityR1, edge[e]);
+            axes[3 + 3 * e] = XMVector3Cross(g_XMIdentityR2, edge[e]);
+        }
+        float ax[10], ay[10], az[10], low[10], high[10];
+        for (int a = 0; a < 10; ++a)
+        {
+            const float p0 = XMVectorGetX(XMVector3Dot(axes[a], v[0]));
+            const float p1 = XMVectorGetX(XMVector3Dot(axes[a], v[1]));
+            const float p2 = XMVectorGetX(XMVector3Dot(axes[a], v[2]));
+            const float r = XMVectorGetX(XMVector3Dot(XMVectorAbs(axes[a]), half));
+            ax[a] = XMVectorGetX(axes[a]);
+            ay[a] = XMVectorGetY(axes[a]);
+            az[a] = XMVectorGetZ(axes[a]);
+            low[a] = std::min({ p0, p1, p2 }) - r;
+            high[a] = std::max({ p0, p1, p2 }) + r;
+        }
+
+        for (int32_t z = z0; z <= z1; ++z)
+        {
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                // a.c = ax * cx + row, 4 voxels along x per step
+                XMVECTOR rowLow[10], rowHigh[10];
+                bool rowSeparated = false;
+                for (int a = 0; a < 10; ++a)
+                {
+                    const float row = ay[a] * (y + 0.5f) + az[a] * (z + 0.5f);
+                    rowLow[a] = XMVectorReplicate(low[a] - row);
+                    rowHigh[a] = XMVectorReplicate(high[a] - row);
+                    if (ax[a] == 0.0f && (row < low[a] || row > high[a]))
+                        rowSeparated = true;
+                }
+                if (rowSeparated)
+                    continue;
+                uint8_t* out = &voxels[GetIndex(0, y, z)];
+                for (int32_t x = x0; x <= x1; x += 4)
+                {
+                    const XMVECTOR cx = XMVectorAdd(XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f), XMVectorReplicate(static_cast<float>(x)));
+                    XMVECTOR overlap = XMVectorTrueInt();
+                    for (int a = 0; a < 10; ++a)
+                    {
+                        const XMVECTOR d = XMVectorScale(cx, ax[a]);
+                        overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorGreaterOrEqual(d, rowLow[a]), XMVectorLessOrEqual(d, rowHigh[a])));
+                    }
+                    int bits = _mm_movemask_ps(overlap);
+                    if (x1 + 1 - x < 4)
+                        bits &= (1 << (x1 + 1 - x)) - 1;
+                    for (int lane = 0; bits; ++lane, bits >>= 1)
+                    {
+                        if (bits & 1)
+                        {
+                            marked += out[x + lane] == 0;
+                            out[x + lane] = 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return marked;
+}
+
+size_t King::VoxelGrid::VoxelizeSolid(const FloatPoint3* vertices, const uint32_t* indices, size_t triangleCount, const size_t threads)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("VoxelGrid::VoxelizeSolid", triangleCount);
+    const int32_t width = dimensions.GetX();
+    const int32_t rows = dimensions.GetY();
+    const float scale = 1.0f / voxelSize;
+
+    // the mesh projected on the y z plane in voxel units, voxel centers fall on pixel centers; the rasterizer fill rule
+    // counts each crossing of a row line once and x at the crossing comes back as the attribute
+    const size_t corners = triangleCount * 3;
+    std::vector<FloatPoint2> projected(corners);
+    std::vector<FloatPoint4> depth(corners);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const XMVECTOR p = XMVectorScale(XMVectorSubtract(vertices[VertexIndex(indices, t, k)], origin), scale);
+            projected[3 * t + k] = FloatPoint2(XMVectorGetY(p), XMVectorGetZ(p));
+            depth[3 * t + k] = XMVectorSplatX(p);
+        }
+    }
+    std::vector<std::vector<float>> crossings(size_t(rows) * dimensions.GetZ());
+    Rasterizer rasterizer(rows, dimensions.GetZ(), 32, HardwareThreads(threads));
+    rasterizer.Rasterize(projected.data(), depth.data(), nullptr, triangleCount, [&crossings, rows](const RasterSpan4& span)
+    {
+        alignas(16) float x[4];
+        _mm_store_ps(x, span.attributes.r[0]);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (span.IsCovered(lane))
+                crossings[size_t(span.y) * rows + span.x + lane].push_back(x[lane]);
+        }
+    });
+
+    // inside between each pair of sorted crossings, an unpaired last crossing (open mesh) is ignored
+    size_t marked = 0;
+    for (size_t row = 0; row < crossings.size(); ++row)
+    {
+        auto& list = crossings[row];
+        std::sort(list.begin(), list.end());
+        uint8_t* out = &voxels[row * width];
+        for (size_t c = 0; c + 1 < list.size(); c += 2)
+        {
+            const int32_t begin = std::max(0, static_cast<int32_t>(std::ceil(list[c] - 0.5f)));
+            const int32_t end = std::min(width, static_cast<int32_t>(std::ceil(list[c + 1] - 0.5f)));
+            for (int32_t x = begin; x < end; ++x)
+            {
+                marked += out[x] == 0;
+                out[x] = 1;
+            }
+        }
+    }
+    return marked;
+}
+
+size_t King::VoxelGrid::GetCount() const
+{
+    return voxels.size() - static_cast<size_t>(std::count(voxels.begin(), voxels.end(), uint8_t(0)));
+}
+
+size_t King::VoxelGrid::GetVoxels(std::vector<IntPoint3>& voxelsOut) const
+{
+    const size_t before = voxelsOut.size();
+    for (int32_t z = 0; z < dimensions.GetZ(); ++z)
+    {
+        for (int32_t y = 0; y < dimensions.GetY(); ++y)
+        {
+            const uint8_t* row = &voxels[GetIndex(0, y, z)];
+            for (int32_t x = 0; x < dimensions.GetX(); ++x)
+            {
+                if (row[x])
+                    voxelsOut.emplace_back(x, y, z);
+            }
+        }
+    }
+    return voxelsOut.size() - before;
+}
+
+IntPoint3 King::VoxelGrid::WorldToVoxel(const FloatPoint3 p) const
+{
+    const DirectX::XMVECTOR cell = DirectX::XMVectorFloor(DirectX::XMVectorScale(DirectX::XMVectorSubtract(p, origin), 1.0f / voxelSize));
+    return IntPoint3(static_cast<int>(DirectX::XMVectorGetX(cell)), static_cast<int>(DirectX::XMVectorGetY(cell)), static_cast<int>(DirectX::XMVectorGetZ(cell)));
+}
+
+/******************************************************************************
+*   SignedDistanceField
+******************************************************************************/
+King::SignedDistanceField::SignedDistanceField(const IntPoint3 dimensionsIn, const FloatPoint3 originIn, const float voxelSizeIn, const size_t threadsIn) :
+    dimensions(std::max(1, dimensionsIn.GetX()), std::max(1, dimensionsIn.GetY()), std::max(1, dimensionsIn.GetZ())),
+    origin(originIn),
+    voxelSize(voxelSizeIn),
+    threads(HardwareThreads(threadsIn)),
+    distances(size_t(dimensions.GetX()) * dimensions.GetY() * dimensions.GetZ(), std::numeric_limits<float>::infinity())
+{
+    assert(voxelSize > 0.0f);
+}
+
+void King::SignedDistanceField::SetThreadCount(const size_t threadsIn)
+{
+    threads = HardwareThreads(threadsIn);
+}
+
+void King::SignedDistanceField::Build(const FloatPoint3* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount)
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("SignedDistanceField::Build", triangleCount);
+    (void)vertexCount;
+    const int32_t width = dimensions.GetX();
+    const int32_t height = dimensions.GetY();
+    const int32_t depth = dimensions.GetZ();
+    const size_t count = distances.size();
+    const float infinity = std::numeric_limits<float>::infinity();
+    const XMVECTOR scale = XMVectorReplicate(1.0f / voxelSize);
+    const XMVECTOR centerOffset = XMVectorAdd(origin, XMVectorReplicate(0.5f * voxelSize));
+
+    // closest points, world space SoA, infinity until found
+    std::vector<float> seeds[2][3];
+    for (auto& buffer : seeds)
+        for (auto& axis : buffer)
+            axis.assign(count, infinity);
+    std::vector<float> best(count, infinity);
+
+    // seed the voxels within 1.5 voxels of a triangle with their exact closest point
+    const float band = 1.5f * voxelSize;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const XMVECTOR a = vertices[VertexIndex(indices, t, 0)];
+        const XMVECTOR b = vertices[VertexIndex(indices, t, 1)];
+        const XMVECTOR c = vertices[VertexIndex(indices, t, 2)];
+        const XMVECTOR lo = XMVectorMultiply(XMVectorSubtract(XMVectorMin(a, XMVectorMin(b, c)), origin), scale);
+        const XMVECTOR hi = XMVectorMultiply(XMVectorSubtract(XMVectorMax(a, XMVectorMax(b, c)), origin), scale);
+        int32_t x0, x1, y0, y1, z0, z1;
+        VoxelRange(XMVectorGetX(lo) - 1.5f, XMVectorGetX(hi) + 1.5f, width, x0, x1);
+        VoxelRange(XMVectorGetY(lo) - 1.5f, XMVectorGetY(hi) + 1.5f, height, y0, y1);
+        VoxelRange(XMVectorGetZ(lo) - 1.5f, XMVectorGetZ(hi) + 1.5f, depth, z0, z1);
+        const XMVECTOR normal = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a)));
+        const bool degenerate = XMVector3Equal(normal, XMVectorZero()) || XMVector3IsNaN(normal);
+        const float nx = degenerate ? 0.0f : XMVectorGetX(normal);
+        const float planeBand = degenerate ? infinity : band;
+        for (int32_t z = z0; z <= z1; ++z)
+        {
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                // plane distance 4 voxels per step, exact closest points only for the voxels in the band
+                const XMVECTOR rowCenter = XMVectorAdd(centerOffset, XMVectorSet(0.0f, y * voxelSize, z * voxelSize, 0.0f));
+                const float row = degenerate ? 0.0f : XMVectorGetX(XMVector3Dot(normal, XMVectorSubtract(XMVectorSelect(rowCenter, XMVectorZero(), g_XMSelect1000), a)));
+                const size_t base = (size_t(z) * height + y) * width;
+                for (int32_t x = x0; x <= x1; x += 4)
+                {
+                    const XMVECTOR cx = XMVectorAdd(XMVectorReplicate(XMVectorGetX(rowCenter)), XMVectorScale(XMVectorAdd(XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f), XMVectorReplicate(static_cast<float>(x))), voxelSize));
+                    const XMVECTOR plane = XMVectorAbs(XMVectorAdd(XMVectorReplicate(row), XMVectorScale(cx, nx)));
+                    int bits = _mm_movemask_ps(XMVectorLessOrEqual(plane, XMVectorReplicate(planeBand)));
+                    if (x1 + 1 - x < 4)
+                        bits &= (1 << (x1 + 1 - x)) - 1;
+                    for (int lane = 0; bits; ++lane, bits >>= 1)
+                    {
+                        if (!(bits & 1))
+                            continue;
+                        const int32_t xi = x + lane;
+                        const XMVECTOR p = XMVectorSetX(rowCenter, XMVectorGetX(rowCenter) + xi * voxelSize);
+                        const XMVECTOR q = ClosestPointTriangle(p, a, b, c);
+                        const float d = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(q, p)));
+                        if (d < best[base + xi])
+                        {
+                            best[base + xi] = d;
+                            seeds[0][0][base + xi] = XMVectorGetX(q);
+                            seeds[0][1][base + xi] = XMVectorGetY(q);
+                            seeds[0][2][base + xi] = XMVectorGetZ(q);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // jump flooding: each voxel keeps the nearest of its own and 26 neighbors' closest points step voxels away, steps
+    // halving from half the largest dimension to 1 and a final extra step of 1; slices in parallel, 4 voxels per step
+    int32_t largest = std::max({ width, height, depth });
+    std::vector<int32_t> steps;
+    int32_t step = 1;
+    while (step * 2 < largest)
+        step *= 2;
+    for (; step >= 1; step /= 2)
+        steps.push_back(step);
+    steps.push_back(1);
+    int source = 0;
+    for (const int32_t jump : steps)
+    {
+        const auto& in = seeds[source];
+        auto& out = seeds[source ^ 1];
+        ParallelItems(size_t(depth), threads, [&, jump](size_t zi)
+        {
+            const int32_t z = static_cast<int32_t>(zi);
+            for (int32_t y = 0; y < height; ++y)
+            {
+                const size_t base = (size_t(z) * height + y) * width;
+                const XMVECTOR py = XMVectorReplicate(XMVectorGetY(centerOffset) + y * voxelSize);
+                const XMVECTOR pz = XMVectorReplicate(XMVectorGetZ(centerOffset) + z * voxelSize);
+                for (int32_t x = 0; x < width; x += 4)
+                {
+                    const XMVECTOR px = XMVectorAdd(XMVectorReplicate(XMVectorGetX(centerOffset)), XMVectorScale(XMVectorAdd(XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f), XMVectorReplicate(static_cast<float>(x))), voxelSize));
+                    XMVECTOR bx, by, bz;
+                    LoadSeeds4(&in[0][base], &in[1][base], &in[2][base], x, width, bx, by, bz);
+                    XMVECTOR dx = XMVectorSubtract(bx, px), dy = XMVectorSubtract(by, py), dz = XMVectorSubtract(bz, pz);
+                    XMVECTOR bestDistance = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+                    for (int32_t oz = -jump; oz <= jump; oz += jump)
+                    {
+                        if (z + oz < 0 || z + oz >= depth)
+                            continue;
+                        for (int32_t oy = -jump; oy <= jump; oy += jump)
+                        {
+                            if (y + oy < 0 || y + oy >= height)
+                                continue;
+                            const size_t neighbor = (size_t(z + oz) * height + (y + oy)) * width;
+                            for (int32_t ox = -jump; ox <= jump; ox += jump)
+                            {
+                                if (ox == 0 && oy == 0 && oz == 0)
+                                    continue;
+                                XMVECTOR cx, cy, cz;
+                                LoadSeeds4(&in[0][neighbor], &in[1][neighbor], &in[2][neighbor], x + ox, width, cx, cy, cz);
+                                dx = XMVectorSubtract(cx, px);
+                                dy = XMVectorSubtract(cy, py);
+                                dz = XMVectorSubtract(cz, pz);
+                                const XMVECTOR distance = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+                                const XMVECTOR nearer = XMVectorLess(distance, bestDistance);
+                                bestDistance = XMVectorSelect(bestDistance, distance, nearer);
+                                bx = XMVectorSelect(bx, cx, nearer);
+                                by = XMVectorSelect(by, cy, nearer);
+                                bz = XMVectorSelect(bz, cz, nearer);
+                            }
+                        }
+                    }
+                    alignas(16) float lx[4], ly[4], lz[4];
+                    _mm_store_ps(lx, bx);
+                    _mm_store_ps(ly, by);
+                    _mm_store_ps(lz, bz);
+                    for (int lane = 0; lane < 4 && x + lane < width; ++lane)
+                    {
+                        out[0][base + x + lane] = lx[lane];
+                        out[1][base + x + lane] = ly[lane];
+                        out[2][base + x + lane] = lz[lane];
+                    }
+                }
+            }
+        });
+        source ^= 1;
+    }
+
+    // distance to the closest point, negative for centers inside the closed mesh
+    VoxelGrid solid(dimensions, origin, voxelSize);
+    solid.VoxelizeSolid(vertices, indices, triangleCount, threads);
+    const uint8_t* inside = solid.GetData();
+    const auto& closest = seeds[source];
+    ParallelItems(size_t(depth), threads, [&](size_t zi)
+    {
+        const int32_t z = static_cast<int32_t>(zi);
+        for (int32_t y = 0; y < height; ++y)
+        {
+            const size_t base = (size_t(z) * height + y) * width;
+            const float py = XMVectorGetY(centerOffset) + y * voxelSize;
+            const float pz = XMVectorGetZ(centerOffset) + z * voxelSize;
+            for (int32_t x = 0; x < width; ++x)
+            {
+                const float dx = closest[0][base + x] - (XMVectorGetX(centerOffset) + x * voxelSize);
+                const float dy = closest[1][base + x] - py;
+                const float dz = closest[2][base + x] - pz;
+                const float d = std::sqrt(dx * dx + dy * dy + dz * dz);
+                distances[base + x] = inside[base + x] ? -d : d;
+            }
+        }
+    });
+}
+
+float __vectorcall King::SignedDistanceField::Sample(const FloatPoint3 p) const
+{
+    float d;
+    Sample(&p, &d, 1);
+    return d;
+}
+
+FloatPoint3 __vectorcall King::SignedDistanceField::Gradient(const FloatPoint3 p) const
+{
+    const float h = 0.5f * voxelSize;
+    alignas(16) FloatPoint3 points[6] = { p + FloatPoint3(h, 0.0f, 0.0f), p - FloatPoint3(h, 0.0f, 0.0f), p + FloatPoint3(0.0f, h, 0.0f), p - FloatPoint3(0.0f, h, 0.0f), p + FloatPoint3(0.0f, 0.0f, h), p - FloatPoint3(0.0f, 0.0f, h) };
+    float d[6];
+    Sample(points, d, 6);
+    return FloatPoint3(d[0] - d[1], d[2] - d[3], d[4] - d[5]) / (2.0f * h);
+}
+
+void King::SignedDistanceField::Sample(const FloatPoint3* pointsIn, float* distancesOut, size_t count) const
+{
+    using namespace DirectX;
+    KING_MATH_COUNT("SignedDistanceField::Sample(batch)", count);
+    const int32_t width = dimensions.GetX();
+    const int32_t plane = width * dimensions.GetY();
+    // grid coordinates with voxel centers on integers, clamped so the upper corner stays inside
+    const XMVECTOR offset = XMVectorAdd(origin, XMVectorReplicate(0.5f * voxelSize));
+    const XMVECTOR scale = XMVectorReplicate(1.0f / voxelSize);
+    const XMVECTOR last = XMVectorSet(float(dimensions.GetX() - 1), float(dimensions.GetY() - 1), float(dimensions.GetZ() - 1), 0.0f);
+    const XMVECTOR lastCell = XMVectorMax(XMVectorZero(), XMVectorSubtract(last, g_XMOne));
+    const int32_t stepX = dimensions.GetX() > 1 ? 1 : 0;
+    const int32_t stepY = dimensions.GetY() > 1 ? width : 0;
+    const int32_t stepZ = dimensions.GetZ() > 1 ? plane : 0;
+    for (size_t i = 0; i < count; i += 4)
+    {
+        XMMATRIX g;
+        for (size_t j = 0; j < 4; ++j)
+        {
+            const XMVECTOR p = (i + j < count) ? pointsIn[i + j].GetVecConst() : origin.GetVecConst();
+            g.r[j] = XMVectorClamp(XMVectorMultiply(XMVectorSubtract(p, offset), scale), XMVectorZero(), last);
+        }
+        g = XMMatrixTranspose(g); // rows x, y, z of 4 points
+        XMVECTOR cell[3], f[3];
+        for (int a = 0; a < 3; ++a)
+        {
+            cell[a] = XMVectorMin(XMVectorFloor(g.r[a]), XMVectorReplicate(XMVectorGetByIndex(lastCell, a)));
+            f[a] = XMVectorSubtract(g.r[a], cell[a]);
+        }
+        alignas(16) int32_t ix[4], iy[4], iz[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(ix), _mm_cvttps_epi32(cell[0]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(iy), _mm_cvttps_epi32(cell[1]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(iz), _mm_cvttps_epi32(cell[2]));
+        alignas(16) float corner[8][4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const float* d = &distances[size_t(iz[lane]) * plane + size_t(iy[lane]) * width + ix[lane]];
+            corner[0][lane] = d[0];
+            corner[1][lane] = d[stepX];
+            corner[2][lane] = d[stepY];
+            corner[3][lane] = d[stepY + stepX];
+            corner[4][lane] = d[stepZ];
+            corner[5][lane] = d[stepZ + stepX];
+            corner[6][lane] = d[stepZ + stepY];
+            corner[7][lane] = d[stepZ + stepY + stepX];
+        }
+        XMVECTOR c[8];
+        for (int k = 0; k < 8; ++k)
+            c[k] = _mm_load_ps(corner[k]);
+        const XMVECTOR x00 = XMVectorMultiplyAdd(XMVectorSubtract(c[1], c[0]), f[0], c[0]);
+        const XMVECTOR x10 = XMVectorMultiplyAdd(XMVectorSubtract(c[3], c[2]), f[0], c[2]);
+        const XMVECTOR x01 = XMVectorMultiplyAdd(XMVectorSubtract(c[5], c[4]), f[0], c[4]);
+        const XMVECTOR x11 = XMVectorMultiplyAdd(XMVectorSubtract(c[7], c[6]), f[0], c[6]);
+        const XMVECTOR y0 = XMVectorMultiplyAdd(XMVectorSubtract(x10, x00), f[1], x00);
+        const XMVECTOR y1 = XMVectorMultiplyAdd(XMVectorSubtract(x11, x01), f[1], x01);
+        alignas(16) float result[4];
+        _mm_store_ps(result, XMVectorMultiplyAdd(XMVectorSubtract(y1, y0), f[2], y0));
+        for (size_t j = 0; j < 4 && i + j < count; ++j)
+            distancesOut[i + j] = result[j];
+    }
+}
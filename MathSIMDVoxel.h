@@ -0,0 +1,130 @@
+﻿/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+Title:          MathSIMDVoxel
+
+Description:    Voxelization of FloatPoint3 triangle meshes onto IntPoint3 grids
+                and signed distance fields for collision against static level
+                geometry at load time instead of in an offline tool.
+
+                VoxelGrid marks the voxels a mesh touches with a separating axis
+                test four voxels per step (surface), or the voxels whose center
+                is inside a closed mesh by the parity of crossings along x found
+                with the tiled Rasterizer on the y z plane (solid).
+
+                SignedDistanceField seeds the voxels near the surface with their
+                exact closest point on the mesh, spreads the closest points to
+                the whole grid by jump flooding on worker threads, four voxels
+                per step, and signs the distance with the solid voxelization.
+
+                    auto grid = King::VoxelGrid::Bounds(vertices, vertexCount, 0.25f, 2);
+                    King::SignedDistanceField sdf(grid.GetDimensions(), grid.GetOrigin(), grid.GetVoxelSize());
+                    sdf.Build(vertices, vertexCount, indices, triangleCount);
+                    sdf.Sample(positions, distances, count); // negative inside
+
+                Voxel (x, y, z) spans origin + [x, x + 1) * voxelSize, x fastest
+                in memory; distances are stored at the voxel centers.  Jump
+                flooding with a final step of 1 may pick a closest point a
+                fraction of a voxel off far from the surface; near it the
+                distances are exact.  Signs need a closed mesh.
+
+Contact:        ChrisKing340@gmail.com
+
+MIT License
+
+Copyright (c) 2026 Christopher H. King
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+#pragma once
+
+#include "MathSIMD.h"
+
+namespace King {
+
+    /******************************************************************************
+    *   VoxelGrid
+    *       One byte per voxel, non-zero is solid
+    ******************************************************************************/
+    class VoxelGrid
+    {
+        /* variables */
+    private:
+        IntPoint3                               dimensions;
+        FloatPoint3                             origin;
+        float                                   voxelSize;
+        std::vector<uint8_t>                    voxels;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        VoxelGrid(const IntPoint3 dimensionsIn, const FloatPoint3 originIn, const float voxelSizeIn);
+        static VoxelGrid                        Bounds(const FloatPoint3* vertices, size_t vertexCount, const float voxelSize, const int32_t padding = 1); // encloses the vertices with padding voxels on every side
+        // Functionality
+        size_t                                  VoxelizeSurface(const FloatPoint3* vertices, const uint32_t* indices, size_t triangleCount); // marks voxels a triangle touches, returns the newly marked
+        size_t                                  VoxelizeSolid(const FloatPoint3* vertices, const uint32_t* indices, size_t triangleCount, const size_t threads = 0); // marks voxels with the center inside a closed mesh, returns the newly marked
+        inline void                             Clear() { std::fill(voxels.begin(), voxels.end(), uint8_t(0)); }
+        size_t                                  GetCount() const; // solid voxels
+        size_t                                  GetVoxels(std::vector<IntPoint3>& voxelsOut) const; // appends the solid voxels, x fastest
+        // Accessors
+        inline const IntPoint3&                 GetDimensions() const { return dimensions; }
+        inline const FloatPoint3&               GetOrigin() const { return origin; }
+        inline float                            GetVoxelSize() const { return voxelSize; }
+        inline const uint8_t*                   GetData() const { return voxels.data(); }
+        inline size_t                           GetIndex(const int32_t x, const int32_t y, const int32_t z) const { return (size_t(z) * dimensions.GetY() + y) * dimensions.GetX() + x; }
+        inline bool                             IsInside(const IntPoint3& p) const { return p.GetX() >= 0 && p.GetY() >= 0 && p.GetZ() >= 0 && p.GetX() < dimensions.GetX() && p.GetY() < dimensions.GetY() && p.GetZ() < dimensions.GetZ(); }
+        inline bool                             IsSolid(const int32_t x, const int32_t y, const int32_t z) const { return voxels[GetIndex(x, y, z)] != 0; }
+        inline bool                             IsSolid(const IntPoint3& p) const { return IsInside(p) && IsSolid(p.GetX(), p.GetY(), p.GetZ()); }
+        inline FloatPoint3                      GetCenter(const IntPoint3& p) const { return origin + FloatPoint3(p.GetX() + 0.5f, p.GetY() + 0.5f, p.GetZ() + 0.5f) * voxelSize; }
+        IntPoint3                               WorldToVoxel(const FloatPoint3 p) const; // floor, may be outside the grid
+        // Assignments
+        inline void                             Set(const IntPoint3& p, const bool solid) { assert(IsInside(p)); voxels[GetIndex(p.GetX(), p.GetY(), p.GetZ())] = solid ? 1 : 0; }
+    };
+
+    /******************************************************************************
+    *   SignedDistanceField
+    ******************************************************************************/
+    class SignedDistanceField
+    {
+        /* variables */
+    private:
+        IntPoint3                               dimensions;
+        FloatPoint3                             origin;
+        float                                   voxelSize;
+        size_t                                  threads;
+        std::vector<float>                      distances;
+
+        /* methods */
+    public:
+        // Creation/Life cycle
+        SignedDistanceField(const IntPoint3 dimensionsIn, const FloatPoint3 originIn, const float voxelSizeIn, const size_t threadsIn = 0); // 0 threads is one per logical processor
+        // Functionality
+        void                                    Build(const FloatPoint3* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount); // indices may be null for sequential triangles
+        float __vectorcall                      Sample(const FloatPoint3 p) const; // trilinear, world space, clamped to the border voxel centers
+        FloatPoint3 __vectorcall                Gradient(const FloatPoint3 p) const; // central differences of Sample half a voxel apart, not normalized
+        void                                    Sample(const FloatPoint3* pointsIn, float* distancesOut, size_t count) const; // batch, 4 wide
+        // Accessors
+        inline const IntPoint3&                 GetDimensions() const { return dimensions; }
+        inline const FloatPoint3&               GetOrigin() const { return origin; }
+        inline float                            GetVoxelSize() const { return voxelSize; }
+        inline size_t                           GetThreadCount() const { return threads; }
+        inline const float*                     GetData() const { return distances.data(); }
+        inline float                            Get(const int32_t x, const int32_t y, const int32_t z) const { return distances[(size_t(z) * dimensions.GetY() + y) * dimensions.GetX() + x]; }
+        // Assignments
+        void                                    SetThreadCount(const size_t threadsIn);
+    };
+}